@@ -1,8 +1,11 @@
 // Boruix OS x86_64 GDT (Global Descriptor Table) 实现
-// 创建自己的GDT以支持TSS和双重错误处理
+// 创建自己的GDT以支持TSS和双重错误处理；每个CPU一份，TSS描述符指向各自的TSS
 
 #include "kernel/types.h"
 #include "drivers/display.h"
+#include "arch/tss.h"
+#include "arch/smp.h"
+#include "arch/percpu.h"
 
 // GDT条目结构（标准x86_64格式）
 typedef struct {
@@ -40,8 +43,8 @@ typedef struct {
 // 4: User Data
 // 5: TSS (16字节，占用2个槽位)
 #define GDT_ENTRIES 7
-static gdt_entry_t gdt[GDT_ENTRIES];
-static gdt_ptr_t gdt_ptr;
+static gdt_entry_t gdt[SMP_MAX_CPUS][GDT_ENTRIES];
+static gdt_ptr_t gdt_ptr[SMP_MAX_CPUS];
 
 // TSS选择子（第5项，偏移0x28）
 #define TSS_SELECTOR 0x28
@@ -50,23 +53,22 @@ static gdt_ptr_t gdt_ptr;
 extern void gdt_load(uint64_t gdt_ptr_addr);
 extern void gdt_reload_segments(void);
 extern void tss_load(uint16_t selector);
-extern uint64_t tss_get_base(void);
 
 // 设置标准GDT条目
-static void gdt_set_entry(int num, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran) {
-    gdt[num].base_low = (base & 0xFFFF);
-    gdt[num].base_mid = (base >> 16) & 0xFF;
-    gdt[num].base_high = (base >> 24) & 0xFF;
+static void gdt_set_entry(gdt_entry_t* table, int num, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran) {
+    table[num].base_low = (base & 0xFFFF);
+    table[num].base_mid = (base >> 16) & 0xFF;
+    table[num].base_high = (base >> 24) & 0xFF;
     
-    gdt[num].limit_low = (limit & 0xFFFF);
-    gdt[num].granularity = (limit >> 16) & 0x0F;
-    gdt[num].granularity |= gran & 0xF0;
-    gdt[num].access = access;
+    table[num].limit_low = (limit & 0xFFFF);
+    table[num].granularity = (limit >> 16) & 0x0F;
+    table[num].granularity |= gran & 0xF0;
+    table[num].access = access;
 }
 
 // 设置TSS描述符（16字节）
-static void gdt_set_tss(int num, uint64_t base, uint32_t limit) {
-    tss_descriptor_t* tss_desc = (tss_descriptor_t*)&gdt[num];
+static void gdt_set_tss(gdt_entry_t* table, int num, uint64_t base, uint32_t limit) {
+    tss_descriptor_t* tss_desc = (tss_descriptor_t*)&table[num];
     
     tss_desc->limit_low = limit & 0xFFFF;
     tss_desc->base_low = base & 0xFFFF;
@@ -78,46 +80,46 @@ static void gdt_set_tss(int num, uint64_t base, uint32_t limit) {
     tss_desc->reserved = 0;
 }
 
-// 初始化GDT
-void gdt_init(void) {
-    print_string("[GDT] Initializing Global Descriptor Table...\n");
+// 构建并加载cpu的GDT，重新加载段寄存器和TSS，最后设置GS基址
+static void gdt_setup(uint32_t cpu) {
+    gdt_entry_t* table = gdt[cpu];
     
     // 0: NULL descriptor
-    gdt_set_entry(0, 0, 0, 0, 0);
+    gdt_set_entry(table, 0, 0, 0, 0, 0);
     
     // 1: Kernel Code Segment (64-bit)
     // Base = 0, Limit = 0xFFFFF
     // Access = 0x9A (Present, Ring 0, Code, Execute/Read)
     // Granularity = 0xA0 (64-bit, 4KB pages)
-    gdt_set_entry(1, 0, 0xFFFFF, 0x9A, 0xA0);
+    gdt_set_entry(table, 1, 0, 0xFFFFF, 0x9A, 0xA0);
     
     // 2: Kernel Data Segment
     // Base = 0, Limit = 0xFFFFF
     // Access = 0x92 (Present, Ring 0, Data, Read/Write)
     // Granularity = 0xC0 (32-bit, 4KB pages)
-    gdt_set_entry(2, 0, 0xFFFFF, 0x92, 0xC0);
+    gdt_set_entry(table, 2, 0, 0xFFFFF, 0x92, 0xC0);
     
     // 3: User Code Segment (64-bit)
     // Access = 0xFA (Present, Ring 3, Code, Execute/Read)
     // Granularity = 0xA0 (64-bit, 4KB pages)
-    gdt_set_entry(3, 0, 0xFFFFF, 0xFA, 0xA0);
+    gdt_set_entry(table, 3, 0, 0xFFFFF, 0xFA, 0xA0);
     
     // 4: User Data Segment
     // Access = 0xF2 (Present, Ring 3, Data, Read/Write)
     // Granularity = 0xC0 (32-bit, 4KB pages)
-    gdt_set_entry(4, 0, 0xFFFFF, 0xF2, 0xC0);
+    gdt_set_entry(table, 4, 0, 0xFFFFF, 0xF2, 0xC0);
     
     // 5-6: TSS (16字节，占用2个槽位)
-    uint64_t tss_base = tss_get_base();
+    uint64_t tss_base = tss_get_base_cpu(cpu);
     uint32_t tss_limit = 104 - 1;  // sizeof(tss_t) = 104
-    gdt_set_tss(5, tss_base, tss_limit);
+    gdt_set_tss(table, 5, tss_base, tss_limit);
     
     // 设置GDT指针
-    gdt_ptr.limit = sizeof(gdt) - 1;
-    gdt_ptr.base = (uint64_t)&gdt;
+    gdt_ptr[cpu].limit = sizeof(gdt[cpu]) - 1;
+    gdt_ptr[cpu].base = (uint64_t)table;
     
     // 加载GDT
-    gdt_load((uint64_t)&gdt_ptr);
+    gdt_load((uint64_t)&gdt_ptr[cpu]);
     
     // 重新加载段寄存器
     gdt_reload_segments();
@@ -125,15 +127,30 @@ void gdt_init(void) {
     // 加载TSS
     tss_load(TSS_SELECTOR);
     
+    // 重新加载段寄存器清零了GS基址，指向本CPU的每CPU页
+    percpu_load(cpu);
+}
+
+// 初始化GDT
+void gdt_init(void) {
+    print_string("[GDT] Initializing Global Descriptor Table...\n");
+    
+    gdt_setup(0);
+    
     print_string("[GDT] Global Descriptor Table initialized\n");
     print_string("[GDT] TSS loaded at selector 0x");
     print_hex(TSS_SELECTOR);
     print_string("\n");
 }
 
+// AP初始化GDT（TSS需已由tss_init_cpu准备好）
+void gdt_init_cpu(uint32_t cpu) {
+    gdt_setup(cpu);
+}
+
 // 获取GDT基址
 uint64_t gdt_get_base(void) {
-    return gdt_ptr.base;
+    return gdt_ptr[0].base;
 }
 
 // 获取TSS选择子
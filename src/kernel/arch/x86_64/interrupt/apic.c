@@ -0,0 +1,672 @@
+// Boruix OS x86_64 Local APIC / I/O APIC 驱动
+// 控制器信息来自ACPI MADT，寄存器通过VMM以UC方式映射
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "arch/x86_64.h"
+#include "arch/apic.h"
+#include "drivers/display.h"
+#include "kernel/spinlock.h"
+#include "rust/rust_memory.h"
+#include "acpi.h"
+
+extern void idt_set_gate(uint8_t num, uint64_t handler);
+extern void irq_spurious(void);
+
+// IA32_APIC_BASE位定义
+#define APIC_BASE_ENABLE        (1ULL << 11)
+#define APIC_BASE_X2APIC        (1ULL << 10)
+#define APIC_BASE_ADDR_MASK     0x000FFFFFFFFFF000ULL
+
+// Local APIC位定义
+#define LAPIC_SVR_ENABLE        0x100
+#define LAPIC_ICR_PENDING       (1 << 12)
+#define LAPIC_LVT_MASKED        (1 << 16)
+#define LAPIC_LVT_LEVEL         (1 << 15)
+#define LAPIC_LVT_ACTIVE_LOW    (1 << 13)
+#define LAPIC_LVT_NMI           (4 << 8)
+
+// I/O APIC寄存器
+#define IOAPIC_REG_SELECT       0x00
+#define IOAPIC_REG_WINDOW       0x10
+#define IOAPIC_REG_VERSION      0x01
+#define IOAPIC_REG_REDTBL(n)    (0x10 + 2 * (n))
+
+// 重定向表项位定义（固定投递、物理目标模式）
+#define IOAPIC_ACTIVE_LOW       (1 << 13)
+#define IOAPIC_LEVEL            (1 << 15)
+#define IOAPIC_MASKED           (1 << 16)
+
+typedef struct {
+    volatile uint32_t* regs;
+    uint64_t phys;
+    uint8_t id;
+    uint32_t gsi_base;
+    uint32_t redirections;
+} ioapic_t;
+
+volatile uint32_t* lapic_regs = NULL;
+bool lapic_x2apic = false;
+
+static bool x2apic_supported = false;
+static bool x2apic_locked = false;
+
+static uint64_t lapic_phys = 0;
+static ioapic_t ioapics[APIC_MAX_IOAPICS];
+static uint32_t ioapic_count = 0;
+static uint32_t cpu_count = 0;
+static bool pic_compat = false;
+static bool apic_enabled = false;
+
+// 已配置Local APIC的AP数量
+static uint32_t ap_count = 0;
+
+// ISA IRQ -> GSI映射及MPS INTI标志（默认恒等映射、高电平边沿触发）
+static uint32_t isa_gsi[APIC_ISA_IRQS];
+
+// ioapic_route_gsi路由到各向量的GSI（加1存放，0表示没有）
+static uint32_t vector_gsi[256];
+static uint16_t isa_flags[APIC_ISA_IRQS];
+
+// 已启用处理器的ACPI处理器ID和APIC ID（x2APIC条目给出32位值）
+static uint32_t cpu_acpi_ids[APIC_MAX_CPUS];
+static uint32_t cpu_apic_ids[APIC_MAX_CPUS];
+
+// MADT中的LINT NMI配置（Local APIC和Local x2APIC NMI条目统一存放）
+#define APIC_MAX_NMI_ENTRIES 8
+#define APIC_NMI_ALL_CPUS    0xFFFFFFFFu
+typedef struct {
+    uint32_t acpi_id;           // APIC_NMI_ALL_CPUS表示所有处理器
+    uint16_t flags;
+    uint8_t  lint;
+} apic_nmi_entry_t;
+static apic_nmi_entry_t nmi_entries[APIC_MAX_NMI_ENTRIES];
+static uint32_t nmi_entry_count = 0;
+
+// IOREGSEL/IOWIN是一对间接寄存器，选择与访问之间不能被其他CPU或中断插入
+DEFINE_SPINLOCK(ioapic_lock);
+
+// x2APIC模式下寄存器偏移reg对应MSR 0x800 + reg/16
+static inline uint32_t lapic_read(uint32_t reg) {
+    if (lapic_x2apic) {
+        return (uint32_t)cpu_read_msr(X2APIC_MSR_BASE + (reg >> 4));
+    }
+    return lapic_regs[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    if (lapic_x2apic) {
+        cpu_write_msr(X2APIC_MSR_BASE + (reg >> 4), value);
+    } else {
+        lapic_regs[reg / 4] = value;
+    }
+}
+
+static uint32_t ioapic_read(ioapic_t* ioapic, uint8_t reg) {
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+    ioapic->regs[IOAPIC_REG_SELECT / 4] = reg;
+    uint32_t value = ioapic->regs[IOAPIC_REG_WINDOW / 4];
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return value;
+}
+
+static void ioapic_write(ioapic_t* ioapic, uint8_t reg, uint32_t value) {
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+    ioapic->regs[IOAPIC_REG_SELECT / 4] = reg;
+    ioapic->regs[IOAPIC_REG_WINDOW / 4] = value;
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
+// 读-改-写一个寄存器（清除clear位、置上set位），整个过程持锁
+static void ioapic_modify(ioapic_t* ioapic, uint8_t reg, uint32_t clear, uint32_t set) {
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+    ioapic->regs[IOAPIC_REG_SELECT / 4] = reg;
+    uint32_t value = (ioapic->regs[IOAPIC_REG_WINDOW / 4] & ~clear) | set;
+    ioapic->regs[IOAPIC_REG_WINDOW / 4] = value;
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
+// 查找负责该GSI的I/O APIC
+static ioapic_t* ioapic_for_gsi(uint32_t gsi) {
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        ioapic_t* ioapic = &ioapics[i];
+        if (gsi >= ioapic->gsi_base && gsi < ioapic->gsi_base + ioapic->redirections) {
+            return ioapic;
+        }
+    }
+    return NULL;
+}
+
+// 记录已启用的处理器（同一APIC ID可能同时出现在Local APIC和Local x2APIC条目中）
+static void apic_add_cpu(uint32_t acpi_id, uint32_t apic_id) {
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        if (cpu_apic_ids[i] == apic_id) {
+            return;
+        }
+    }
+    if (cpu_count < APIC_MAX_CPUS) {
+        cpu_acpi_ids[cpu_count] = acpi_id;
+        cpu_apic_ids[cpu_count] = apic_id;
+        cpu_count++;
+    }
+}
+
+static void apic_add_nmi(uint32_t acpi_id, uint16_t flags, uint8_t lint) {
+    if (lint < 2 && nmi_entry_count < APIC_MAX_NMI_ENTRIES) {
+        nmi_entries[nmi_entry_count].acpi_id = acpi_id;
+        nmi_entries[nmi_entry_count].flags = flags;
+        nmi_entries[nmi_entry_count].lint = lint;
+        nmi_entry_count++;
+    }
+}
+
+// 解析MADT，收集LAPIC地址、I/O APIC和中断源覆盖
+static int apic_parse_madt(void) {
+    madt_t* madt = (madt_t*)acpi_find_table("APIC");
+    if (!madt) {
+        print_string("[APIC] MADT not found\n");
+        return -1;
+    }
+
+    lapic_phys = madt->lapic_address;
+    pic_compat = (madt->flags & 1) != 0;
+
+    for (int i = 0; i < APIC_ISA_IRQS; i++) {
+        isa_gsi[i] = i;
+        isa_flags[i] = 0;
+    }
+
+    uint8_t* ptr = madt->entries;
+    uint8_t* end = (uint8_t*)madt + madt->header.length;
+    while (ptr + sizeof(madt_entry_header_t) <= end) {
+        madt_entry_header_t* entry = (madt_entry_header_t*)ptr;
+        if (entry->length < sizeof(madt_entry_header_t) || ptr + entry->length > end) {
+            break;
+        }
+
+        switch (entry->type) {
+            case MADT_TYPE_LAPIC: {
+                madt_lapic_t* lapic = (madt_lapic_t*)entry;
+                if (lapic->flags & 1) {
+                    apic_add_cpu(lapic->acpi_processor_id, lapic->apic_id);
+                }
+                break;
+            }
+            case MADT_TYPE_X2APIC: {
+                madt_x2apic_t* x2apic = (madt_x2apic_t*)entry;
+                if (entry->length >= sizeof(madt_x2apic_t) && (x2apic->flags & 1)) {
+                    apic_add_cpu(x2apic->acpi_processor_uid, x2apic->x2apic_id);
+                }
+                break;
+            }
+            case MADT_TYPE_IOAPIC: {
+                madt_ioapic_t* io = (madt_ioapic_t*)entry;
+                if (ioapic_count < APIC_MAX_IOAPICS) {
+                    ioapics[ioapic_count].phys = io->ioapic_address;
+                    ioapics[ioapic_count].id = io->ioapic_id;
+                    ioapics[ioapic_count].gsi_base = io->gsi_base;
+                    ioapic_count++;
+                }
+                break;
+            }
+            case MADT_TYPE_ISO: {
+                madt_iso_t* iso = (madt_iso_t*)entry;
+                if (iso->bus == 0 && iso->source < APIC_ISA_IRQS) {
+                    isa_gsi[iso->source] = iso->gsi;
+                    isa_flags[iso->source] = iso->flags;
+                }
+                break;
+            }
+            case MADT_TYPE_LAPIC_NMI: {
+                madt_lapic_nmi_t* nmi = (madt_lapic_nmi_t*)entry;
+                uint32_t acpi_id = nmi->acpi_processor_id == 0xFF ? APIC_NMI_ALL_CPUS : nmi->acpi_processor_id;
+                apic_add_nmi(acpi_id, nmi->flags, nmi->lint);
+                break;
+            }
+            case MADT_TYPE_X2APIC_NMI: {
+                madt_x2apic_nmi_t* nmi = (madt_x2apic_nmi_t*)entry;
+                if (entry->length >= sizeof(madt_x2apic_nmi_t)) {
+                    apic_add_nmi(nmi->acpi_processor_uid, nmi->flags, nmi->lint);
+                }
+                break;
+            }
+            case MADT_TYPE_LAPIC_OVERRIDE: {
+                madt_lapic_override_t* ovr = (madt_lapic_override_t*)entry;
+                lapic_phys = ovr->lapic_address;
+                break;
+            }
+            default:
+                break;
+        }
+
+        ptr += entry->length;
+    }
+
+    if (ioapic_count == 0) {
+        print_string("[APIC] No I/O APIC in MADT\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 按MADT把本CPU的LINT引脚配置为NMI
+static void lapic_setup_nmi(uint32_t apic_id) {
+    bool found = false;
+    uint32_t acpi_id = 0;
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        if (cpu_apic_ids[i] == apic_id) {
+            acpi_id = cpu_acpi_ids[i];
+            found = true;
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < nmi_entry_count; i++) {
+        apic_nmi_entry_t* nmi = &nmi_entries[i];
+        if (nmi->acpi_id != APIC_NMI_ALL_CPUS && (!found || nmi->acpi_id != acpi_id)) {
+            continue;
+        }
+        uint32_t lvt = LAPIC_LVT_NMI;
+        if ((nmi->flags & MADT_POLARITY_MASK) == MADT_POLARITY_LOW) {
+            lvt |= LAPIC_LVT_ACTIVE_LOW;
+        }
+        if ((nmi->flags & MADT_TRIGGER_MASK) == MADT_TRIGGER_LEVEL) {
+            lvt |= LAPIC_LVT_LEVEL;
+        }
+        lapic_write(nmi->lint == 0 ? LAPIC_REG_LVT_LINT0 : LAPIC_REG_LVT_LINT1, lvt);
+    }
+}
+
+// 切换IA32_APIC_BASE中的工作模式
+// x2APIC -> xAPIC必须先完全禁用APIC，这会把LAPIC寄存器复位，调用者需重新配置
+static void lapic_switch_mode(bool x2apic) {
+    uint64_t base = cpu_read_msr(MSR_IA32_APIC_BASE);
+    bool current = (base & APIC_BASE_ENABLE) && (base & APIC_BASE_X2APIC);
+
+    if (current && !x2apic) {
+        base &= ~(APIC_BASE_ENABLE | APIC_BASE_X2APIC);
+        cpu_write_msr(MSR_IA32_APIC_BASE, base);
+    }
+
+    base |= APIC_BASE_ENABLE;
+    if (x2apic) {
+        base |= APIC_BASE_X2APIC;
+    }
+    cpu_write_msr(MSR_IA32_APIC_BASE, base);
+    lapic_x2apic = x2apic;
+}
+
+// 配置本CPU的Local APIC寄存器
+static void lapic_configure(void) {
+    // 接收所有优先级的中断
+    lapic_write(LAPIC_REG_TPR, 0);
+
+    // 定时器和错误LVT暂不使用；LINT0（ExtINT）屏蔽，8259已由I/O APIC取代
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_setup_nmi(lapic_get_id());
+
+    // 清除错误状态（xAPIC需先写后读，x2APIC只允许写0）
+    lapic_write(LAPIC_REG_ESR, 0);
+    (void)lapic_read(LAPIC_REG_ESR);
+
+    // 软件启用，设置伪中断向量
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+
+    // 清除可能挂起的中断
+    lapic_send_eoi();
+}
+
+// 启用并配置BSP的Local APIC，支持时优先使用x2APIC
+static int lapic_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_EDX_APIC)) {
+        print_string("[APIC] CPU has no Local APIC\n");
+        return -1;
+    }
+    x2apic_supported = (ecx & CPUID_FEAT_ECX_X2APIC) != 0;
+
+    // MADT未给出地址时使用MSR中的基址
+    uint64_t base = cpu_read_msr(MSR_IA32_APIC_BASE);
+    if (lapic_phys == 0) {
+        lapic_phys = base & APIC_BASE_ADDR_MASK;
+    }
+
+    // 固件已开启x2APIC时不能再退回xAPIC（APIC ID可能超过255）
+    x2apic_locked = (base & APIC_BASE_ENABLE) && (base & APIC_BASE_X2APIC);
+
+    // 始终映射xAPIC寄存器，以便运行时切换模式
+    uint64_t virt = rust_vmm_map_mmio(lapic_phys, PAGE_SIZE, RUST_CACHE_UC);
+    if (virt != 0) {
+        lapic_regs = (volatile uint32_t*)virt;
+    } else if (!x2apic_supported) {
+        print_string("[APIC] Failed to map Local APIC\n");
+        return -1;
+    }
+
+    lapic_switch_mode(x2apic_supported);
+
+    idt_set_gate(APIC_SPURIOUS_VECTOR, (uint64_t)irq_spurious);
+    lapic_configure();
+    return 0;
+}
+
+// 映射I/O APIC并屏蔽所有输入
+static int ioapic_init(void) {
+    uint32_t usable = 0;
+
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        ioapic_t* ioapic = &ioapics[i];
+        uint64_t virt = rust_vmm_map_mmio(ioapic->phys, PAGE_SIZE, RUST_CACHE_UC);
+        if (virt == 0) {
+            print_string("[APIC] Failed to map I/O APIC\n");
+            ioapic->redirections = 0;
+            continue;
+        }
+        ioapic->regs = (volatile uint32_t*)virt;
+        ioapic->redirections = ((ioapic_read(ioapic, IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+
+        for (uint32_t n = 0; n < ioapic->redirections; n++) {
+            ioapic_write(ioapic, IOAPIC_REG_REDTBL(n), IOAPIC_MASKED);
+            ioapic_write(ioapic, IOAPIC_REG_REDTBL(n) + 1, 0);
+        }
+        usable++;
+    }
+
+    return usable > 0 ? 0 : -1;
+}
+
+// 把ISA IRQ路由到IRQ_BASE+irq，发往BSP，初始为屏蔽状态
+static void ioapic_route_isa_irq(uint8_t irq, uint32_t dest) {
+    uint32_t gsi = isa_gsi[irq];
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!ioapic) {
+        return;
+    }
+
+    // ISA默认高电平边沿触发，覆盖条目可改变
+    uint32_t low = (IRQ_BASE + irq) | IOAPIC_MASKED;
+    if ((isa_flags[irq] & MADT_POLARITY_MASK) == MADT_POLARITY_LOW) {
+        low |= IOAPIC_ACTIVE_LOW;
+    }
+    if ((isa_flags[irq] & MADT_TRIGGER_MASK) == MADT_TRIGGER_LEVEL) {
+        low |= IOAPIC_LEVEL;
+    }
+
+    uint32_t pin = gsi - ioapic->gsi_base;
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin) + 1, dest << 24);
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin), low);
+}
+
+static int ioapic_set_masked(uint8_t irq, bool masked) {
+    if (!apic_enabled || irq >= APIC_ISA_IRQS) {
+        return -1;
+    }
+    uint32_t gsi = isa_gsi[irq];
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!ioapic) {
+        return -1;
+    }
+
+    uint8_t reg = IOAPIC_REG_REDTBL(gsi - ioapic->gsi_base);
+    ioapic_modify(ioapic, reg, masked ? 0 : IOAPIC_MASKED, masked ? IOAPIC_MASKED : 0);
+    return 0;
+}
+
+int apic_init(void) {
+    if (apic_parse_madt() != 0) {
+        return -1;
+    }
+    // 先映射I/O APIC：失败时Local APIC尚未改动，PIC仍可经LINT0工作
+    if (ioapic_init() != 0) {
+        return -1;
+    }
+    if (lapic_init() != 0) {
+        return -1;
+    }
+
+    uint32_t bsp = lapic_get_id();
+    for (uint8_t irq = 0; irq < APIC_ISA_IRQS; irq++) {
+        // IRQ2是级联线，不会产生中断
+        if (irq != 2) {
+            ioapic_route_isa_irq(irq, bsp);
+        }
+    }
+
+    apic_enabled = true;
+
+    print_string("[APIC] Local APIC at 0x");
+    print_hex(lapic_phys);
+    print_string(", ");
+    print_dec(ioapic_count);
+    print_string(" I/O APIC(s), ");
+    print_dec(cpu_count);
+    print_string(" CPU(s), ");
+    print_string(lapic_x2apic ? "x2APIC mode\n" : "xAPIC mode\n");
+    if (isa_gsi[0] != 0) {
+        print_string("[APIC] Timer IRQ0 overridden to GSI ");
+        print_dec(isa_gsi[0]);
+        print_string("\n");
+    }
+    return 0;
+}
+
+int lapic_init_ap(void) {
+    if (!apic_enabled) {
+        return -1;
+    }
+    // AP由固件以xAPIC模式启动，与BSP保持相同的工作模式（lapic_x2apic对所有CPU有效）
+    lapic_switch_mode(lapic_x2apic);
+    lapic_configure();
+    __atomic_add_fetch(&ap_count, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+bool apic_is_enabled(void) {
+    return apic_enabled;
+}
+
+uint32_t lapic_get_id(void) {
+    if (lapic_x2apic) {
+        return lapic_read(LAPIC_REG_ID);
+    }
+    if (!lapic_regs) {
+        return 0;
+    }
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+bool lapic_x2apic_supported(void) {
+    return x2apic_supported;
+}
+
+bool lapic_mode_switch_locked(void) {
+    return __atomic_load_n(&ap_count, __ATOMIC_RELAXED) > 0;
+}
+
+int lapic_set_mode(bool x2apic) {
+    if (!apic_enabled) {
+        return -1;
+    }
+    if (x2apic == lapic_x2apic) {
+        return 0;
+    }
+    if (x2apic && !x2apic_supported) {
+        return -1;
+    }
+    // 固件开启的x2APIC或xAPIC寄存器未映射时不能退回xAPIC
+    if (!x2apic && (x2apic_locked || lapic_regs == NULL)) {
+        return -1;
+    }
+    // 模式对所有CPU生效，AP上线后无法同时切换
+    if (lapic_mode_switch_locked()) {
+        return -1;
+    }
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    uint8_t tpr = lapic_get_tpr();
+    lapic_switch_mode(x2apic);
+    lapic_configure();
+    lapic_set_tpr(tpr);
+    lapic_timer_resume();
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return 0;
+}
+
+void lapic_set_tpr(uint8_t priority) {
+    lapic_write(LAPIC_REG_TPR, priority);
+}
+
+uint8_t lapic_get_tpr(void) {
+    return (uint8_t)lapic_read(LAPIC_REG_TPR);
+}
+
+void lapic_send_ipi(uint32_t apic_id, uint32_t icr_low) {
+    if (lapic_x2apic) {
+        // x2APIC的ICR是单个64位MSR，一次写入即发送
+        cpu_write_msr(X2APIC_MSR_BASE + (LAPIC_REG_ICR_LOW >> 4), ((uint64_t)apic_id << 32) | icr_low);
+        return;
+    }
+
+    lapic_write(LAPIC_REG_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, icr_low);
+    while (lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) {
+        __asm__ volatile("pause");
+    }
+}
+
+uint32_t lapic_read_reg(uint32_t reg) {
+    return lapic_read(reg);
+}
+
+void lapic_write_reg(uint32_t reg, uint32_t value) {
+    lapic_write(reg, value);
+}
+
+uint32_t lapic_read_irr(uint32_t index) {
+    return lapic_read(LAPIC_REG_IRR + index * 0x10);
+}
+
+int ioapic_mask_irq(uint8_t irq) {
+    return ioapic_set_masked(irq, true);
+}
+
+int ioapic_unmask_irq(uint8_t irq) {
+    return ioapic_set_masked(irq, false);
+}
+
+int ioapic_set_vector(uint8_t irq, uint8_t vector) {
+    if (!apic_enabled || irq >= APIC_ISA_IRQS) {
+        return -1;
+    }
+    uint32_t gsi = isa_gsi[irq];
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!ioapic) {
+        return -1;
+    }
+
+    uint8_t reg = IOAPIC_REG_REDTBL(gsi - ioapic->gsi_base);
+    ioapic_modify(ioapic, reg, 0xFFu, vector);
+    return 0;
+}
+
+// GSI是否被某条ISA IRQ占用
+static bool gsi_is_isa(uint32_t gsi) {
+    for (uint8_t irq = 0; irq < APIC_ISA_IRQS; irq++) {
+        if (isa_gsi[irq] == gsi) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ioapic_route_gsi(uint32_t gsi, uint8_t vector, bool level) {
+    if (!apic_enabled || gsi_is_isa(gsi)) {
+        return -1;
+    }
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!ioapic || !ioapic->regs) {
+        return -1;
+    }
+
+    // PCI风格的GSI：电平触发时低电平有效，边沿触发时高电平有效
+    uint32_t low = vector | IOAPIC_MASKED;
+    if (level) {
+        low |= IOAPIC_LEVEL | IOAPIC_ACTIVE_LOW;
+    }
+
+    uint32_t pin = gsi - ioapic->gsi_base;
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin), low);
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin) + 1, lapic_get_id() << 24);
+    vector_gsi[vector] = gsi + 1;
+    return 0;
+}
+
+int ioapic_mask_gsi(uint32_t gsi, bool masked) {
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!apic_enabled || !ioapic || !ioapic->regs || gsi_is_isa(gsi)) {
+        return -1;
+    }
+
+    uint8_t reg = IOAPIC_REG_REDTBL(gsi - ioapic->gsi_base);
+    ioapic_modify(ioapic, reg, masked ? 0 : IOAPIC_MASKED, masked ? IOAPIC_MASKED : 0);
+    return 0;
+}
+
+int ioapic_mask_vector(uint8_t vector, bool masked) {
+    if (vector_gsi[vector] == 0) {
+        return -1;
+    }
+    // GSI之后可能被改路由到别的向量，以重定向表项为准
+    uint32_t gsi = vector_gsi[vector] - 1;
+    uint64_t entry;
+    if (ioapic_read_redirection(gsi, &entry) != 0 || (uint8_t)entry != vector) {
+        return -1;
+    }
+    return ioapic_mask_gsi(gsi, masked);
+}
+
+uint32_t ioapic_irq_to_gsi(uint8_t irq) {
+    if (irq >= APIC_ISA_IRQS) {
+        return irq;
+    }
+    return isa_gsi[irq];
+}
+
+int ioapic_read_redirection(uint32_t gsi, uint64_t* entry) {
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (!ioapic || !ioapic->regs) {
+        return -1;
+    }
+    uint32_t pin = gsi - ioapic->gsi_base;
+    uint64_t low = ioapic_read(ioapic, IOAPIC_REG_REDTBL(pin));
+    uint64_t high = ioapic_read(ioapic, IOAPIC_REG_REDTBL(pin) + 1);
+    *entry = (high << 32) | low;
+    return 0;
+}
+
+void apic_get_info(apic_info_t* info) {
+    info->lapic_phys = lapic_phys;
+    info->lapic_id = lapic_get_id();
+    info->lapic_version = (lapic_x2apic || lapic_regs) ? lapic_read(LAPIC_REG_VERSION) : 0;
+    info->x2apic = lapic_x2apic;
+    info->cpu_count = cpu_count;
+    info->ioapic_count = ioapic_count;
+    info->pic_compat = pic_compat;
+}
+
+bool ioapic_get_info(uint32_t index, ioapic_info_t* info) {
+    if (index >= ioapic_count) {
+        return false;
+    }
+    info->phys = ioapics[index].phys;
+    info->id = ioapics[index].id;
+    info->gsi_base = ioapics[index].gsi_base;
+    info->redirections = ioapics[index].redirections;
+    return true;
+}
@@ -2,11 +2,15 @@
 
 #include "kernel/types.h"
 #include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+#include "kernel/irq_latency.h"
+#include "arch/x86_64.h"
 #include "drivers/display.h"
 #include "drivers/timer.h"
 #include "drivers/keyboard.h"
-
-extern void pic_send_eoi(uint8_t irq);
+#include "rust/rust_memory.h"
+#include "arch/percpu.h"
+#include "arch/smp.h"
 
 // 中断寄存器状态结构（与汇编压栈顺序对应）
 typedef struct {
@@ -16,7 +20,7 @@ typedef struct {
     uint64_t rip, cs, rflags, rsp, ss;
 } __attribute__((packed)) registers_t;
 
-static uint64_t interrupt_counts[256] = {0};
+// 按向量的中断计数和IRQ嵌套深度在每CPU页中（percpu_t），查询时汇总各CPU
 
 static const char* exception_messages[] = {
     "Division By Zero",
@@ -46,6 +50,24 @@ static const char* exception_messages[] = {
     "Reserved"
 };
 
+// 读取CR2（缺页线性地址）
+static inline uint64_t read_cr2(void) {
+    uint64_t cr2;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+    return cr2;
+}
+
+// 若缺页地址落在内核栈保护页中，报告栈溢出
+static void report_stack_overflow(void) {
+    uint64_t cr2 = read_cr2();
+    if (rust_kstack_is_guard_page(cr2)) {
+        print_string("KERNEL STACK OVERFLOW: guard page hit at 0x");
+        print_hex((uint32_t)(cr2 >> 32));
+        print_hex((uint32_t)cr2);
+        print_string("\n\n");
+    }
+}
+
 // 双重错误专用处理器
 static void double_fault_handler(registers_t* regs) {
     // 禁用中断
@@ -71,6 +93,9 @@ static void double_fault_handler(registers_t* regs) {
     print_string("A double fault occurred - this means an exception happened while handling\n");
     print_string("another exception. Using independent stack (IST1) for safe handling.\n\n");
     
+    // 栈溢出时CPU无法在保护页上压入缺页异常帧，会直接升级为双重错误
+    report_stack_overflow();
+    
     print_string("=== SYSTEM STATE DUMP ===\n");
     print_string("Error Code: 0x");
     print_hex((uint32_t)regs->err_code);
@@ -179,9 +204,14 @@ static void double_fault_handler(registers_t* regs) {
 void isr_handler(registers_t* regs) {
     uint32_t int_no = (uint32_t)regs->int_no;
     
-    interrupt_counts[int_no]++;
+    this_cpu_inc_idx(interrupt_counts, int_no);
     
     if (int_no < 32) {
+        // NMI在IST栈上运行后返回（计数已记录），供采样分析等使用
+        if (int_no == 2) {
+            return;
+        }
+        
         // 双重错误特殊处理
         if (int_no == 8) {
             double_fault_handler(regs);
@@ -207,6 +237,9 @@ void isr_handler(registers_t* regs) {
         print_string("RSP: ");
         print_hex((uint32_t)regs->rsp);
         print_string("\n");
+        if (int_no == 14) {
+            report_stack_overflow();
+        }
         print_string("========================================\n");
         
         print_string("System halted.\n");
@@ -216,59 +249,74 @@ void isr_handler(registers_t* regs) {
     }
 }
 
-// 静态标志，防止中断重入
-static volatile int in_irq = 0;
-
 // IRQ处理函数
 void irq_handler(registers_t* regs) {
-    uint32_t int_no = (uint32_t)regs->int_no;
-    
-    // 防止重入
-    if (in_irq) {
-        uint8_t irq = int_no - 32;
-        pic_send_eoi(irq);
-        return;
-    }
-    in_irq = 1;
+    uint64_t entered = cpu_rdtsc();
+    uint8_t vector = (uint8_t)regs->int_no;
+    uint8_t irq = irq_vector_to_line(vector);
     
-    interrupt_counts[int_no]++;
+    // ISA IRQ的实际向量随优先级变化，统计和分发统一使用IRQ_BASE+irq
+    uint8_t logical = irq < 16 ? IRQ_BASE + irq : vector;
     
-    uint8_t irq = int_no - 32;
+    this_cpu_inc_idx(interrupt_counts, logical);
+    this_cpu_inc(irq_depth);
     
-    // 先发送EOI，避免PIC阻塞
-    pic_send_eoi(irq);
+    // 风暴检测：超过阈值时屏蔽中断源，本次中断仍正常处理
+    irq_storm_account(logical);
     
-    // 检查优先级，决定是否执行
-    if (!irq_should_execute(irq)) {
-        in_irq = 0;
-        return;
+    // 先提高优先级再EOI：同级和更低级的中断留在控制器中等待，而不是丢弃
+    uint32_t saved = irq_raise_priority(vector, irq);
+    irq_send_eoi(irq);
+    if (irq < 16) {
+        irq_enter(irq);
     }
     
-    // 进入中断处理
-    irq_enter(irq);
+    // 开中断执行处理程序，更高优先级的中断可以嵌套
+    irq_account_off_window(cpu_rdtsc() - entered);
+    interrupts_enable();
+    irq_dispatch(logical);
+    interrupts_disable();
+    
+    // 入口到处理程序返回的周期数（包含被嵌套中断占用的时间）
+    irq_latency_record(logical, cpu_rdtsc() - entered);
+    
+    if (irq < 16) {
+        irq_exit();
+    }
+    irq_restore_priority(saved);
     
-    switch (irq) {
-        case 0:  // IRQ0 - Timer
-            timer_irq_handler();
-            break;
-            
-        case 1:  // IRQ1 - Keyboard
-            keyboard_irq_handler();
-            break;
-            
-        default:
-            break;
+    // 最外层退出时执行下半部
+    this_cpu_dec(irq_depth);
+    if (this_cpu_read(irq_depth) == 0) {
+        do_softirq();
     }
+}
+
+// 精简入口退出：处理程序已在关中断状态下运行完毕，entered为存根入口的TSC
+void irq_fast_exit(uint64_t vector, uint64_t entered) {
+    uint8_t hw = (uint8_t)vector;
+    uint8_t irq = irq_vector_to_line(hw);
+    uint8_t logical = irq < 16 ? IRQ_BASE + irq : hw;
+    this_cpu_inc_idx(interrupt_counts, logical);
     
-    // 退出中断处理
-    irq_exit();
+    // 整个处理程序都在关中断下运行，同时计入关中断窗口
+    uint64_t cycles = cpu_rdtsc() - entered;
+    irq_account_off_window(cycles);
+    irq_latency_record(logical, cycles);
+    irq_send_eoi(irq);
     
-    in_irq = 0;
+    if (this_cpu_read(irq_depth) == 0 && softirq_pending()) {
+        do_softirq();
+    }
 }
 
 uint64_t get_interrupt_count(uint8_t int_no) {
-    if (int_no < 256) {
-        return interrupt_counts[int_no];
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        percpu_t* pc = percpu_area(cpu);
+        if (pc) {
+            total += pc->interrupt_counts[int_no];
+        }
     }
-    return 0;
+    return total;
 }
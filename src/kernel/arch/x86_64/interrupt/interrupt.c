@@ -1,12 +1,157 @@
 // Boruix OS x86_64中断系统初始化
 
 #include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+#include "arch/apic.h"
+#include "arch/msi.h"
 #include "drivers/display.h"
 #include "drivers/timer.h"
+#include "drivers/clocksource.h"
+#include "drivers/hpet.h"
+#include "drivers/ktimer.h"
+#include "drivers/hrtimer.h"
 
 void idt_init(void);
 void pic_init(void);
+void pic_disable(void);
+extern void pic_send_eoi(uint8_t irq);
+extern void pic_set_mask(uint8_t irq);
 extern void pic_clear_mask(uint8_t irq);
+extern uint16_t pic_get_priority_mask(void);
+extern uint16_t pic_set_priority_mask(uint16_t mask);
+extern uint16_t pic_read_irr(void);
+
+// 当前是否使用APIC
+static bool use_apic = false;
+
+// ISA IRQ当前路由到的硬件向量（PIC固定为IRQ_BASE+irq）
+static uint8_t line_vectors[16] = {
+    IRQ_BASE + 0,  IRQ_BASE + 1,  IRQ_BASE + 2,  IRQ_BASE + 3,
+    IRQ_BASE + 4,  IRQ_BASE + 5,  IRQ_BASE + 6,  IRQ_BASE + 7,
+    IRQ_BASE + 8,  IRQ_BASE + 9,  IRQ_BASE + 10, IRQ_BASE + 11,
+    IRQ_BASE + 12, IRQ_BASE + 13, IRQ_BASE + 14, IRQ_BASE + 15
+};
+
+void irq_send_eoi(uint8_t irq) {
+    if (use_apic) {
+        lapic_send_eoi();
+    } else if (irq < 16) {
+        pic_send_eoi(irq);
+    }
+}
+
+void irq_mask_line(uint8_t irq) {
+    if (use_apic) {
+        ioapic_mask_irq(irq);
+    } else if (irq < 16) {
+        pic_set_mask(irq);
+    }
+}
+
+void irq_unmask_line(uint8_t irq) {
+    if (use_apic) {
+        ioapic_unmask_irq(irq);
+    } else if (irq < 16) {
+        pic_clear_mask(irq);
+    }
+}
+
+int irq_mask_vector(uint8_t vector, bool masked) {
+    uint8_t irq = irq_vector_to_line(vector);
+    if (irq < 16) {
+        if (masked) {
+            irq_mask_line(irq);
+        } else {
+            irq_unmask_line(irq);
+        }
+        return 0;
+    }
+    if (!use_apic) {
+        return -1;
+    }
+    if (ioapic_mask_vector(vector, masked) == 0) {
+        return 0;
+    }
+    return msi_mask_vector(vector, masked);
+}
+
+const char* irq_controller_name(void) {
+    return use_apic ? "I/O APIC + Local APIC" : "PIC 8259A";
+}
+
+uint32_t irq_raise_priority(uint8_t vector, uint8_t irq) {
+    if (use_apic) {
+        // TPR设为当前向量的优先级类，同类和更低类的中断留在IRR中
+        uint8_t old = lapic_get_tpr();
+        lapic_set_tpr(vector & 0xF0);
+        return old;
+    }
+    uint16_t old = pic_get_priority_mask();
+    if (irq >= 16) {
+        return old;
+    }
+    
+    // PIC没有优先级类，屏蔽所有不高于当前优先级的线路（级联线IRQ2除外）
+    uint8_t priority = irq_get_priority(irq);
+    uint16_t block = 0;
+    for (uint8_t line = 0; line < 16; line++) {
+        if (line != 2 && irq_get_priority(line) >= priority) {
+            block |= (uint16_t)(1 << line);
+        }
+    }
+    pic_set_priority_mask(old | block);
+    return old;
+}
+
+void irq_restore_priority(uint32_t saved) {
+    if (use_apic) {
+        lapic_set_tpr((uint8_t)saved);
+    } else {
+        pic_set_priority_mask((uint16_t)saved);
+    }
+}
+
+void irq_route_priority(uint8_t irq, uint8_t priority) {
+    if (!use_apic || irq >= 16 || irq == 2 || priority > IRQ_PRIORITY_LOW) {
+        return;
+    }
+    uint8_t old = line_vectors[irq];
+    uint8_t vector = IRQ_PRIO_VECTOR(priority, irq);
+    if (old == vector) {
+        return;
+    }
+    
+    // 先迁移精简入口再改路由，新向量到达时IDT已就绪
+    irq_fast_reroute(old, vector);
+    line_vectors[irq] = vector;
+    ioapic_set_vector(irq, vector);
+}
+
+uint8_t irq_line_vector(uint8_t irq) {
+    return irq < 16 ? line_vectors[irq] : 0;
+}
+
+uint16_t irq_pending_lines(void) {
+    if (!use_apic) {
+        return pic_read_irr();
+    }
+    
+    // ISA IRQ的向量都在0xA0-0xDF，对应IRR的第5、6个字
+    uint64_t irr = lapic_read_irr(IRQ_PRIO_VECTOR_BASE / 32) |
+                   ((uint64_t)lapic_read_irr(IRQ_PRIO_VECTOR_BASE / 32 + 1) << 32);
+    uint16_t pending = 0;
+    for (uint8_t irq = 0; irq < 16; irq++) {
+        uint8_t priority = irq_get_priority(irq);
+        if (priority > IRQ_PRIORITY_LOW) {
+            continue;
+        }
+        uint8_t bit = IRQ_PRIO_VECTOR(priority, irq) - IRQ_PRIO_VECTOR_BASE;
+        if (irr & (1ULL << bit)) {
+            pending |= (uint16_t)(1 << irq);
+        }
+    }
+    return pending;
+}
 
 void interrupt_init(void) {
     print_string("[INT] Initializing interrupt system (x86_64)...\n");
@@ -15,21 +160,48 @@ void interrupt_init(void) {
     
     idt_init();
     
+    // 无论是否使用APIC都先重映射PIC，避免其伪中断落到异常向量
     pic_init();
-    print_string("[PIC] Programmable Interrupt Controller initialized\n");
+    
+    if (apic_init() == 0) {
+        pic_disable();
+        use_apic = true;
+        print_string("[APIC] I/O APIC routing active, PIC masked\n");
+    } else {
+        print_string("[PIC] Programmable Interrupt Controller initialized\n");
+    }
     
     // 初始化中断优先级系统
     irq_priority_init();
     print_string("[IRQ] Interrupt priority system initialized\n");
     
+    softirq_init();
+    print_string("[IRQ] Softirq/tasklet bottom halves initialized\n");
+    
+    ktimer_init();
+    
     timer_init(TIMER_FREQ_HZ);
     print_string("[TIMER] System timer initialized (");
     print_dec(TIMER_FREQ_HZ);
     print_string(" Hz)\n");
     
+    // HPET既是TSC不可靠时的时钟源，也是TSC校准的参考
+    hpet_init();
+    
+    // TSC校准失败时继续使用HPET或滴答时钟源
+    if (tsc_init() != 0) {
+        print_string("[TSC] Unavailable, using ");
+        print_string(clocksource_get_current()->name);
+        print_string(" clocksource\n");
+    }
+    
     // 启用IRQ0（定时器）和IRQ1（键盘）
-    pic_clear_mask(0);
-    pic_clear_mask(1);
+    irq_unmask_line(0);
+    irq_unmask_line(1);
+    
+    // LAPIC定时器接管滴答后停用PIT，空闲时可以停掉滴答
+    lapic_timer_init();
+    hrtimers_init();
     
     print_string("[INT] Interrupt system initialized\n");
     // 注意：不自动启用中断，等待shell准备好
@@ -0,0 +1,261 @@
+// Boruix OS x86_64中断处理程序注册和向量分配
+// 每个向量一条处理程序链，驱动通过request_irq挂接，无需修改分发代码
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+
+// 处理程序节点池容量
+#define IRQ_MAX_ACTIONS 128
+
+typedef struct irq_action {
+    irq_handler_t handler;
+    void* ctx;
+    uint32_t flags;
+    struct irq_action* next;
+} irq_action_t;
+
+static irq_action_t action_pool[IRQ_MAX_ACTIONS];
+static irq_action_t* free_actions = NULL;
+static bool pool_initialized = false;
+
+// 每个向量的处理程序链
+static irq_action_t* irq_actions[256];
+
+// 没有处理程序认领的中断次数
+static uint64_t unhandled_counts[256];
+
+// 动态向量分配位图（1表示已分配）
+static uint64_t vector_bitmap[4];
+
+// 精简入口处理程序，按硬件向量索引（isr.asm的irq_fast_common直接查表调用）
+irq_fast_handler_t irq_fast_handlers[256];
+
+// 注册了精简处理程序的逻辑向量
+static bool fast_registered[256];
+
+extern void idt_set_gate(uint8_t num, uint64_t handler);
+extern uint64_t interrupt_stub_table[256];
+extern uint64_t interrupt_fast_stub_table[224];
+
+// 逻辑向量对应的硬件向量（ISA IRQ随优先级路由到不同向量）
+static uint8_t hw_vector(uint8_t vector) {
+    if (vector >= IRQ_BASE && vector < IRQ_BASE + 16) {
+        return irq_line_vector(vector - IRQ_BASE);
+    }
+    return vector;
+}
+
+static void pool_init(void) {
+    for (int i = 0; i < IRQ_MAX_ACTIONS - 1; i++) {
+        action_pool[i].next = &action_pool[i + 1];
+    }
+    action_pool[IRQ_MAX_ACTIONS - 1].next = NULL;
+    free_actions = &action_pool[0];
+    pool_initialized = true;
+}
+
+// 关中断保护链表修改，返回之前的中断状态
+static bool irq_lock(void) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    return was_enabled;
+}
+
+static void irq_unlock(bool was_enabled) {
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
+
+int request_irq(uint8_t vector, irq_handler_t handler, void* ctx, uint32_t flags) {
+    if (vector < IRQ_BASE || handler == NULL) {
+        return -1;
+    }
+    
+    bool state = irq_lock();
+    
+    if (!pool_initialized) {
+        pool_init();
+    }
+    
+    // 已有处理程序时，双方都必须声明共享；精简入口独占向量
+    irq_action_t* head = irq_actions[vector];
+    if (fast_registered[vector] ||
+        (head && (!(flags & IRQF_SHARED) || !(head->flags & IRQF_SHARED)))) {
+        irq_unlock(state);
+        return -1;
+    }
+    
+    irq_action_t* action = free_actions;
+    if (!action) {
+        irq_unlock(state);
+        return -1;
+    }
+    free_actions = action->next;
+    
+    action->handler = handler;
+    action->ctx = ctx;
+    action->flags = flags;
+    action->next = NULL;
+    
+    // 追加到链尾，先注册的先调用
+    irq_action_t** link = &irq_actions[vector];
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = action;
+    
+    irq_unlock(state);
+    return 0;
+}
+
+int free_irq(uint8_t vector, irq_handler_t handler, void* ctx) {
+    bool state = irq_lock();
+    
+    irq_action_t** link = &irq_actions[vector];
+    while (*link) {
+        irq_action_t* action = *link;
+        if (action->handler == handler && action->ctx == ctx) {
+            *link = action->next;
+            action->next = free_actions;
+            free_actions = action;
+            irq_unlock(state);
+            return 0;
+        }
+        link = &action->next;
+    }
+    
+    irq_unlock(state);
+    return -1;
+}
+
+int request_irq_fast(uint8_t vector, irq_fast_handler_t handler) {
+    if (vector < IRQ_BASE || handler == NULL) {
+        return -1;
+    }
+    
+    bool state = irq_lock();
+    if (fast_registered[vector] || irq_actions[vector]) {
+        irq_unlock(state);
+        return -1;
+    }
+    
+    uint8_t hw = hw_vector(vector);
+    fast_registered[vector] = true;
+    irq_fast_handlers[hw] = handler;
+    idt_set_gate(hw, interrupt_fast_stub_table[hw - IRQ_BASE]);
+    
+    irq_unlock(state);
+    return 0;
+}
+
+int free_irq_fast(uint8_t vector) {
+    bool state = irq_lock();
+    if (!fast_registered[vector]) {
+        irq_unlock(state);
+        return -1;
+    }
+    
+    uint8_t hw = hw_vector(vector);
+    idt_set_gate(hw, interrupt_stub_table[hw]);
+    irq_fast_handlers[hw] = NULL;
+    fast_registered[vector] = false;
+    
+    irq_unlock(state);
+    return 0;
+}
+
+void irq_fast_reroute(uint8_t old_vector, uint8_t new_vector) {
+    if (old_vector == new_vector || irq_fast_handlers[old_vector] == NULL) {
+        return;
+    }
+    
+    bool state = irq_lock();
+    irq_fast_handlers[new_vector] = irq_fast_handlers[old_vector];
+    idt_set_gate(new_vector, interrupt_fast_stub_table[new_vector - IRQ_BASE]);
+    idt_set_gate(old_vector, interrupt_stub_table[old_vector]);
+    irq_fast_handlers[old_vector] = NULL;
+    irq_unlock(state);
+}
+
+static bool vector_used(int vector) {
+    return (vector_bitmap[vector / 64] >> (vector % 64)) & 1;
+}
+
+int irq_alloc_vectors(uint32_t count, uint32_t align) {
+    if (count == 0 || align == 0 || (align & (align - 1)) != 0) {
+        return -1;
+    }
+    
+    bool state = irq_lock();
+    
+    // 起始向量按align对齐（多消息MSI要求向量块按消息数对齐）
+    int first = (IRQ_VECTOR_DYNAMIC_START + align - 1) & ~(int)(align - 1);
+    for (int base = first; base + (int)count - 1 <= IRQ_VECTOR_DYNAMIC_END; base += align) {
+        uint32_t n = 0;
+        while (n < count && !vector_used(base + n)) {
+            n++;
+        }
+        if (n < count) {
+            continue;
+        }
+        
+        for (n = 0; n < count; n++) {
+            vector_bitmap[(base + n) / 64] |= 1ULL << ((base + n) % 64);
+        }
+        irq_unlock(state);
+        return base;
+    }
+    
+    irq_unlock(state);
+    return -1;
+}
+
+int irq_alloc_vector(void) {
+    return irq_alloc_vectors(1, 1);
+}
+
+void irq_free_vector(uint8_t vector) {
+    if (vector < IRQ_VECTOR_DYNAMIC_START || vector > IRQ_VECTOR_DYNAMIC_END) {
+        return;
+    }
+    bool state = irq_lock();
+    vector_bitmap[vector / 64] &= ~(1ULL << (vector % 64));
+    irq_unlock(state);
+}
+
+static irq_return_t irq_run_actions(uint8_t vector) {
+    irq_action_t* action = irq_actions[vector];
+    irq_return_t handled = IRQ_NONE;
+    
+    // 独占向量只有一个节点，即一次间接调用
+    while (action) {
+        handled |= action->handler(vector, action->ctx);
+        action = action->next;
+    }
+    return handled;
+}
+
+irq_return_t irq_poll_vector(uint8_t vector) {
+    return irq_run_actions(vector);
+}
+
+irq_return_t irq_dispatch(uint8_t vector) {
+    irq_return_t handled = irq_run_actions(vector);
+    if (handled == IRQ_NONE) {
+        unhandled_counts[vector]++;
+    }
+    return handled;
+}
+
+uint32_t irq_get_action_count(uint8_t vector) {
+    uint32_t count = fast_registered[vector] ? 1 : 0;
+    for (irq_action_t* action = irq_actions[vector]; action; action = action->next) {
+        count++;
+    }
+    return count;
+}
+
+uint64_t irq_get_unhandled_count(uint8_t vector) {
+    return unhandled_counts[vector];
+}
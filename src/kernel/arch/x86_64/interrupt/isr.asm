@@ -8,18 +8,45 @@ global isr8, isr9, isr10, isr11, isr12, isr13, isr14, isr15
 global isr16, isr17, isr18, isr19, isr20, isr21, isr22, isr23
 global isr24, isr25, isr26, isr27, isr28, isr29, isr30, isr31
 
-; 导出IRQ处理程序
-global irq0, irq1, irq2, irq3, irq4, irq5, irq6, irq7
-global irq8, irq9, irq10, irq11, irq12, irq13, irq14, irq15
+; 导出中断入口表（256项，0-31为异常，32-255为外部中断）
+global interrupt_stub_table
+global interrupt_fast_stub_table
+global irq_spurious
 
 ; 外部C函数
 extern isr_handler
 extern irq_handler
+extern irq_fast_exit
+extern irq_fast_handlers
+
+; 每CPU页中的中断栈字段（GS基址指向本CPU的percpu_t，偏移与percpu.h的PERCPU_IRQ_STACK_*一致）
+%define PERCPU_IRQ_STACK_TOP    16
+%define PERCPU_IRQ_STACK_NEST   24
+
+; 宏：最外层IRQ切换到中断栈（嵌套中断已在中断栈上，继续使用当前栈）
+; 调用前rbp保存原栈指针，切换后栈按16字节对齐
+%macro IRQ_STACK_ENTER 0
+    inc qword [gs:PERCPU_IRQ_STACK_NEST]
+    cmp qword [gs:PERCPU_IRQ_STACK_NEST], 1
+    jne %%on_stack
+    cmp qword [gs:PERCPU_IRQ_STACK_TOP], 0
+    je %%on_stack
+    mov rsp, [gs:PERCPU_IRQ_STACK_TOP]
+%%on_stack:
+    and rsp, ~0xF
+%endmacro
+
+; 宏：离开中断栈，恢复原栈指针
+%macro IRQ_STACK_LEAVE 0
+    dec qword [gs:PERCPU_IRQ_STACK_NEST]
+    mov rsp, rbp
+%endmacro
+
+; 所有入口都是中断门，CPU进入时已清除IF
 
 ; 宏：无错误码的ISR
 %macro ISR_NOERRCODE 1
 isr%1:
-    cli
     push qword 0        ; 压入伪错误码
     push qword %1       ; 压入中断号
     jmp isr_common_stub
@@ -28,20 +55,25 @@ isr%1:
 ; 宏：有错误码的ISR
 %macro ISR_ERRCODE 1
 isr%1:
-    cli
     push qword %1       ; 压入中断号
     jmp isr_common_stub
 %endmacro
 
-; 宏：IRQ处理程序
-%macro IRQ 2
-irq%1:
-    cli
+; 宏：外部中断处理程序（参数为向量号）
+%macro IRQ 1
+irq_stub_%1:
     push qword 0        ; 伪错误码
-    push qword %2       ; 中断号
+    push qword %1       ; 中断号
     jmp irq_common_stub
 %endmacro
 
+; 宏：精简外部中断入口（参数为向量号）
+%macro IRQ_FAST 1
+irq_fast_stub_%1:
+    push qword %1       ; 中断号
+    jmp irq_fast_common
+%endmacro
+
 ; CPU异常（0-31）
 ISR_NOERRCODE 0
 ISR_NOERRCODE 1
@@ -76,23 +108,23 @@ ISR_NOERRCODE 29
 ISR_NOERRCODE 30
 ISR_NOERRCODE 31
 
-; IRQ（32-47）
-IRQ 0, 32
-IRQ 1, 33
-IRQ 2, 34
-IRQ 3, 35
-IRQ 4, 36
-IRQ 5, 37
-IRQ 6, 38
-IRQ 7, 39
-IRQ 8, 40
-IRQ 9, 41
-IRQ 10, 42
-IRQ 11, 43
-IRQ 12, 44
-IRQ 13, 45
-IRQ 14, 46
-IRQ 15, 47
+; 外部中断（32-255）
+%assign vec 32
+%rep 224
+IRQ %[vec]
+%assign vec vec+1
+%endrep
+
+; 精简外部中断入口（32-255），request_irq_fast安装到IDT
+%assign vec 32
+%rep 224
+IRQ_FAST %[vec]
+%assign vec vec+1
+%endrep
+
+; APIC伪中断：不计数、不发送EOI
+irq_spurious:
+    iretq
 
 ; ISR通用存根
 isr_common_stub:
@@ -161,15 +193,15 @@ irq_common_stub:
     push r14
     push r15
     
-    ; 对齐栈到16字节（x86_64 ABI要求）
+    ; 切换到中断栈并对齐到16字节（x86_64 ABI要求）
     mov rbp, rsp
-    and rsp, ~0xF
+    IRQ_STACK_ENTER
     
     mov rdi, rbp
     call irq_handler
     
-    ; 恢复栈指针
-    mov rsp, rbp
+    ; 恢复原栈指针
+    IRQ_STACK_LEAVE
     
     pop r15
     pop r14
@@ -189,3 +221,73 @@ irq_common_stub:
     
     add rsp, 16
     iretq
+
+; 精简IRQ存根：只保存调用者保存寄存器，rbp由被调用者保存，这里借用前先压栈
+; 直接调用irq_fast_handlers[向量]，再由irq_fast_exit发送EOI并处理软中断
+irq_fast_common:
+    push rax
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push r8
+    push r9
+    push r10
+    push r11
+    push rbp
+    
+    ; 入口时间戳，交给irq_fast_exit记录延迟直方图
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+    
+    ; irq_fast_exit可能开中断执行软中断，同样切换到中断栈
+    mov rbp, rsp
+    IRQ_STACK_ENTER
+    sub rsp, 16         ; 保存时间戳，保持16字节对齐
+    mov [rsp], rax
+    
+    mov rdi, [rbp + 80] ; 向量号
+    lea rax, [rel irq_fast_handlers]
+    call [rax + rdi * 8]
+    
+    mov rdi, [rbp + 80]
+    mov rsi, [rsp]
+    call irq_fast_exit
+    
+    IRQ_STACK_LEAVE
+    pop rbp
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
+    pop rax
+    
+    add rsp, 8          ; 清理中断号
+    iretq
+
+; 中断入口地址表，由idt_init遍历填充IDT
+section .rodata
+align 8
+interrupt_stub_table:
+%assign vec 0
+%rep 32
+    dq isr%[vec]
+%assign vec vec+1
+%endrep
+%rep 224
+    dq irq_stub_%[vec]
+%assign vec vec+1
+%endrep
+
+; 精简入口地址表（向量32-255）
+interrupt_fast_stub_table:
+%assign vec 32
+%rep 224
+    dq irq_fast_stub_%[vec]
+%assign vec vec+1
+%endrep
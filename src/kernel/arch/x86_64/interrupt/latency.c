@@ -0,0 +1,122 @@
+// Boruix OS x86_64中断延迟统计
+// 每个向量一个log2直方图，记录从irq_handler（或精简入口存根）入口到处理程序返回的周期数
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "kernel/irq_latency.h"
+
+static irq_hist_t duration_hist[256];
+
+// 时钟中断到达间隔
+static irq_hist_t jitter_hist;
+static uint64_t last_tick = 0;
+static uint64_t period_total = 0;
+static uint64_t period_samples = 0;
+
+static inline uint32_t hist_bucket(uint64_t cycles) {
+    if (cycles < 2) {
+        return 0;
+    }
+    uint32_t bucket = 63 - (uint32_t)__builtin_clzll(cycles);
+    return bucket < IRQ_HIST_BUCKETS ? bucket : IRQ_HIST_BUCKETS - 1;
+}
+
+void irq_hist_add(irq_hist_t* hist, uint64_t cycles) {
+    hist->buckets[hist_bucket(cycles)]++;
+    hist->count++;
+    if (cycles > hist->max) {
+        hist->max = cycles;
+    }
+}
+
+static void hist_clear(irq_hist_t* hist) {
+    for (int i = 0; i < IRQ_HIST_BUCKETS; i++) {
+        hist->buckets[i] = 0;
+    }
+    hist->count = 0;
+    hist->max = 0;
+}
+
+void irq_latency_record(uint8_t vector, uint64_t cycles) {
+    irq_hist_add(&duration_hist[vector], cycles);
+}
+
+void irq_latency_tick(uint64_t now) {
+    uint64_t last = last_tick;
+    last_tick = now;
+    if (last == 0 || now <= last) {
+        return;
+    }
+
+    uint64_t period = now - last;
+    period_total += period;
+    period_samples++;
+
+    // 抖动 = 本次间隔与平均间隔之差的绝对值
+    uint64_t avg = period_total / period_samples;
+    irq_hist_add(&jitter_hist, period > avg ? period - avg : avg - period);
+}
+
+void irq_latency_resync(void) {
+    last_tick = 0;
+}
+
+bool irq_latency_get_duration(uint8_t vector, irq_hist_t* out) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    *out = duration_hist[vector];
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return out->count > 0;
+}
+
+bool irq_latency_get_jitter(irq_hist_t* out, uint64_t* avg_period) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    *out = jitter_hist;
+    if (avg_period) {
+        *avg_period = period_samples ? period_total / period_samples : 0;
+    }
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return out->count > 0;
+}
+
+uint64_t irq_hist_percentile(const irq_hist_t* hist, uint32_t permille) {
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    // 需要覆盖的样本数（向上取整）
+    uint64_t target = (hist->count * permille + 999) / 1000;
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < IRQ_HIST_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= target) {
+            uint64_t upper = (b == IRQ_HIST_BUCKETS - 1) ? hist->max : (2ULL << b) - 1;
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void irq_latency_reset(void) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    for (int v = 0; v < 256; v++) {
+        hist_clear(&duration_hist[v]);
+    }
+    hist_clear(&jitter_hist);
+    last_tick = 0;
+    period_total = 0;
+    period_samples = 0;
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
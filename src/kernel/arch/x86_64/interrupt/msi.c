@@ -0,0 +1,283 @@
+// Boruix OS x86_64 PCI MSI/MSI-X 实现
+// 消息地址指向BSP的Local APIC，数据为向量号（固定投递、边沿触发）
+// MSI-X表通过VMM以UC方式映射，停用时取消映射并把地址段归还MMIO窗口
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "arch/apic.h"
+#include "arch/msi.h"
+#include "rust/rust_memory.h"
+#include "pci.h"
+
+// MSI消息地址
+#define MSI_ADDRESS_BASE        0xFEE00000ULL
+#define MSI_ADDRESS_DEST_SHIFT  12
+
+// MSI-X表项（每项16字节）
+#define MSIX_ENTRY_SIZE         16
+#define MSIX_ENTRY_ADDR_LOW     0
+#define MSIX_ENTRY_ADDR_HIGH    1
+#define MSIX_ENTRY_DATA         2
+#define MSIX_ENTRY_CONTROL      3
+#define MSIX_ENTRY_MASKED       0x1
+
+typedef struct {
+    int bound;                          // 槽位已绑定设备
+    size_t device_index;
+    uint32_t mode;                      // PCI_IRQ_MSI / PCI_IRQ_MSIX，0表示未启用
+    uint32_t count;
+    uint8_t vectors[PCI_MSI_MAX_VECTORS];
+    volatile uint32_t* msix_table;      // MSI-X表映射
+    uint32_t msix_table_size;
+} msi_device_t;
+
+static msi_device_t msi_devices[PCI_MSI_MAX_DEVICES];
+
+// 查找设备槽位，create非0时分配新槽位
+static msi_device_t* msi_slot(size_t device_index, int create) {
+    msi_device_t* free_slot = NULL;
+    for (int i = 0; i < PCI_MSI_MAX_DEVICES; i++) {
+        if (msi_devices[i].bound && msi_devices[i].device_index == device_index) {
+            return &msi_devices[i];
+        }
+        if (!msi_devices[i].bound && !free_slot) {
+            free_slot = &msi_devices[i];
+        }
+    }
+    if (!create || !free_slot) {
+        return NULL;
+    }
+    free_slot->bound = 1;
+    free_slot->device_index = device_index;
+    free_slot->mode = 0;
+    free_slot->msix_table = NULL;
+    return free_slot;
+}
+
+static uint64_t msix_table_bytes(const msi_device_t* dev) {
+    return (uint64_t)dev->msix_table_size * MSIX_ENTRY_SIZE;
+}
+
+// 取消MSI-X表映射
+static void msix_unmap_table(msi_device_t* dev) {
+    if (!dev->msix_table) {
+        return;
+    }
+    rust_vmm_unmap_mmio((uint64_t)dev->msix_table, msix_table_bytes(dev));
+    dev->msix_table = NULL;
+    dev->msix_table_size = 0;
+}
+
+// 释放未启用的槽位
+static void msi_slot_release(msi_device_t* dev) {
+    if (dev->mode == 0) {
+        msix_unmap_table(dev);
+        dev->bound = 0;
+    }
+}
+
+static uint64_t msi_address(void) {
+    return MSI_ADDRESS_BASE | ((uint64_t)(lapic_get_id() & 0xFF) << MSI_ADDRESS_DEST_SHIFT);
+}
+
+static volatile uint32_t* msix_entry(msi_device_t* dev, uint32_t nr) {
+    return dev->msix_table + nr * (MSIX_ENTRY_SIZE / 4);
+}
+
+// 映射MSI-X表
+static int msix_map_table(msi_device_t* dev, const pci_msi_info_t* info) {
+    if (dev->msix_table) {
+        return 0;
+    }
+    
+    pci_bar_info_t bar;
+    if (!pci_get_bar_info(dev->device_index, info->msix_table_bar, &bar) || bar.type == PCI_BAR_IO) {
+        return -1;
+    }
+    
+    uint64_t size = (uint64_t)info->msix_table_size * MSIX_ENTRY_SIZE;
+    uint64_t virt = rust_vmm_map_mmio(bar.address + info->msix_table_offset, size, RUST_CACHE_UC);
+    if (virt == 0) {
+        return -1;
+    }
+    
+    dev->msix_table = (volatile uint32_t*)virt;
+    dev->msix_table_size = info->msix_table_size;
+    return 0;
+}
+
+static int msix_enable(msi_device_t* dev, const pci_msi_info_t* info, uint32_t min_vecs, uint32_t max_vecs) {
+    uint32_t count = max_vecs;
+    if (count > info->msix_table_size) {
+        count = info->msix_table_size;
+    }
+    if (count < min_vecs || msix_map_table(dev, info) != 0) {
+        msix_unmap_table(dev);
+        return -1;
+    }
+    
+    // MSI-X各表项独立，向量不需要连续
+    uint32_t allocated = 0;
+    while (allocated < count) {
+        int vector = irq_alloc_vector();
+        if (vector < 0) {
+            break;
+        }
+        dev->vectors[allocated++] = (uint8_t)vector;
+    }
+    if (allocated < min_vecs) {
+        for (uint32_t i = 0; i < allocated; i++) {
+            irq_free_vector(dev->vectors[i]);
+        }
+        msix_unmap_table(dev);
+        return -1;
+    }
+    
+    // 先启用并整体屏蔽，写表项期间不会发出半更新的消息
+    pci_msix_set_control(dev->device_index, true, true);
+    
+    uint64_t address = msi_address();
+    for (uint32_t i = 0; i < dev->msix_table_size; i++) {
+        volatile uint32_t* entry = msix_entry(dev, i);
+        if (i < allocated) {
+            entry[MSIX_ENTRY_ADDR_LOW] = (uint32_t)address;
+            entry[MSIX_ENTRY_ADDR_HIGH] = (uint32_t)(address >> 32);
+            entry[MSIX_ENTRY_DATA] = dev->vectors[i];
+            entry[MSIX_ENTRY_CONTROL] = 0;
+        } else {
+            entry[MSIX_ENTRY_CONTROL] = MSIX_ENTRY_MASKED;
+        }
+    }
+    
+    pci_msix_set_control(dev->device_index, true, false);
+    
+    dev->mode = PCI_IRQ_MSIX;
+    dev->count = allocated;
+    return (int)allocated;
+}
+
+static int msi_enable(msi_device_t* dev, const pci_msi_info_t* info, uint32_t min_vecs, uint32_t max_vecs) {
+    // 多消息MSI只能启用2的幂个向量，且向量块按数量对齐
+    uint32_t count = 1;
+    uint8_t log2 = 0;
+    while (count * 2 <= max_vecs && count * 2 <= info->msi_max_vectors) {
+        count *= 2;
+        log2++;
+    }
+    if (count < min_vecs) {
+        return -1;
+    }
+    
+    int base = irq_alloc_vectors(count, count);
+    if (base < 0) {
+        return -1;
+    }
+    
+    if (!pci_msi_enable(dev->device_index, msi_address(), (uint16_t)base, log2)) {
+        for (uint32_t i = 0; i < count; i++) {
+            irq_free_vector((uint8_t)(base + i));
+        }
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        dev->vectors[i] = (uint8_t)(base + i);
+    }
+    dev->mode = PCI_IRQ_MSI;
+    dev->count = count;
+    return (int)count;
+}
+
+int pci_alloc_irq_vectors(size_t device_index, uint32_t min_vecs, uint32_t max_vecs, uint32_t flags) {
+    if (!apic_is_enabled() || min_vecs == 0 || min_vecs > max_vecs) {
+        return -1;
+    }
+    if (max_vecs > PCI_MSI_MAX_VECTORS) {
+        max_vecs = PCI_MSI_MAX_VECTORS;
+    }
+    
+    pci_msi_info_t info;
+    if (!pci_get_msi_info(device_index, &info)) {
+        return -1;
+    }
+    
+    msi_device_t* dev = msi_slot(device_index, 1);
+    if (!dev || dev->mode != 0) {
+        return -1;
+    }
+    
+    int result = -1;
+    if ((flags & PCI_IRQ_MSIX) && info.msix_offset != 0) {
+        result = msix_enable(dev, &info, min_vecs, max_vecs);
+    }
+    if (result < 0 && (flags & PCI_IRQ_MSI) && info.msi_offset != 0) {
+        result = msi_enable(dev, &info, min_vecs, max_vecs);
+    }
+    
+    if (result < 0) {
+        msi_slot_release(dev);
+    }
+    return result;
+}
+
+int pci_irq_vector(size_t device_index, uint32_t nr) {
+    msi_device_t* dev = msi_slot(device_index, 0);
+    if (!dev || dev->mode == 0 || nr >= dev->count) {
+        return -1;
+    }
+    return dev->vectors[nr];
+}
+
+uint32_t pci_irq_mode(size_t device_index) {
+    msi_device_t* dev = msi_slot(device_index, 0);
+    return dev ? dev->mode : 0;
+}
+
+int pci_msix_mask_vector(size_t device_index, uint32_t nr, int masked) {
+    msi_device_t* dev = msi_slot(device_index, 0);
+    if (!dev || dev->mode != PCI_IRQ_MSIX || nr >= dev->count) {
+        return -1;
+    }
+    volatile uint32_t* entry = msix_entry(dev, nr);
+    entry[MSIX_ENTRY_CONTROL] = masked ? MSIX_ENTRY_MASKED : 0;
+    return 0;
+}
+
+int msi_mask_vector(uint8_t vector, int masked) {
+    for (int i = 0; i < PCI_MSI_MAX_DEVICES; i++) {
+        msi_device_t* dev = &msi_devices[i];
+        if (!dev->bound || dev->mode != PCI_IRQ_MSIX) {
+            continue;
+        }
+        for (uint32_t nr = 0; nr < dev->count; nr++) {
+            if (dev->vectors[nr] == vector) {
+                msix_entry(dev, nr)[MSIX_ENTRY_CONTROL] = masked ? MSIX_ENTRY_MASKED : 0;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+void pci_free_irq_vectors(size_t device_index) {
+    msi_device_t* dev = msi_slot(device_index, 0);
+    if (!dev || dev->mode == 0) {
+        return;
+    }
+    
+    if (dev->mode == PCI_IRQ_MSIX) {
+        for (uint32_t i = 0; i < dev->count; i++) {
+            msix_entry(dev, i)[MSIX_ENTRY_CONTROL] = MSIX_ENTRY_MASKED;
+        }
+        pci_msix_set_control(device_index, false, false);
+    } else {
+        pci_msi_disable(device_index);
+    }
+    
+    for (uint32_t i = 0; i < dev->count; i++) {
+        irq_free_vector(dev->vectors[i]);
+    }
+    dev->mode = 0;
+    dev->count = 0;
+    msi_slot_release(dev);
+}
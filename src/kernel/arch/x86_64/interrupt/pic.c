@@ -13,6 +13,7 @@
 #define ICW1_INIT 0x10
 #define ICW1_ICW4 0x01
 #define ICW4_8086 0x01
+#define PIC_READ_IRR 0x0A  // OCW3：下次读命令端口返回IRR
 
 // I/O端口操作
 static inline void outb(uint16_t port, uint8_t value) {
@@ -29,6 +30,17 @@ static inline void io_wait(void) {
     outb(0x80, 0);
 }
 
+// 屏蔽寄存器 = 驱动设置的线路屏蔽 | 中断嵌套时的优先级屏蔽
+// 被屏蔽线路的边沿仍锁存在IRR中，解除屏蔽后重新投递
+static uint16_t line_mask = 0xFFFF;
+static uint16_t prio_mask = 0;
+
+static void pic_write_mask(void) {
+    uint16_t mask = line_mask | prio_mask;
+    outb(PIC1_DATA, (uint8_t)mask);
+    outb(PIC2_DATA, (uint8_t)(mask >> 8));
+}
+
 // 初始化PIC
 void pic_init(void) {
     uint8_t mask1 = inb(PIC1_DATA);
@@ -54,8 +66,15 @@ void pic_init(void) {
     outb(PIC2_DATA, ICW4_8086);
     io_wait();
     
-    outb(PIC1_DATA, mask1);
-    outb(PIC2_DATA, mask2);
+    line_mask = mask1 | ((uint16_t)mask2 << 8);
+    prio_mask = 0;
+    pic_write_mask();
+}
+
+// 屏蔽全部IRQ（切换到APIC后使用，重映射仍保留，伪中断不会落到异常向量）
+void pic_disable(void) {
+    line_mask = 0xFFFF;
+    pic_write_mask();
 }
 
 void pic_send_eoi(uint8_t irq) {
@@ -66,31 +85,32 @@ void pic_send_eoi(uint8_t irq) {
 }
 
 void pic_set_mask(uint8_t irq) {
-    uint16_t port;
-    uint8_t value;
-    
-    if (irq < 8) {
-        port = PIC1_DATA;
-    } else {
-        port = PIC2_DATA;
-        irq -= 8;
-    }
-    
-    value = inb(port) | (1 << irq);
-    outb(port, value);
+    line_mask |= (uint16_t)(1 << irq);
+    pic_write_mask();
 }
 
 void pic_clear_mask(uint8_t irq) {
-    uint16_t port;
-    uint8_t value;
-    
-    if (irq < 8) {
-        port = PIC1_DATA;
-    } else {
-        port = PIC2_DATA;
-        irq -= 8;
+    line_mask &= (uint16_t)~(1 << irq);
+    pic_write_mask();
+}
+
+uint16_t pic_get_priority_mask(void) {
+    return prio_mask;
+}
+
+// 设置优先级屏蔽，返回之前的值
+uint16_t pic_set_priority_mask(uint16_t mask) {
+    uint16_t old = prio_mask;
+    if (mask != old) {
+        prio_mask = mask;
+        pic_write_mask();
     }
-    
-    value = inb(port) & ~(1 << irq);
-    outb(port, value);
+    return old;
+}
+
+// 读取两片PIC的中断请求寄存器
+uint16_t pic_read_irr(void) {
+    outb(PIC1_COMMAND, PIC_READ_IRR);
+    outb(PIC2_COMMAND, PIC_READ_IRR);
+    return inb(PIC1_COMMAND) | ((uint16_t)inb(PIC2_COMMAND) << 8);
 }
@@ -1,8 +1,10 @@
 // Boruix OS x86_64中断优先级管理
-// 实现中断优先级控制和管理
+// 优先级决定ISA IRQ的路由向量（APIC）或嵌套时的屏蔽范围（PIC），
+// 低优先级中断在控制器中等待而不是被丢弃
 
 #include "kernel/types.h"
 #include "kernel/interrupt.h"
+#include "arch/percpu.h"
 
 // 中断优先级级别定义
 #define IRQ_PRIORITY_CRITICAL   0   // 关键优先级（最高）
@@ -31,30 +33,42 @@ static uint8_t irq_priorities[16] = {
     IRQ_PRIORITY_NORMAL     // IRQ15 - Secondary ATA
 };
 
-// 当前中断嵌套级别
-static uint8_t current_interrupt_level = IRQ_PRIORITY_DISABLED;
+// 当前中断级别、嵌套计数和被打断的外层级别（irq_exit时恢复）保存在每CPU页中
 
-// 中断嵌套计数
-static uint32_t interrupt_nesting_count = 0;
-
-// 被阻塞的中断计数
+// 被推迟的中断计数（处理更高优先级中断期间到达，退出时由硬件重新投递）
+// 推迟由控制器完成，软件只能在退出时读取IRR/ISA挂起位（端口I/O或LAPIC读）才能看到，
+// 因此默认关闭，由irqprio defer on打开后才在irq_exit中采样
 static uint64_t blocked_interrupt_counts[16] = {0};
+static volatile uint32_t defer_accounting = 0;
 
 // 初始化中断优先级系统
 void irq_priority_init(void) {
-    current_interrupt_level = IRQ_PRIORITY_DISABLED;
-    interrupt_nesting_count = 0;
+    this_cpu_write(interrupt_level, IRQ_PRIORITY_DISABLED);
+    this_cpu_write(interrupt_nesting, 0);
     
-    // 清空阻塞计数
+    // 清空阻塞计数，并按当前优先级路由各条线路
     for (int i = 0; i < 16; i++) {
         blocked_interrupt_counts[i] = 0;
+        irq_route_priority(i, irq_priorities[i]);
     }
 }
 
 // 设置IRQ优先级
 void irq_set_priority(uint8_t irq, uint8_t priority) {
     if (irq < 16 && priority <= IRQ_PRIORITY_LOW) {
+        bool was_enabled = interrupts_enabled();
+        interrupts_disable();
+        
+        bool was_disabled = irq_priorities[irq] == IRQ_PRIORITY_DISABLED;
         irq_priorities[irq] = priority;
+        irq_route_priority(irq, priority);
+        if (was_disabled && irq_get_action_count(IRQ_BASE + irq) > 0 && !irq_storm_is_polling(IRQ_BASE + irq)) {
+            irq_unmask_line(irq);
+        }
+        
+        if (was_enabled) {
+            interrupts_enable();
+        }
     }
 }
 
@@ -66,8 +80,8 @@ uint8_t irq_get_priority(uint8_t irq) {
     return IRQ_PRIORITY_DISABLED;
 }
 
-// 检查中断是否应该被允许执行
-// 返回true表示允许，false表示应该被阻塞
+// 检查中断此刻到达能否打断当前处理程序
+// 返回true表示会立即执行，false表示会被推迟到当前处理程序结束
 bool irq_should_execute(uint8_t irq) {
     if (irq >= 16) {
         return false;
@@ -81,48 +95,66 @@ bool irq_should_execute(uint8_t irq) {
     }
     
     // 如果没有中断正在执行，允许所有中断
-    if (current_interrupt_level == IRQ_PRIORITY_DISABLED) {
+    uint8_t current = this_cpu_read(interrupt_level);
+    if (current == IRQ_PRIORITY_DISABLED) {
         return true;
     }
     
     // 只有优先级更高（数值更小）的中断才能打断当前中断
-    if (priority < current_interrupt_level) {
+    if (priority < current) {
         return true;
     }
     
-    // 否则阻塞该中断
-    blocked_interrupt_counts[irq]++;
     return false;
 }
 
-// 进入中断处理（在IRQ处理程序开始时调用）
+// 进入中断处理（关中断调用，在提高控制器优先级之后）
 void irq_enter(uint8_t irq) {
     if (irq < 16) {
-        current_interrupt_level = irq_priorities[irq];
-        interrupt_nesting_count++;
+        uint32_t nesting = this_cpu_read(interrupt_nesting);
+        if (nesting < IRQ_MAX_NESTING) {
+            this_cpu_write_idx(level_stack, nesting, this_cpu_read(interrupt_level));
+        }
+        this_cpu_write(interrupt_level, irq_priorities[irq]);
+        this_cpu_inc(interrupt_nesting);
     }
 }
 
-// 退出中断处理（在IRQ处理程序结束时调用）
+// 退出中断处理（关中断调用，在恢复控制器优先级之前）
 void irq_exit(void) {
-    if (interrupt_nesting_count > 0) {
-        interrupt_nesting_count--;
+    uint32_t nesting = this_cpu_read(interrupt_nesting);
+    if (nesting == 0) {
+        return;
     }
     
-    // 如果没有嵌套中断，恢复到禁用状态
-    if (interrupt_nesting_count == 0) {
-        current_interrupt_level = IRQ_PRIORITY_DISABLED;
+    // 统计本级处理期间被推迟的线路，它们会在优先级恢复后重新投递
+    if (defer_accounting) {
+        uint16_t pending = irq_pending_lines();
+        uint8_t current = this_cpu_read(interrupt_level);
+        for (int i = 0; pending && i < 16; i++) {
+            if ((pending & (1 << i)) && irq_priorities[i] >= current) {
+                blocked_interrupt_counts[i]++;
+            }
+        }
+    }
+    
+    nesting--;
+    this_cpu_write(interrupt_nesting, nesting);
+    if (nesting < IRQ_MAX_NESTING) {
+        this_cpu_write(interrupt_level, this_cpu_read_idx(level_stack, nesting));
+    } else {
+        this_cpu_write(interrupt_level, IRQ_PRIORITY_DISABLED);
     }
 }
 
 // 获取当前中断级别
 uint8_t irq_get_current_level(void) {
-    return current_interrupt_level;
+    return this_cpu_read(interrupt_level);
 }
 
 // 获取中断嵌套计数
 uint32_t irq_get_nesting_count(void) {
-    return interrupt_nesting_count;
+    return this_cpu_read(interrupt_nesting);
 }
 
 // 获取被阻塞的中断计数
@@ -133,6 +165,20 @@ uint64_t irq_get_blocked_count(uint8_t irq) {
     return 0;
 }
 
+// 打开或关闭推迟统计，打开时清零计数
+void irq_defer_accounting_enable(int enable) {
+    if (enable && !defer_accounting) {
+        for (int i = 0; i < 16; i++) {
+            blocked_interrupt_counts[i] = 0;
+        }
+    }
+    defer_accounting = enable ? 1 : 0;
+}
+
+int irq_defer_accounting_enabled(void) {
+    return defer_accounting != 0;
+}
+
 // 获取优先级名称（用于显示）
 const char* irq_get_priority_name(uint8_t priority) {
     switch (priority) {
@@ -151,10 +197,11 @@ const char* irq_get_priority_name(uint8_t priority) {
     }
 }
 
-// 禁用IRQ
+// 禁用IRQ（屏蔽线路，不再投递）
 void irq_disable(uint8_t irq) {
     if (irq < 16) {
         irq_priorities[irq] = IRQ_PRIORITY_DISABLED;
+        irq_mask_line(irq);
     }
 }
 
@@ -167,18 +214,18 @@ void irq_enable(uint8_t irq) {
     // 根据IRQ类型设置默认优先级
     switch (irq) {
         case 0:  // Timer
-            irq_priorities[irq] = IRQ_PRIORITY_CRITICAL;
+            irq_set_priority(irq, IRQ_PRIORITY_CRITICAL);
             break;
         case 1:  // Keyboard
         case 12: // Mouse
-            irq_priorities[irq] = IRQ_PRIORITY_HIGH;
+            irq_set_priority(irq, IRQ_PRIORITY_HIGH);
             break;
         case 5:  // LPT2
         case 7:  // LPT1
-            irq_priorities[irq] = IRQ_PRIORITY_LOW;
+            irq_set_priority(irq, IRQ_PRIORITY_LOW);
             break;
         default:
-            irq_priorities[irq] = IRQ_PRIORITY_NORMAL;
+            irq_set_priority(irq, IRQ_PRIORITY_NORMAL);
             break;
     }
 }
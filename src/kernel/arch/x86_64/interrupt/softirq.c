@@ -0,0 +1,213 @@
+// Boruix OS x86_64软中断与tasklet
+// 硬中断处理程序登记待处理位，irq_handler在退出前开中断依次执行，带轮数预算
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+#include "arch/x86_64.h"
+#include "arch/percpu.h"
+
+// 待处理位图、执行标志和tasklet队列在每CPU页中（softirq_pending等），
+// 软中断在登记它的CPU上执行
+
+static softirq_handler_t softirq_handlers[SOFTIRQ_COUNT];
+static uint64_t softirq_counts[SOFTIRQ_COUNT];
+static uint64_t deferred_count = 0;
+
+// 硬中断的关中断窗口；软中断处理程序开中断运行，单独统计整轮执行时间
+static irq_window_stats_t hardirq_window;
+static irq_window_stats_t softirq_run;
+
+static const char* softirq_names[SOFTIRQ_COUNT] = {
+    "HI",
+    "TIMER",
+    "TASKLET"
+};
+
+static bool softirq_lock(void) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    return was_enabled;
+}
+
+static void softirq_unlock(bool was_enabled) {
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
+
+static void window_account(irq_window_stats_t* stats, uint64_t cycles) {
+    stats->samples++;
+    stats->total_cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+}
+
+// 取出本CPU的整条tasklet队列并逐个执行（开中断调用）
+static void tasklet_run_list(int queue) {
+    interrupts_disable();
+    tasklet_t* t = this_cpu_read_idx(tasklet_head, queue);
+    this_cpu_write_idx(tasklet_head, queue, (tasklet_t*)NULL);
+    interrupts_enable();
+
+    while (t) {
+        tasklet_t* next = t->next;
+        // 先清除调度标志，执行期间可以被重新调度
+        t->state &= ~TASKLET_STATE_SCHED;
+        t->func(t->data);
+        t = next;
+    }
+}
+
+static void tasklet_action(void) {
+    tasklet_run_list(0);
+}
+
+static void tasklet_hi_action(void) {
+    tasklet_run_list(1);
+}
+
+void softirq_init(void) {
+    this_cpu_write(softirq_pending, 0);
+    this_cpu_write(softirq_active, 0);
+    for (int i = 0; i < 2; i++) {
+        this_cpu_write_idx(tasklet_head, i, (tasklet_t*)NULL);
+    }
+
+    for (int i = 0; i < SOFTIRQ_COUNT; i++) {
+        softirq_handlers[i] = NULL;
+        softirq_counts[i] = 0;
+    }
+    deferred_count = 0;
+    irq_reset_window_stats();
+
+    open_softirq(SOFTIRQ_HI, tasklet_hi_action);
+    open_softirq(SOFTIRQ_TASKLET, tasklet_action);
+}
+
+void open_softirq(uint32_t nr, softirq_handler_t handler) {
+    if (nr < SOFTIRQ_COUNT) {
+        softirq_handlers[nr] = handler;
+    }
+}
+
+void raise_softirq(uint32_t nr) {
+    if (nr >= SOFTIRQ_COUNT) {
+        return;
+    }
+    this_cpu_or(softirq_pending, 1u << nr);
+}
+
+bool softirq_pending(void) {
+    return this_cpu_read(softirq_pending) != 0;
+}
+
+void do_softirq(void) {
+    if (this_cpu_read(softirq_active) || this_cpu_read(softirq_pending) == 0) {
+        return;
+    }
+    this_cpu_write(softirq_active, 1);
+
+    uint64_t start = cpu_rdtsc();
+    int restart = SOFTIRQ_MAX_RESTART;
+
+    do {
+        uint32_t pending = this_cpu_read(softirq_pending);
+        this_cpu_write(softirq_pending, 0);
+
+        // 处理程序在开中断状态下运行，期间到来的硬中断可以继续登记
+        interrupts_enable();
+        for (uint32_t nr = 0; nr < SOFTIRQ_COUNT; nr++) {
+            if ((pending & (1u << nr)) && softirq_handlers[nr]) {
+                softirq_handlers[nr]();
+                softirq_counts[nr]++;
+            }
+        }
+        interrupts_disable();
+    } while (this_cpu_read(softirq_pending) && --restart > 0);
+
+    // 预算用完，剩余工作留给下一次中断退出
+    if (this_cpu_read(softirq_pending)) {
+        deferred_count++;
+    }
+
+    window_account(&softirq_run, cpu_rdtsc() - start);
+    this_cpu_write(softirq_active, 0);
+}
+
+void tasklet_init(tasklet_t* t, void (*func)(uintptr_t data), uintptr_t data) {
+    t->next = NULL;
+    t->func = func;
+    t->data = data;
+    t->state = 0;
+}
+
+static void tasklet_enqueue(tasklet_t* t, int queue, uint32_t nr) {
+    bool state = softirq_lock();
+    if (!(t->state & TASKLET_STATE_SCHED)) {
+        t->state |= TASKLET_STATE_SCHED;
+        t->next = NULL;
+        if (this_cpu_read_idx(tasklet_head, queue) == NULL) {
+            this_cpu_write_idx(tasklet_head, queue, t);
+        } else {
+            this_cpu_read_idx(tasklet_tail, queue)->next = t;
+        }
+        this_cpu_write_idx(tasklet_tail, queue, t);
+        raise_softirq(nr);
+    }
+    softirq_unlock(state);
+}
+
+void tasklet_schedule(tasklet_t* t) {
+    tasklet_enqueue(t, 0, SOFTIRQ_TASKLET);
+}
+
+void tasklet_hi_schedule(tasklet_t* t) {
+    tasklet_enqueue(t, 1, SOFTIRQ_HI);
+}
+
+uint64_t softirq_get_count(uint32_t nr) {
+    if (nr < SOFTIRQ_COUNT) {
+        return softirq_counts[nr];
+    }
+    return 0;
+}
+
+uint64_t softirq_get_deferred_count(void) {
+    return deferred_count;
+}
+
+const char* softirq_get_name(uint32_t nr) {
+    if (nr < SOFTIRQ_COUNT) {
+        return softirq_names[nr];
+    }
+    return "Unknown";
+}
+
+void irq_account_off_window(uint64_t cycles) {
+    window_account(&hardirq_window, cycles);
+}
+
+void irq_get_off_window_stats(irq_window_stats_t* hardirq) {
+    bool state = softirq_lock();
+    *hardirq = hardirq_window;
+    softirq_unlock(state);
+}
+
+void softirq_get_run_stats(irq_window_stats_t* run) {
+    bool state = softirq_lock();
+    *run = softirq_run;
+    softirq_unlock(state);
+}
+
+void irq_reset_window_stats(void) {
+    bool state = softirq_lock();
+    hardirq_window.samples = 0;
+    hardirq_window.total_cycles = 0;
+    hardirq_window.max_cycles = 0;
+    softirq_run.samples = 0;
+    softirq_run.total_cycles = 0;
+    softirq_run.max_cycles = 0;
+    softirq_unlock(state);
+}
@@ -0,0 +1,149 @@
+// Boruix OS x86_64中断风暴检测
+// 按逻辑向量统计窗口内的中断数（ISA线路、GSI路由的动态向量和MSI/MSI-X），
+// 超过阈值时屏蔽中断源并改为定时器轮询（类似NAPI），轮询连续若干次无事可做后重新打开中断；
+// 反复风暴时恢复条件按倍数放宽。无法屏蔽的向量（多消息MSI）只记录风暴次数
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "drivers/timer.h"
+#include "drivers/ktimer.h"
+
+typedef struct {
+    uint32_t window_start;      // 当前窗口起始滴答
+    uint32_t window_count;      // 窗口内中断数
+    bool polling;               // 处于轮询模式
+    uint32_t quiet_polls;       // 连续空轮询次数
+    uint32_t backoff;           // 恢复所需空轮询次数的倍数
+    uint32_t last_recovery;     // 上次恢复中断模式的滴答
+    uint32_t storms;            // 进入轮询模式的次数
+    uint32_t recoveries;        // 恢复中断模式的次数
+    uint64_t polls;             // 轮询次数
+} irq_storm_t;
+
+static irq_storm_t storm_vectors[256];
+static uint64_t polling_mask[4];    // 处于轮询模式的向量位图
+
+static ktimer_t poll_timer;
+static bool poll_timer_ready = false;
+
+static bool any_polling(void) {
+    return (polling_mask[0] | polling_mask[1] | polling_mask[2] | polling_mask[3]) != 0;
+}
+
+// 恢复中断模式（关中断调用），被禁用的ISA线路保持屏蔽
+static void storm_recover(uint8_t vector, irq_storm_t* line) {
+    polling_mask[vector / 64] &= ~(1ULL << (vector % 64));
+    line->polling = false;
+    line->recoveries++;
+    line->last_recovery = system_ticks;
+    line->window_start = system_ticks;
+    line->window_count = 0;
+
+    uint8_t irq = irq_vector_to_line(vector);
+    if (irq >= 16 || irq_get_priority(irq) != IRQ_PRIORITY_DISABLED) {
+        irq_mask_vector(vector, false);
+    }
+}
+
+// 轮询：每个滴答在TIMER软中断中开中断调用被屏蔽向量的处理程序，它们会自行检查设备状态
+static void irq_poll_lines(uintptr_t data) {
+    (void)data;
+
+    for (uint32_t word = 0; word < 4; word++) {
+        uint64_t bits = polling_mask[word];
+        while (bits) {
+            uint8_t vector = (uint8_t)(word * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+
+            irq_storm_t* line = &storm_vectors[vector];
+            line->polls++;
+            // 轮询本来就可能无事可做，不计入未处理次数
+            if (irq_poll_vector(vector) == IRQ_HANDLED) {
+                line->quiet_polls = 0;
+                continue;
+            }
+
+            if (++line->quiet_polls < IRQ_STORM_QUIET_POLLS * line->backoff) {
+                continue;
+            }
+
+            // 平静下来，恢复中断模式
+            bool was_enabled = interrupts_enabled();
+            interrupts_disable();
+            storm_recover(vector, line);
+            if (was_enabled) {
+                interrupts_enable();
+            }
+        }
+    }
+
+    // 还有向量在轮询，下一个滴答继续
+    if (any_polling()) {
+        timer_mod(&poll_timer, system_ticks + 1);
+    }
+}
+
+bool irq_storm_account(uint8_t vector) {
+    // IRQ0驱动时钟和轮询本身，不能屏蔽
+    if (vector == IRQ_BASE) {
+        return false;
+    }
+
+    irq_storm_t* line = &storm_vectors[vector];
+    uint32_t now = system_ticks;
+    if (now - line->window_start >= IRQ_STORM_WINDOW_TICKS) {
+        line->window_start = now;
+        line->window_count = 0;
+    }
+
+    if (++line->window_count <= IRQ_STORM_THRESHOLD || line->polling) {
+        return false;
+    }
+
+    // 中断源无法屏蔽时只记录，下一个窗口重新计数
+    if (irq_mask_vector(vector, true) != 0) {
+        line->storms++;
+        line->window_start = now;
+        line->window_count = 0;
+        return false;
+    }
+
+    if (!poll_timer_ready) {
+        timer_setup(&poll_timer, irq_poll_lines, 0);
+        poll_timer_ready = true;
+    }
+
+    // 刚恢复不久又发生风暴，加倍恢复所需的空轮询次数
+    if (line->recoveries > 0 && now - line->last_recovery < IRQ_STORM_WINDOW_TICKS * 10) {
+        if (line->backoff < IRQ_STORM_MAX_BACKOFF) {
+            line->backoff *= 2;
+        }
+    } else {
+        line->backoff = 1;
+    }
+
+    line->polling = true;
+    line->quiet_polls = 0;
+    line->storms++;
+    polling_mask[vector / 64] |= 1ULL << (vector % 64);
+    if (!timer_pending(&poll_timer)) {
+        timer_add(&poll_timer, system_ticks + 1);
+    }
+    return true;
+}
+
+bool irq_storm_is_polling(uint8_t vector) {
+    return storm_vectors[vector].polling;
+}
+
+uint32_t irq_storm_get_count(uint8_t vector) {
+    return storm_vectors[vector].storms;
+}
+
+uint32_t irq_storm_get_recoveries(uint8_t vector) {
+    return storm_vectors[vector].recoveries;
+}
+
+uint64_t irq_storm_get_polls(uint8_t vector) {
+    return storm_vectors[vector].polls;
+}
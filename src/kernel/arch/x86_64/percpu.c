@@ -0,0 +1,68 @@
+// Boruix OS x86_64每CPU数据
+// BSP的页静态分配（在内存管理器和GDT之前就可用），AP的页由BSP在唤醒前分配
+
+#include "arch/percpu.h"
+#include "arch/smp.h"
+#include "arch/x86_64.h"
+#include "kernel/interrupt.h"
+#include "rust/rust_memory.h"
+
+#define PERCPU_PAGE_SIZE 4096
+
+typedef union {
+    percpu_t percpu;
+    uint8_t page[PERCPU_PAGE_SIZE];
+} percpu_page_t;
+
+_Static_assert(sizeof(percpu_t) <= PERCPU_PAGE_SIZE, "percpu_t must fit in one page");
+_Static_assert(PERCPU_OFFSET(irq_stack_top) == PERCPU_IRQ_STACK_TOP, "isr.asm offset");
+_Static_assert(PERCPU_OFFSET(irq_stack_nesting) == PERCPU_IRQ_STACK_NEST, "isr.asm offset");
+
+// BSP的页在GDT/TSS初始化前就要使用，静态初始化自指针和中断优先级
+static percpu_page_t bsp_page __attribute__((aligned(PERCPU_PAGE_SIZE))) = {
+    .percpu = {
+        .self = &bsp_page.percpu,
+        .interrupt_level = IRQ_PRIORITY_DISABLED,
+    }
+};
+static percpu_t* percpu_areas[SMP_MAX_CPUS] = { &bsp_page.percpu };
+
+static void percpu_clear(percpu_t* pc) {
+    for (uint32_t i = 0; i < sizeof(percpu_page_t); i++) {
+        ((uint8_t*)pc)[i] = 0;
+    }
+}
+
+int percpu_alloc(uint32_t cpu, uint32_t apic_id) {
+    if (cpu >= SMP_MAX_CPUS) {
+        return -1;
+    }
+
+    percpu_t* pc = percpu_areas[cpu];
+    if (pc == NULL) {
+        uint64_t phys = rust_alloc_page();
+        if (phys == 0) {
+            return -1;
+        }
+        pc = (percpu_t*)(phys + rust_get_hhdm_offset());
+        percpu_clear(pc);
+        percpu_areas[cpu] = pc;
+    }
+
+    pc->self = pc;
+    pc->cpu = cpu;
+    pc->apic_id = apic_id;
+    pc->interrupt_level = IRQ_PRIORITY_DISABLED;
+    return 0;
+}
+
+void percpu_load(uint32_t cpu) {
+    cpu_write_msr(MSR_IA32_GS_BASE, (uint64_t)percpu_areas[cpu]);
+}
+
+percpu_t* percpu_area(uint32_t cpu) {
+    if (cpu >= SMP_MAX_CPUS) {
+        return NULL;
+    }
+    return percpu_areas[cpu];
+}
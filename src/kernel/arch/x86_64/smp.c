@@ -0,0 +1,159 @@
+// Boruix OS x86_64多处理器启动
+// BSP为每个AP分配每CPU页、内核栈和TSS后写入Limine的goto_address；AP切换到BSP的页表和自己的栈，
+// 加载GDT/TSS/IDT并启用Local APIC，然后停在空闲循环中
+
+#include "arch/smp.h"
+#include "arch/gdt.h"
+#include "arch/tss.h"
+#include "arch/apic.h"
+#include "arch/percpu.h"
+#include "drivers/display.h"
+#include "drivers/delay.h"
+#include "rust/rust_memory.h"
+
+extern void idt_load_cpu(void);
+
+// AP内核栈页数（保护页另计）
+#define SMP_AP_STACK_PAGES 4
+
+static smp_cpu_t cpus[SMP_MAX_CPUS];
+static uint32_t cpu_count = 1;
+static volatile uint32_t online_count = 1;
+
+// AP切换到的页表（BSP的CR3）
+static uint64_t kernel_cr3 = 0;
+
+__attribute__((noreturn)) static void ap_main(smp_cpu_t* self) {
+    rust_cpu_init();
+    gdt_init_cpu(self->cpu);
+    idt_load_cpu();
+    lapic_init_ap();
+
+    __atomic_store_n(&self->online, true, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&online_count, 1, __ATOMIC_RELEASE);
+
+    // 中断栈和中断统计已是每CPU的，但软中断、定时器等子系统仍假定单CPU且没有锁，
+    // AP保持关中断，只响应NMI和INIT
+    for (;;) {
+        __asm__ volatile("cli; hlt");
+    }
+}
+
+// Limine在AP上调用的入口：此时仍在引导器提供的栈上，先切换页表和栈
+static void ap_entry(struct limine_smp_info* info) {
+    smp_cpu_t* self = (smp_cpu_t*)info->extra_argument;
+    __asm__ volatile("mov %0, %%cr3" : : "r"(kernel_cr3) : "memory");
+    __asm__ volatile(
+        "mov %0, %%rsp\n"
+        "xor %%ebp, %%ebp\n"
+        "call *%1\n"
+        : : "r"(self->stack_top), "r"(ap_main), "D"(self) : "memory");
+    __builtin_unreachable();
+}
+
+// 为AP分配每CPU页、栈和TSS，返回0成功
+static int smp_prepare_cpu(smp_cpu_t* cpu) {
+    if (percpu_alloc(cpu->cpu, cpu->apic_id) != 0) {
+        return -1;
+    }
+    cpu->stack_top = rust_kstack_alloc(SMP_AP_STACK_PAGES);
+    if (cpu->stack_top == 0) {
+        return -1;
+    }
+    if (tss_init_cpu(cpu->cpu) != 0) {
+        rust_kstack_free(cpu->stack_top);
+        cpu->stack_top = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void smp_init(struct limine_smp_response* response) {
+    cpus[0].cpu = 0;
+    cpus[0].apic_id = lapic_get_id();
+    cpus[0].acpi_id = 0;
+    cpus[0].stack_top = 0;
+    cpus[0].online = true;
+    percpu_alloc(0, cpus[0].apic_id);
+
+    if (response == NULL) {
+        print_string("[SMP] No SMP response from bootloader, running on BSP only\n");
+        return;
+    }
+    if (!apic_is_enabled()) {
+        print_string("[SMP] APIC not enabled, application processors left parked\n");
+        return;
+    }
+
+    __asm__ volatile("mov %%cr3, %0" : "=r"(kernel_cr3));
+
+    uint32_t started = 0;
+    for (uint64_t i = 0; i < response->cpu_count; i++) {
+        struct limine_smp_info* info = response->cpus[i];
+        if (info->lapic_id == response->bsp_lapic_id) {
+            cpus[0].acpi_id = info->processor_id;
+            continue;
+        }
+        if (cpu_count >= SMP_MAX_CPUS) {
+            print_string("[SMP] Too many CPUs, ignoring APIC ID ");
+            print_dec(info->lapic_id);
+            print_string("\n");
+            continue;
+        }
+
+        smp_cpu_t* cpu = &cpus[cpu_count];
+        cpu->cpu = cpu_count;
+        cpu->apic_id = info->lapic_id;
+        cpu->acpi_id = info->processor_id;
+        cpu->online = false;
+        if (smp_prepare_cpu(cpu) != 0) {
+            print_string("[SMP] Out of memory for CPU with APIC ID ");
+            print_dec(info->lapic_id);
+            print_string("\n");
+            continue;
+        }
+        cpu_count++;
+        started++;
+
+        // 写入goto_address后AP立即开始执行
+        info->extra_argument = (uint64_t)cpu;
+        __atomic_store_n(&info->goto_address, ap_entry, __ATOMIC_SEQ_CST);
+    }
+
+    // AP并行初始化，总等待时间按AP数量放宽
+    uint32_t timeout_us = started * SMP_AP_TIMEOUT_MS * 1000;
+    for (uint32_t waited = 0; online_count < cpu_count && waited < timeout_us; waited += 100) {
+        udelay(100);
+    }
+
+    for (uint32_t i = 1; i < cpu_count; i++) {
+        if (!cpus[i].online) {
+            print_string("[SMP] CPU ");
+            print_dec(i);
+            print_string(" (APIC ID ");
+            print_dec(cpus[i].apic_id);
+            print_string(") did not come online\n");
+        }
+    }
+
+    print_string("[SMP] ");
+    print_dec(online_count);
+    print_string(" of ");
+    print_dec(cpu_count);
+    print_string(" CPU(s) online\n");
+}
+
+uint32_t smp_cpu_count(void) {
+    return cpu_count;
+}
+
+uint32_t smp_online_count(void) {
+    return online_count;
+}
+
+const smp_cpu_t* smp_get_cpu(uint32_t cpu) {
+    if (cpu >= cpu_count) {
+        return NULL;
+    }
+    return &cpus[cpu];
+}
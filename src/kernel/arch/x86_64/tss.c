@@ -1,8 +1,13 @@
 // Boruix OS x86_64 TSS (Task State Segment) 实现
-// 用于双重错误处理的独立栈
+// 双重错误、NMI、机器检查和调试异常使用独立的IST栈，外部中断使用独立的中断栈
+// 每个CPU一个TSS，AP的IST栈在唤醒前由BSP分配
 
 #include "kernel/types.h"
 #include "drivers/display.h"
+#include "rust/rust_memory.h"
+#include "arch/tss.h"
+#include "arch/smp.h"
+#include "arch/percpu.h"
 
 // x86_64 TSS结构（简化版，只包含必要字段）
 typedef struct {
@@ -15,12 +20,25 @@ typedef struct {
     uint16_t iomap_base;
 } __attribute__((packed)) tss_t;
 
-// 全局TSS实例
-static tss_t tss;
+// 每CPU的TSS实例（[0]为BSP）
+static tss_t tss[SMP_MAX_CPUS];
 
-// 双重错误独立栈（4KB）
-#define DOUBLE_FAULT_STACK_SIZE 4096
-static uint8_t double_fault_stack[DOUBLE_FAULT_STACK_SIZE] __attribute__((aligned(16)));
+// IST独立栈
+// 优先使用带保护页的内核栈，内存管理器不可用时退回静态栈（每个4KB）
+#define IST_FALLBACK_STACK_SIZE 4096
+static uint8_t ist_fallback_stacks[IST_COUNT][IST_FALLBACK_STACK_SIZE] __attribute__((aligned(16)));
+static uint64_t double_fault_stack_top = 0;
+
+static const char* ist_names[IST_COUNT] = {
+    "Double Fault",
+    "NMI",
+    "Machine Check",
+    "Debug"
+};
+
+// 外部中断栈：每个CPU一个，该CPU的所有IRQ共用，反复使用保持在缓存中，嵌套中断不会压在任务栈上
+// 栈顶和嵌套深度保存在每CPU页中；BSP的静态退回栈同样16KB
+static uint8_t irq_fallback_stack[IRQ_STACK_PAGES * 4096] __attribute__((aligned(16)));
 
 // GDT中的TSS描述符
 typedef struct {
@@ -37,23 +55,37 @@ typedef struct {
 // 外部汇编函数
 extern void tss_load(uint16_t selector);
 
-// 初始化TSS
-void tss_init(void) {
-    // 清零TSS结构
+static void tss_clear(tss_t* t) {
     for (uint32_t i = 0; i < sizeof(tss_t); i++) {
-        ((uint8_t*)&tss)[i] = 0;
+        ((uint8_t*)t)[i] = 0;
     }
+    // 设置IOMAP基址（指向TSS末尾，表示没有I/O权限位图）
+    t->iomap_base = sizeof(tss_t);
+}
+
+// 初始化TSS
+void tss_init(void) {
+    tss_t* bsp = &tss[0];
+    tss_clear(bsp);
     
-    // 设置IST1为双重错误栈（栈顶地址）
-    tss.ist[0] = (uint64_t)&double_fault_stack[DOUBLE_FAULT_STACK_SIZE];
-    
-    // 设置其他IST为0（未使用）
-    for (int i = 1; i < 7; i++) {
-        tss.ist[i] = 0;
+    // IST1-4：双重错误、NMI、机器检查、调试异常（栈顶地址）
+    // IST5-7未使用，保持为0
+    for (int i = 0; i < IST_COUNT; i++) {
+        uint64_t top = rust_kstack_alloc(RUST_KSTACK_DEFAULT_PAGES);
+        if (top == 0) {
+            top = (uint64_t)&ist_fallback_stacks[i][IST_FALLBACK_STACK_SIZE];
+        }
+        bsp->ist[i] = top;
     }
+    double_fault_stack_top = bsp->ist[IST_DOUBLE_FAULT - 1];
     
-    // 设置IOMAP基址（指向TSS末尾，表示没有I/O权限位图）
-    tss.iomap_base = sizeof(tss_t);
+    // 外部中断栈
+    percpu_t* pc = percpu_area(0);
+    pc->irq_stack_top = rust_kstack_alloc(IRQ_STACK_PAGES);
+    if (pc->irq_stack_top == 0) {
+        pc->irq_stack_top = (uint64_t)&irq_fallback_stack[sizeof(irq_fallback_stack)];
+    }
+    pc->irq_stack_nesting = 0;
     
     // 注意：TSS将由GDT模块加载
     // 这里只需要初始化TSS结构体
@@ -61,19 +93,75 @@ void tss_init(void) {
     (void)tss_load;  // 避免未使用警告（tss_load由gdt_init调用）
     
     print_string("[TSS] Task State Segment initialized\n");
-    print_string("[TSS] Double Fault Stack at: 0x");
-    print_hex((uint32_t)((uint64_t)double_fault_stack >> 32));
-    print_hex((uint32_t)double_fault_stack);
+    for (int i = 0; i < IST_COUNT; i++) {
+        print_string("[TSS] IST");
+        print_dec(i + 1);
+        print_string(" (");
+        print_string(ist_names[i]);
+        print_string(") stack top: 0x");
+        print_hex((uint32_t)(bsp->ist[i] >> 32));
+        print_hex((uint32_t)bsp->ist[i]);
+        print_string("\n");
+    }
+    print_string("[TSS] IRQ stack top: 0x");
+    print_hex((uint32_t)(pc->irq_stack_top >> 32));
+    print_hex((uint32_t)pc->irq_stack_top);
     print_string("\n");
 }
 
+int tss_init_cpu(uint32_t cpu) {
+    percpu_t* pc = percpu_area(cpu);
+    if (cpu == 0 || cpu >= SMP_MAX_CPUS || pc == NULL) {
+        return -1;
+    }
+    tss_t* t = &tss[cpu];
+    tss_clear(t);
+    
+    // AP没有静态退回栈，分配失败时释放已分配的栈
+    for (int i = 0; i < IST_COUNT; i++) {
+        uint64_t top = rust_kstack_alloc(RUST_KSTACK_DEFAULT_PAGES);
+        if (top == 0) {
+            for (int j = 0; j < i; j++) {
+                rust_kstack_free(t->ist[j]);
+                t->ist[j] = 0;
+            }
+            return -1;
+        }
+        t->ist[i] = top;
+    }
+    
+    // 中断栈写入AP的每CPU页（AP开中断前就绪）
+    pc->irq_stack_top = rust_kstack_alloc(IRQ_STACK_PAGES);
+    if (pc->irq_stack_top == 0) {
+        for (int i = 0; i < IST_COUNT; i++) {
+            rust_kstack_free(t->ist[i]);
+            t->ist[i] = 0;
+        }
+        return -1;
+    }
+    pc->irq_stack_nesting = 0;
+    return 0;
+}
+
 // 获取TSS基址（用于调试）
 uint64_t tss_get_base(void) {
-    return (uint64_t)&tss;
+    return (uint64_t)&tss[0];
+}
+
+uint64_t tss_get_base_cpu(uint32_t cpu) {
+    return (uint64_t)&tss[cpu];
 }
 
 // 获取双重错误栈地址（用于调试）
 uint64_t tss_get_double_fault_stack(void) {
-    return (uint64_t)&double_fault_stack[DOUBLE_FAULT_STACK_SIZE];
+    return double_fault_stack_top;
+}
+
+// 获取IST栈顶
+uint64_t tss_get_ist_stack(uint8_t ist) {
+    if (ist == 0 || ist > 7) {
+        return 0;
+    }
+    return tss[0].ist[ist - 1];
 }
 
@@ -1,9 +1,19 @@
 // Boruix OS CMOS时间模块实现
-// 处理BIOS主板时间读取
+// 启动时读取一次主板RTC（处理UIP、BCD/二进制、12/24小时制和世纪），换算成Unix时间
+// 设置墙上时间；之后的时间查询都由时钟源推算
 
 #include "drivers/cmos.h"
+#include "drivers/clocksource.h"
 #include "drivers/display.h"
 #include "kernel/kernel.h"
+#include "acpi.h"
+
+// 等待UIP清零的最大轮询次数（一次更新最长约2毫秒）
+#define RTC_UIP_SPIN_LIMIT 100000
+#define RTC_READ_ATTEMPTS  10
+
+// 世纪寄存器索引，rtc_init按FADT设置
+static uint8_t rtc_century_reg = CMOS_CENTURY;
 
 // CMOS时钟读取函数
 unsigned char read_cmos(unsigned char reg) {
@@ -20,18 +30,178 @@ unsigned char bcd_to_bin(unsigned char bcd) {
     return ((bcd >> 4) * 10) + (bcd & 0x0F);
 }
 
+// RTC寄存器的原始值
+typedef struct {
+    uint8_t second, minute, hour, day, month, year, century;
+} rtc_raw_t;
+
+static bool rtc_wait_uip(void) {
+    for (int i = 0; i < RTC_UIP_SPIN_LIMIT; i++) {
+        if (!(read_cmos(CMOS_STATUS_A) & CMOS_A_UIP)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void rtc_read_raw(rtc_raw_t* raw) {
+    raw->second = read_cmos(CMOS_SECOND);
+    raw->minute = read_cmos(CMOS_MINUTE);
+    raw->hour = read_cmos(CMOS_HOUR);
+    raw->day = read_cmos(CMOS_DAY);
+    raw->month = read_cmos(CMOS_MONTH);
+    raw->year = read_cmos(CMOS_YEAR);
+    raw->century = read_cmos(rtc_century_reg);
+}
+
+static bool rtc_raw_equal(const rtc_raw_t* a, const rtc_raw_t* b) {
+    return a->second == b->second && a->minute == b->minute && a->hour == b->hour &&
+           a->day == b->day && a->month == b->month && a->year == b->year &&
+           a->century == b->century;
+}
+
+int rtc_read_time(rtc_time_t* tm) {
+    rtc_raw_t raw, check;
+
+    // UIP清零后仍可能在读取途中开始更新，两次读取一致才可信
+    int attempt;
+    for (attempt = 0; attempt < RTC_READ_ATTEMPTS; attempt++) {
+        if (!rtc_wait_uip()) {
+            return RTC_ERR_UIP;
+        }
+        rtc_read_raw(&raw);
+        if (!rtc_wait_uip()) {
+            return RTC_ERR_UIP;
+        }
+        rtc_read_raw(&check);
+        if (rtc_raw_equal(&raw, &check)) {
+            break;
+        }
+    }
+    if (attempt == RTC_READ_ATTEMPTS) {
+        return RTC_ERR_UNSTABLE;
+    }
+
+    uint8_t status_b = read_cmos(CMOS_STATUS_B);
+    bool pm = (raw.hour & 0x80) != 0;
+    raw.hour &= 0x7F;
+
+    if (!(status_b & CMOS_B_BINARY)) {
+        raw.second = bcd_to_bin(raw.second);
+        raw.minute = bcd_to_bin(raw.minute);
+        raw.hour = bcd_to_bin(raw.hour);
+        raw.day = bcd_to_bin(raw.day);
+        raw.month = bcd_to_bin(raw.month);
+        raw.year = bcd_to_bin(raw.year);
+        raw.century = bcd_to_bin(raw.century);
+    }
+
+    // 12小时制：12AM为0点，12PM为12点
+    if (!(status_b & CMOS_B_24H)) {
+        if (raw.hour == 12) {
+            raw.hour = 0;
+        }
+        if (pm) {
+            raw.hour += 12;
+        }
+    }
+
+    // 世纪寄存器不一定存在，数值不合理时按年份窗口推断
+    uint16_t century = raw.century;
+    if (century < 19 || century > 21) {
+        century = raw.year < 70 ? 20 : 19;
+    }
+
+    tm->year = (uint16_t)(century * 100 + raw.year);
+    tm->month = raw.month;
+    tm->day = raw.day;
+    tm->hour = raw.hour;
+    tm->minute = raw.minute;
+    tm->second = raw.second;
+    return 0;
+}
+
+// 公历日期到1970-01-01的天数（按3月起始的年份计算，闰日落在年末）
+static uint64_t days_from_civil(uint32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    uint32_t era = year / 400;
+    uint32_t yoe = year - era * 400;
+    uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (uint64_t)era * 146097 + doe - 719468;
+}
+
+uint64_t rtc_time_to_unix(const rtc_time_t* tm) {
+    uint64_t days = days_from_civil(tm->year, tm->month, tm->day);
+    return days * 86400 + (uint64_t)tm->hour * 3600 + (uint64_t)tm->minute * 60 + tm->second;
+}
+
+void rtc_time_from_unix(uint64_t seconds, rtc_time_t* tm) {
+    uint64_t days = seconds / 86400;
+    uint32_t rem = (uint32_t)(seconds % 86400);
+    tm->hour = (uint8_t)(rem / 3600);
+    tm->minute = (uint8_t)(rem / 60 % 60);
+    tm->second = (uint8_t)(rem % 60);
+
+    uint64_t z = days + 719468;
+    uint64_t era = z / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    tm->day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    tm->month = (uint8_t)month;
+    tm->year = (uint16_t)(era * 400 + yoe + (month <= 2));
+}
+
+// FADT给出世纪寄存器索引时使用它，为0（或没有FADT）时退回常用的0x32
+static void rtc_detect_century(void) {
+    fadt_t* fadt = (fadt_t*)acpi_find_table("FACP");
+    if (fadt && fadt->header.length > __builtin_offsetof(fadt_t, century) && fadt->century != 0) {
+        rtc_century_reg = fadt->century;
+    } else {
+        rtc_century_reg = CMOS_CENTURY;
+    }
+}
+
+void rtc_init(void) {
+    rtc_detect_century();
+
+    rtc_time_t tm;
+    int result = rtc_read_time(&tm);
+    if (result == RTC_ERR_UIP) {
+        print_string("[RTC] Update in progress never cleared, wall clock starts at 1970\n");
+        return;
+    }
+    if (result == RTC_ERR_UNSTABLE) {
+        print_string("[RTC] Consecutive reads never matched, wall clock starts at 1970\n");
+        return;
+    }
+    timekeeping_set_real_ns(rtc_time_to_unix(&tm) * NSEC_PER_SEC);
+}
+
+// 当前墙上时间的日历形式
+static void current_calendar(rtc_time_t* tm) {
+    rtc_time_from_unix(ktime_get_real_ns() / NSEC_PER_SEC, tm);
+}
+
 // 读取当前时间
 void get_current_time(unsigned char* hour, unsigned char* minute, unsigned char* second) {
-    *second = bcd_to_bin(read_cmos(CMOS_SECOND));
-    *minute = bcd_to_bin(read_cmos(CMOS_MINUTE));
-    *hour = bcd_to_bin(read_cmos(CMOS_HOUR));
+    rtc_time_t tm;
+    current_calendar(&tm);
+    *hour = tm.hour;
+    *minute = tm.minute;
+    *second = tm.second;
 }
 
-// 读取当前日期
+// 读取当前日期（两位年份）
 void get_current_date(unsigned char* day, unsigned char* month, unsigned char* year) {
-    *day = bcd_to_bin(read_cmos(CMOS_DAY));
-    *month = bcd_to_bin(read_cmos(CMOS_MONTH));
-    *year = bcd_to_bin(read_cmos(CMOS_YEAR));
+    rtc_time_t tm;
+    current_calendar(&tm);
+    *day = tm.day;
+    *month = tm.month;
+    *year = (unsigned char)(tm.year % 100);
 }
 
 // 打印两位数（补零）
@@ -48,24 +218,21 @@ void print_two_digits(unsigned char num) {
 
 // 打印当前时间
 void print_current_time() {
-    unsigned char hour, minute, second;
-    unsigned char day, month, year;
-    
-    get_current_time(&hour, &minute, &second);
-    get_current_date(&day, &month, &year);
+    rtc_time_t tm;
+    current_calendar(&tm);
     
     // 打印日期
-    print_two_digits(day);
+    print_two_digits(tm.day);
     print_char('/');
-    print_two_digits(month);
+    print_two_digits(tm.month);
     print_char('/');
-    print_two_digits(year);
+    print_two_digits((unsigned char)(tm.year % 100));
     print_char(' ');
     
     // 打印时间
-    print_two_digits(hour);
+    print_two_digits(tm.hour);
     print_char(':');
-    print_two_digits(minute);
+    print_two_digits(tm.minute);
     print_char(':');
-    print_two_digits(second);
+    print_two_digits(tm.second);
 }
@@ -1,11 +1,15 @@
 // Boruix OS 显示驱动 - 使用Flanterm库
 // 基于flanterm的现代终端实现
 
+// 重映射帧缓冲需要访问flanterm fb上下文中的帧缓冲指针
+#define FLANTERM_IN_FLANTERM
+
 #include "drivers/display.h"
 #include "kernel/limine.h"
 #include "../flanterm/flanterm.h"
 #include "../flanterm/flanterm_backends/fb.h"
 #include "../../kernel/shell/utils/string.h"
+#include "rust/rust_memory.h"
 
 static struct flanterm_context *ft_ctx = NULL;
 
@@ -64,6 +68,26 @@ void display_init(struct limine_framebuffer *framebuffer) {
     );
 }
 
+// 将帧缓冲重映射为写合并
+// Limine通过HHDM提供的帧缓冲沿用引导程序的缓存类型，这里在MMIO窗口中
+// 以WC方式重新映射同一物理区域，并让flanterm改用新地址写入
+int display_remap_framebuffer_wc(struct limine_framebuffer *framebuffer, uint64_t hhdm_offset) {
+    if (!ft_ctx || !framebuffer) return -1;
+
+    uint64_t virt = (uint64_t)framebuffer->address;
+    if (virt < hhdm_offset) return -1;
+
+    uint64_t phys = virt - hhdm_offset;
+    uint64_t size = framebuffer->pitch * framebuffer->height;
+
+    uint64_t wc_addr = rust_vmm_map_mmio(phys, size, RUST_CACHE_WC);
+    if (wc_addr == 0) return -1;
+
+    struct flanterm_fb_context *fb_ctx = (struct flanterm_fb_context *)ft_ctx;
+    fb_ctx->framebuffer = (volatile uint32_t *)wc_addr;
+    return 0;
+}
+
 void clear_screen(void) {
     if (!ft_ctx) return;
     // 使用ANSI转义序列清屏
@@ -130,11 +154,6 @@ void print_string(const char* str) {
     // 不立即flush，让flanterm内部处理
 }
 
-void delay(int count) {
-    // 简单的延迟实现
-    for (volatile int i = 0; i < count * 1000; i++);
-}
-
 // 屏幕滚动相关函数（flanterm自动处理）
 void scroll_screen_up(void) {
     // flanterm自动处理滚动，无需手动实现
@@ -18,7 +18,6 @@ void clear_screen(void);
 void set_cursor(int x, int y);
 void print_char(char c);
 void print_string(const char* str);
-void delay(int count);
 
 // 屏幕滚动相关函数
 void scroll_screen_up(void);
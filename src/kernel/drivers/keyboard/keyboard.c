@@ -4,25 +4,51 @@
 #include "drivers/keyboard.h"
 #include "drivers/display.h"
 #include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+#include "kernel/spinlock.h"
+#include "drivers/ktimer.h"
 
 // 全局键盘状态
 static keyboard_state_t keyboard_state;
 
-// 全局时间戳计数器（简单实现）
-static uint32_t global_timestamp = 0;
+// 字符缓冲区和组合键事件缓冲区：tasklet写入，shell读取（tasklet可能在读取中途运行）
+DEFINE_SPINLOCK(keyboard_buffer_lock);
+
+// 组合键超时：最后一次组合键输入COMBO_TIMEOUT_MS后清空序列
+static ktimer_t combo_timer;
 
 // 扩展扫描码状态
 static int extended_scancode = 0;
 
+// 硬中断中读到的原始扫描码，由tasklet送入事件状态机
+// 单生产者（中断）单消费者（tasklet），head/tail各自只由一方修改
+#define SCANCODE_RING_SIZE 64
+static volatile uint8_t scancode_ring[SCANCODE_RING_SIZE];
+static volatile uint32_t scancode_head = 0;
+static volatile uint32_t scancode_tail = 0;
+static uint64_t scancode_dropped = 0;
+
+// keyboard_reset请求丢弃到flush_to为止的扫描码，由消费者（tasklet）移动head完成，
+// flush_to/flush_req只由keyboard_reset写，flush_done只由tasklet写
+static volatile uint32_t scancode_flush_to = 0;
+static volatile uint32_t scancode_flush_req = 0;
+static volatile uint32_t scancode_flush_done = 0;
+
+static tasklet_t keyboard_tasklet;
+
 // 函数声明
 static uint32_t get_timestamp(void);
-static void increment_timestamp(void);
+static void combo_touch(void);
+static void combo_timeout(uintptr_t data);
 static void add_combo_event(combo_event_type_t type, uint8_t scancode, uint8_t ascii);
 static void process_key_event(uint8_t scancode);
 static void reset_combo_sequence(void);
 static int is_modifier_key(uint8_t scancode);
 static uint8_t get_modifier_state(void);
 static void keyboard_hardware_init(void);
+static void keyboard_tasklet_func(uintptr_t data);
+static void keyboard_buffer_push(unsigned char ch);
 
 // 扫描码到ASCII码的映射表（无Shift）
 static const unsigned char scancode_to_ascii[128] = {
@@ -60,6 +86,13 @@ static void outb(unsigned short port, unsigned char value) {
     __asm__ volatile ("outb %0, %1" : : "a" (value), "Nd" (port));
 }
 
+static irq_return_t keyboard_irq(uint8_t vector, void* ctx) {
+    (void)vector;
+    (void)ctx;
+    keyboard_irq_handler();
+    return IRQ_HANDLED;
+}
+
 // 初始化键盘
 void keyboard_init(void) {
     // 硬件初始化 - 重置PS/2键盘控制器
@@ -98,10 +131,19 @@ void keyboard_init(void) {
         keyboard_state.combo_state.sequence[i] = 0;
     }
     
-    global_timestamp = 0;
+    scancode_head = 0;
+    scancode_tail = 0;
+    scancode_dropped = 0;
+    scancode_flush_to = 0;
+    scancode_flush_req = 0;
+    scancode_flush_done = 0;
+    timer_setup(&combo_timer, combo_timeout, 0);
+    tasklet_init(&keyboard_tasklet, keyboard_tasklet_func, 0);
+    
+    request_irq(IRQ_BASE + 1, keyboard_irq, NULL, 0);
 }
 
-// 键盘中断处理程序
+// 键盘中断处理程序（硬中断上下文，只取走扫描码）
 void keyboard_irq_handler(void) {
     // 检查数据是否可用
     if (!(inb(KEYBOARD_STATUS_PORT) & KEYBOARD_STATUS_OUTPUT_BUFFER_FULL)) {
@@ -111,17 +153,52 @@ void keyboard_irq_handler(void) {
     // 读取扫描码
     unsigned char scancode = inb(KEYBOARD_DATA_PORT);
     
-    // 处理键盘事件
-    process_key_event(scancode);
+    uint32_t next = (scancode_tail + 1) % SCANCODE_RING_SIZE;
+    if (next == scancode_head) {
+        scancode_dropped++;  // 下半部来不及处理
+        return;
+    }
+    scancode_ring[scancode_tail] = scancode;
+    scancode_tail = next;
+    
+    // 组合键状态机等耗时处理交给tasklet
+    tasklet_schedule(&keyboard_tasklet);
+}
+
+// 键盘下半部：开中断状态下处理积累的扫描码
+static void keyboard_tasklet_func(uintptr_t data) {
+    (void)data;
+    
+    uint32_t req = scancode_flush_req;
+    if (req != scancode_flush_done) {
+        __asm__ volatile("" ::: "memory");
+        // 只向前移动：flush_to之前的扫描码可能已经处理过
+        uint32_t head = scancode_head;
+        uint32_t tail = scancode_tail;
+        uint32_t skip = (scancode_flush_to - head) % SCANCODE_RING_SIZE;
+        if (skip <= (tail - head) % SCANCODE_RING_SIZE) {
+            scancode_head = scancode_flush_to;
+        }
+        scancode_flush_done = req;
+    }
     
-    increment_timestamp(); // 增加时间戳
+    while (scancode_head != scancode_tail) {
+        uint8_t scancode = scancode_ring[scancode_head];
+        scancode_head = (scancode_head + 1) % SCANCODE_RING_SIZE;
+        
+        process_key_event(scancode);
+    }
+}
+
+// 因扫描码队列满而丢弃的按键数
+uint64_t keyboard_get_dropped_count(void) {
+    return scancode_dropped;
 }
 
 // 读取键盘扫描码（轮询模式，非阻塞）
 unsigned char keyboard_read_scancode(void) {
     // 检查数据是否可用
     if (!(inb(KEYBOARD_STATUS_PORT) & KEYBOARD_STATUS_OUTPUT_BUFFER_FULL)) {
-        increment_timestamp(); // 增加时间戳
         return 0; // 没有数据
     }
     
@@ -131,7 +208,6 @@ unsigned char keyboard_read_scancode(void) {
     // 处理键盘事件
     process_key_event(scancode);
     
-    increment_timestamp(); // 增加时间戳
     return scancode;
 }
 
@@ -160,15 +236,28 @@ void keyboard_interrupt_handler(void) {
     keyboard_read_scancode(); // 这会自动处理所有键盘事件
 }
 
+// 字符放入缓冲区，满时丢弃
+static void keyboard_buffer_push(unsigned char ch) {
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
+    if (keyboard_state.count < KEYBOARD_BUFFER_SIZE) {
+        keyboard_state.buffer[keyboard_state.tail] = ch;
+        keyboard_state.tail = (keyboard_state.tail + 1) % KEYBOARD_BUFFER_SIZE;
+        keyboard_state.count++;
+    }
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
+}
+
 // 获取一个字符（非阻塞）
 unsigned char keyboard_get_char(void) {
-    if (keyboard_state.count == 0) {
-        return 0; // 没有字符
-    }
+    unsigned char ch = 0; // 没有字符
     
-    unsigned char ch = keyboard_state.buffer[keyboard_state.head];
-    keyboard_state.head = (keyboard_state.head + 1) % KEYBOARD_BUFFER_SIZE;
-    keyboard_state.count--;
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
+    if (keyboard_state.count > 0) {
+        ch = keyboard_state.buffer[keyboard_state.head];
+        keyboard_state.head = (keyboard_state.head + 1) % KEYBOARD_BUFFER_SIZE;
+        keyboard_state.count--;
+    }
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
     
     return ch;
 }
@@ -180,41 +269,52 @@ int keyboard_has_char(void) {
 
 // 清空键盘缓冲区
 void keyboard_clear_buffer(void) {
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
     keyboard_state.head = 0;
     keyboard_state.tail = 0;
     keyboard_state.count = 0;
     keyboard_state.event_head = 0;
     keyboard_state.event_tail = 0;
     keyboard_state.event_count = 0;
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
     reset_combo_sequence();
 }
 
 // === 通用组合键系统实现 ===
 
-// 获取时间戳
+// 获取时间戳（系统滴答）
 static uint32_t get_timestamp(void) {
-    return global_timestamp;
+    return system_ticks;
 }
 
-// 增加时间戳
-static void increment_timestamp(void) {
-    global_timestamp++;
+// 记录一次组合键输入并重新开始超时计时
+static void combo_touch(void) {
+    keyboard_state.combo_state.last_event_time = get_timestamp();
+    timer_mod(&combo_timer, system_ticks + msecs_to_ticks(COMBO_TIMEOUT_MS));
+}
+
+// 组合键超时（TIMER软中断）
+static void combo_timeout(uintptr_t data) {
+    (void)data;
+    if (keyboard_state.combo_state.is_active) {
+        reset_combo_sequence();
+    }
 }
 
 // 添加组合键事件到缓冲区
 static void add_combo_event(combo_event_type_t type, uint8_t scancode, uint8_t ascii) {
-    if (keyboard_state.event_count >= KEYBOARD_BUFFER_SIZE) {
-        return; // 缓冲区满
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
+    if (keyboard_state.event_count < KEYBOARD_BUFFER_SIZE) {
+        combo_event_t* event = &keyboard_state.event_buffer[keyboard_state.event_tail];
+        event->type = type;
+        event->scancode = scancode;
+        event->ascii = ascii;
+        event->timestamp = get_timestamp();
+        
+        keyboard_state.event_tail = (keyboard_state.event_tail + 1) % KEYBOARD_BUFFER_SIZE;
+        keyboard_state.event_count++;
     }
-    
-    combo_event_t* event = &keyboard_state.event_buffer[keyboard_state.event_tail];
-    event->type = type;
-    event->scancode = scancode;
-    event->ascii = ascii;
-    event->timestamp = get_timestamp();
-    
-    keyboard_state.event_tail = (keyboard_state.event_tail + 1) % KEYBOARD_BUFFER_SIZE;
-    keyboard_state.event_count++;
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
 }
 
 // 处理键盘事件
@@ -329,22 +429,14 @@ static void process_key_event(uint8_t scancode) {
                     
                     if (special_ascii != 0) {
                         // 添加到普通字符缓冲区
-                        if (keyboard_state.count < KEYBOARD_BUFFER_SIZE) {
-                            keyboard_state.buffer[keyboard_state.tail] = special_ascii;
-                            keyboard_state.tail = (keyboard_state.tail + 1) % KEYBOARD_BUFFER_SIZE;
-                            keyboard_state.count++;
-                        }
+                        keyboard_buffer_push(special_ascii);
                     }
                 } else {
                     // 处理普通字符
                     unsigned char ascii = keyboard_scancode_to_ascii(scancode);
                     if (ascii != 0) {
                         // 添加到普通字符缓冲区
-                        if (keyboard_state.count < KEYBOARD_BUFFER_SIZE) {
-                            keyboard_state.buffer[keyboard_state.tail] = ascii;
-                            keyboard_state.tail = (keyboard_state.tail + 1) % KEYBOARD_BUFFER_SIZE;
-                            keyboard_state.count++;
-                        }
+                        keyboard_buffer_push(ascii);
                     }
                 }
                 
@@ -353,7 +445,7 @@ static void process_key_event(uint8_t scancode) {
                     if (keyboard_state.combo_state.sequence_length < MAX_COMBO_SEQUENCE) {
                         keyboard_state.combo_state.sequence[keyboard_state.combo_state.sequence_length] = key_code;
                         keyboard_state.combo_state.sequence_length++;
-                        keyboard_state.combo_state.last_event_time = get_timestamp();
+                        combo_touch();
                         keyboard_state.combo_state.modifier_state = get_modifier_state();
                         keyboard_state.combo_state.is_active = 1;
                     }
@@ -365,6 +457,7 @@ static void process_key_event(uint8_t scancode) {
 
 // 重置组合键序列
 static void reset_combo_sequence(void) {
+    timer_cancel(&combo_timer);
     keyboard_state.combo_state.sequence_length = 0;
     keyboard_state.combo_state.last_event_time = 0;
     keyboard_state.combo_state.modifier_state = 0;
@@ -395,14 +488,15 @@ static uint8_t get_modifier_state(void) {
 
 // 获取组合键事件
 combo_event_t keyboard_get_combo_event(void) {
-    if (keyboard_state.event_count == 0) {
-        combo_event_t empty_event = {COMBO_EVENT_NONE, 0, 0, 0};
-        return empty_event;
-    }
+    combo_event_t event = {COMBO_EVENT_NONE, 0, 0, 0};
     
-    combo_event_t event = keyboard_state.event_buffer[keyboard_state.event_head];
-    keyboard_state.event_head = (keyboard_state.event_head + 1) % KEYBOARD_BUFFER_SIZE;
-    keyboard_state.event_count--;
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
+    if (keyboard_state.event_count > 0) {
+        event = keyboard_state.event_buffer[keyboard_state.event_head];
+        keyboard_state.event_head = (keyboard_state.event_head + 1) % KEYBOARD_BUFFER_SIZE;
+        keyboard_state.event_count--;
+    }
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
     
     return event;
 }
@@ -419,7 +513,7 @@ void keyboard_process_combo_sequence(uint8_t* sequence, int length, uint8_t modi
     if (length > 0 && length <= MAX_COMBO_SEQUENCE) {
         keyboard_state.combo_state.modifier_state = modifiers;
         keyboard_state.combo_state.sequence_length = length;
-        keyboard_state.combo_state.last_event_time = get_timestamp();
+        combo_touch();
         keyboard_state.combo_state.is_active = 1;
         
         for (int i = 0; i < length; i++) {
@@ -506,12 +600,14 @@ static void keyboard_hardware_init(void) {
 // 重置键盘（用于恢复键盘功能）
 void keyboard_reset(void) {
     // 清空所有缓冲区
+    uint64_t flags = spin_lock_irqsave(&keyboard_buffer_lock);
     keyboard_state.head = 0;
     keyboard_state.tail = 0;
     keyboard_state.count = 0;
     keyboard_state.event_head = 0;
     keyboard_state.event_tail = 0;
     keyboard_state.event_count = 0;
+    spin_unlock_irqrestore(&keyboard_buffer_lock, flags);
     
     // 重置修饰键状态
     keyboard_state.shift_pressed = 0;
@@ -522,6 +618,12 @@ void keyboard_reset(void) {
     // 重置扩展扫描码状态
     extended_scancode = 0;
     
+    // 丢弃尚未交给下半部处理的扫描码：head属于消费者，交给tasklet移动
+    scancode_flush_to = scancode_tail;
+    __asm__ volatile("" ::: "memory");
+    scancode_flush_req = scancode_flush_req + 1;
+    tasklet_schedule(&keyboard_tasklet);
+    
     // 重新进行硬件初始化
     keyboard_hardware_init();
 }
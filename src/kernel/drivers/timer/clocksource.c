@@ -0,0 +1,127 @@
+// Boruix OS 时钟源管理
+// 维护(基准周期, 基准纳秒)，读取时加上自基准以来的周期换算值；
+// 读者用序列计数检测并重试被时钟中断打断的更新
+
+#include "drivers/clocksource.h"
+#include "kernel/interrupt.h"
+
+static clocksource_t* current_cs = NULL;
+
+// 时间基准
+static volatile uint32_t tk_seq = 0;
+static uint64_t tk_base_cycles = 0;
+static uint64_t tk_base_ns = 0;
+
+// 墙上时间相对单调时间的偏移（64位对齐，读写各为一条指令）
+static volatile uint64_t tk_real_offset = 0;
+
+#define barrier() __asm__ volatile("" ::: "memory")
+
+void clocks_calc_mult_shift(uint32_t* mult, uint32_t* shift, uint64_t from_hz, uint64_t to_hz,
+                            uint32_t max_seconds) {
+    // 求max_seconds内的周期数占多少位，乘数不能超过剩余的位数
+    uint64_t tmp = ((uint64_t)max_seconds * from_hz) >> 32;
+    uint32_t sftacc = 32;
+    while (tmp) {
+        tmp >>= 1;
+        sftacc--;
+    }
+
+    // 在不溢出的前提下取尽量大的移位以保证精度
+    uint32_t sft;
+    for (sft = 32; sft > 0; sft--) {
+        tmp = (uint64_t)to_hz << sft;
+        tmp += from_hz / 2;
+        tmp /= from_hz;
+        if ((tmp >> sftacc) == 0) {
+            break;
+        }
+    }
+    *mult = (uint32_t)tmp;
+    *shift = sft;
+}
+
+// 当前时间（需在序列计数保护下调用）
+static uint64_t tk_now_ns(void) {
+    uint64_t delta = (current_cs->read() - tk_base_cycles) & current_cs->mask;
+    return tk_base_ns + clocksource_cyc2ns(current_cs, delta);
+}
+
+// 把基准推进到当前时刻（关中断调用）
+static void tk_fold(void) {
+    tk_seq++;
+    barrier();
+    uint64_t now = current_cs->read();
+    tk_base_ns += clocksource_cyc2ns(current_cs, (now - tk_base_cycles) & current_cs->mask);
+    tk_base_cycles = now;
+    barrier();
+    tk_seq++;
+}
+
+int clocksource_register(clocksource_t* cs) {
+    if (!cs || !cs->read || cs->freq_hz == 0) {
+        return -1;
+    }
+    clocks_calc_mult_shift(&cs->mult, &cs->shift, cs->freq_hz, NSEC_PER_SEC, CLOCKSOURCE_MAX_SECONDS);
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    if (!current_cs || cs->rating > current_cs->rating) {
+        // 切换时以旧时钟源的当前时间作为新时钟源的基准，保证单调
+        tk_seq++;
+        barrier();
+        if (current_cs) {
+            tk_base_ns = tk_now_ns();
+        }
+        current_cs = cs;
+        tk_base_cycles = cs->read();
+        barrier();
+        tk_seq++;
+    }
+
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return 0;
+}
+
+const clocksource_t* clocksource_get_current(void) {
+    return current_cs;
+}
+
+uint64_t ktime_get_ns(void) {
+    uint32_t seq;
+    uint64_t ns;
+
+    do {
+        seq = tk_seq;
+        barrier();
+        if (!current_cs) {
+            return 0;
+        }
+        ns = tk_now_ns();
+        barrier();
+    } while ((seq & 1) || seq != tk_seq);
+
+    return ns;
+}
+
+void timekeeping_set_real_ns(uint64_t unix_ns) {
+    tk_real_offset = unix_ns - ktime_get_ns();
+}
+
+uint64_t ktime_get_real_ns(void) {
+    return ktime_get_ns() + tk_real_offset;
+}
+
+void clocksource_tick(void) {
+    if (!current_cs) {
+        return;
+    }
+    // 按经过的周期而不是滴答数判断，滴答被NO_HZ停掉时也不会错过
+    uint64_t delta = (current_cs->read() - tk_base_cycles) & current_cs->mask;
+    if (delta >= current_cs->freq_hz) {
+        tk_fold();
+    }
+}
@@ -0,0 +1,65 @@
+// Boruix OS 延迟与睡眠
+// 忙等按TSC周期计数，不依赖循环次数与编译优化；睡眠借助hrtimer唤醒空闲循环
+
+#include "drivers/delay.h"
+#include "drivers/clocksource.h"
+#include "drivers/hrtimer.h"
+#include "drivers/tick.h"
+#include "kernel/interrupt.h"
+#include "arch/x86_64.h"
+#include "arch/percpu.h"
+
+// 未使用的POST诊断端口，每次写入约1微秒
+#define IO_DELAY_PORT 0x80
+
+static inline void io_delay(void) {
+    __asm__ volatile("outb %%al, %0" : : "Nd"((uint16_t)IO_DELAY_PORT), "a"((uint8_t)0));
+}
+
+void ndelay(uint64_t ns) {
+    uint64_t freq = tsc_get_freq_hz();
+    if (freq == 0) {
+        // TSC尚未校准（tsc_init之前）
+        for (uint64_t us = (ns + 999) / 1000; us > 0; us--) {
+            io_delay();
+        }
+        return;
+    }
+
+    // 按MHz向上取整换算，避免ns * freq溢出，延迟只会偏长
+    uint64_t mhz = (freq + 999999) / 1000000;
+    uint64_t cycles = (ns * mhz + 999) / 1000;
+    uint64_t start = cpu_rdtsc();
+    while (cpu_rdtsc() - start < cycles) {
+        __asm__ volatile("pause");
+    }
+}
+
+typedef struct {
+    hrtimer_t timer;
+    volatile bool done;
+} sleep_timer_t;
+
+static hrtimer_restart_t msleep_wakeup(hrtimer_t* timer) {
+    ((sleep_timer_t*)timer)->done = true;
+    return HRTIMER_NORESTART;
+}
+
+void msleep(uint32_t ms) {
+    // 关中断、在中断处理程序或软中断（定时器回调、tasklet）中不能等待定时器，退回忙等
+    if (!interrupts_enabled() || in_interrupt()) {
+        mdelay(ms);
+        return;
+    }
+
+    sleep_timer_t sleeper;
+    sleeper.done = false;
+    hrtimer_init(&sleeper.timer, msleep_wakeup);
+    hrtimer_start(&sleeper.timer, (uint64_t)ms * NSEC_PER_MSEC, HRTIMER_MODE_REL);
+
+    // 其他中断也会唤醒空闲循环，回到这里重新检查
+    while (!sleeper.done) {
+        cpu_idle();
+    }
+    hrtimer_cancel(&sleeper.timer);
+}
@@ -0,0 +1,383 @@
+// Boruix OS HPET驱动
+// 寄存器块通过VMM以UC方式映射；主计数器注册为时钟源（评级介于不变TSC和普通TSC之间），
+// 比较器以一次性模式使用，优先FSB（MSI）投递，否则路由到空闲的I/O APIC输入
+
+#include "kernel/types.h"
+#include "kernel/interrupt.h"
+#include "arch/apic.h"
+#include "drivers/hpet.h"
+#include "drivers/clocksource.h"
+#include "drivers/display.h"
+#include "rust/rust_memory.h"
+#include "acpi.h"
+
+// 寄存器偏移
+#define HPET_REG_CAP            0x000
+#define HPET_REG_CONFIG         0x010
+#define HPET_REG_INT_STATUS     0x020
+#define HPET_REG_COUNTER        0x0F0
+#define HPET_REG_TIMER_CONF(n)  (0x100 + 0x20 * (n))
+#define HPET_REG_TIMER_CMP(n)   (0x108 + 0x20 * (n))
+#define HPET_REG_TIMER_FSB(n)   (0x110 + 0x20 * (n))
+
+// 通用能力寄存器
+#define HPET_CAP_COUNT_64       (1ULL << 13)
+#define HPET_CAP_LEGACY         (1ULL << 15)
+#define HPET_CAP_NUM_TIMERS(c)  ((uint32_t)(((c) >> 8) & 0x1F) + 1)
+#define HPET_CAP_VENDOR(c)      ((uint16_t)((c) >> 16))
+#define HPET_CAP_PERIOD(c)      ((uint32_t)((c) >> 32))
+
+// 计数周期上限100ns（规范要求）
+#define HPET_MAX_PERIOD_FS      100000000U
+
+// 通用配置寄存器
+#define HPET_CFG_ENABLE         (1ULL << 0)
+#define HPET_CFG_LEGACY         (1ULL << 1)
+
+// 比较器配置与能力寄存器
+#define HPET_TN_LEVEL           (1ULL << 1)
+#define HPET_TN_INT_ENABLE      (1ULL << 2)
+#define HPET_TN_PERIODIC        (1ULL << 3)
+#define HPET_TN_PERIODIC_CAP    (1ULL << 4)
+#define HPET_TN_SIZE_64         (1ULL << 5)
+#define HPET_TN_ROUTE_SHIFT     9
+#define HPET_TN_ROUTE_MASK      (0x1FULL << HPET_TN_ROUTE_SHIFT)
+#define HPET_TN_FSB_ENABLE      (1ULL << 14)
+#define HPET_TN_FSB_CAP         (1ULL << 15)
+#define HPET_TN_ROUTE_CAP(c)    ((uint32_t)((c) >> 32))
+
+// 一次性事件的最小提前量（计数），避免写入比较器时目标已经过去
+#define HPET_MIN_DELTA_TICKS    64
+
+// MSI消息地址
+#define HPET_MSI_ADDRESS_BASE   0xFEE00000U
+
+typedef struct {
+    bool in_use;
+    bool fsb;                       // 使用FSB投递
+    uint32_t index;
+    uint32_t gsi;
+    uint8_t vector;
+    uint64_t caps;                  // 比较器能力（配置寄存器的只读位）
+    uint64_t fired;
+    hpet_event_handler_t handler;
+    void* ctx;
+} hpet_timer_t;
+
+static volatile uint8_t* hpet_regs = NULL;
+static uint64_t hpet_phys = 0;
+static uint64_t hpet_cap = 0;
+static uint64_t hpet_freq = 0;
+static uint64_t hpet_mask = 0;
+static uint32_t hpet_timers_count = 0;
+static hpet_timer_t hpet_timers[HPET_MAX_TIMERS];
+
+static inline uint64_t hpet_read(uint32_t reg) {
+    return *(volatile uint64_t*)(hpet_regs + reg);
+}
+
+static inline void hpet_write(uint32_t reg, uint64_t value) {
+    *(volatile uint64_t*)(hpet_regs + reg) = value;
+}
+
+static uint64_t hpet_cs_read(void) {
+    return hpet_read(HPET_REG_COUNTER);
+}
+
+static clocksource_t hpet_clocksource = {
+    .name = "hpet",
+    .read = hpet_cs_read,
+    .mask = 0,
+    .freq_hz = 0,
+    .mult = 0,
+    .shift = 0,
+    .rating = 250,
+};
+
+int hpet_init(void) {
+    hpet_table_t* table = (hpet_table_t*)acpi_find_table("HPET");
+    if (!table) {
+        print_string("[HPET] No HPET table\n");
+        return -1;
+    }
+    if (table->address.address_space != 0 || table->address.address == 0) {
+        print_string("[HPET] Register block is not memory mapped\n");
+        return -1;
+    }
+
+    hpet_phys = table->address.address;
+    uint64_t virt = rust_vmm_map_mmio(hpet_phys, PAGE_SIZE, RUST_CACHE_UC);
+    if (virt == 0) {
+        print_string("[HPET] Failed to map registers\n");
+        return -1;
+    }
+    hpet_regs = (volatile uint8_t*)virt;
+
+    hpet_cap = hpet_read(HPET_REG_CAP);
+    uint32_t period = HPET_CAP_PERIOD(hpet_cap);
+    if (period == 0 || period > HPET_MAX_PERIOD_FS) {
+        print_string("[HPET] Invalid counter period\n");
+        rust_vmm_unmap_mmio((uint64_t)hpet_regs, PAGE_SIZE);
+        hpet_regs = NULL;
+        return -1;
+    }
+
+    hpet_freq = 1000000000000000ULL / period;
+    hpet_mask = (hpet_cap & HPET_CAP_COUNT_64) ? 0xFFFFFFFFFFFFFFFFULL : 0xFFFFFFFFULL;
+    hpet_timers_count = HPET_CAP_NUM_TIMERS(hpet_cap);
+    if (hpet_timers_count > HPET_MAX_TIMERS) {
+        hpet_timers_count = HPET_MAX_TIMERS;
+    }
+
+    // 停止主计数器，关闭传统替换路由（PIT和RTC继续走原来的线路）
+    uint64_t config = hpet_read(HPET_REG_CONFIG);
+    hpet_write(HPET_REG_CONFIG, config & ~(HPET_CFG_ENABLE | HPET_CFG_LEGACY));
+
+    // 关闭所有比较器的中断
+    for (uint32_t n = 0; n < hpet_timers_count; n++) {
+        uint64_t conf = hpet_read(HPET_REG_TIMER_CONF(n));
+        hpet_timers[n].in_use = false;
+        hpet_timers[n].index = n;
+        hpet_timers[n].caps = conf;
+        hpet_timers[n].vector = 0;
+        hpet_timers[n].fired = 0;
+        conf &= ~(HPET_TN_INT_ENABLE | HPET_TN_PERIODIC | HPET_TN_FSB_ENABLE | HPET_TN_LEVEL);
+        hpet_write(HPET_REG_TIMER_CONF(n), conf);
+    }
+
+    hpet_write(HPET_REG_COUNTER, 0);
+    hpet_write(HPET_REG_INT_STATUS, hpet_read(HPET_REG_INT_STATUS));
+    hpet_write(HPET_REG_CONFIG, (config & ~HPET_CFG_LEGACY) | HPET_CFG_ENABLE);
+
+    hpet_clocksource.freq_hz = hpet_freq;
+    hpet_clocksource.mask = hpet_mask;
+    clocksource_register(&hpet_clocksource);
+
+    print_string("[HPET] ");
+    print_dec((uint32_t)(hpet_freq / 1000));
+    print_string(" kHz, ");
+    print_dec(hpet_timers_count);
+    print_string(" comparators, ");
+    print_string((hpet_cap & HPET_CAP_COUNT_64) ? "64-bit" : "32-bit");
+    print_string(" counter at 0x");
+    print_hex(hpet_phys);
+    print_string("\n");
+    return 0;
+}
+
+bool hpet_is_available(void) {
+    return hpet_regs != NULL;
+}
+
+uint64_t hpet_read_counter(void) {
+    if (!hpet_regs) {
+        return 0;
+    }
+    return hpet_read(HPET_REG_COUNTER) & hpet_mask;
+}
+
+uint64_t hpet_get_freq_hz(void) {
+    return hpet_freq;
+}
+
+void hpet_get_info(hpet_info_t* info) {
+    info->phys = hpet_phys;
+    info->freq_hz = hpet_freq;
+    info->period_fs = HPET_CAP_PERIOD(hpet_cap);
+    info->timer_count = hpet_timers_count;
+    info->vendor_id = HPET_CAP_VENDOR(hpet_cap);
+    info->counter_64bit = (hpet_cap & HPET_CAP_COUNT_64) != 0;
+    info->legacy_capable = (hpet_cap & HPET_CAP_LEGACY) != 0;
+}
+
+bool hpet_get_timer_info(uint32_t timer, hpet_timer_info_t* info) {
+    if (timer >= hpet_timers_count) {
+        return false;
+    }
+    hpet_timer_t* t = &hpet_timers[timer];
+    info->in_use = t->in_use;
+    info->periodic_capable = (t->caps & HPET_TN_PERIODIC_CAP) != 0;
+    info->fsb_capable = (t->caps & HPET_TN_FSB_CAP) != 0;
+    info->comparator_64bit = (t->caps & HPET_TN_SIZE_64) != 0;
+    info->route_cap = HPET_TN_ROUTE_CAP(t->caps);
+    info->gsi = t->gsi;
+    info->vector = t->vector;
+    info->fired = t->fired;
+    return true;
+}
+
+static irq_return_t hpet_timer_irq(uint8_t vector, void* ctx) {
+    (void)vector;
+    hpet_timer_t* t = (hpet_timer_t*)ctx;
+
+    // 一次性语义：关闭比较器中断，32位比较器否则会在计数器回绕后再次触发
+    uint64_t conf = hpet_read(HPET_REG_TIMER_CONF(t->index));
+    hpet_write(HPET_REG_TIMER_CONF(t->index), conf & ~HPET_TN_INT_ENABLE);
+    hpet_write(HPET_REG_INT_STATUS, 1ULL << t->index);
+
+    t->fired++;
+    if (t->handler) {
+        t->handler(t->index, t->ctx);
+    }
+    return IRQ_HANDLED;
+}
+
+// 为比较器选择投递方式，成功时设置t->fsb/t->gsi
+static int hpet_timer_route(hpet_timer_t* t) {
+    uint64_t conf = t->caps & ~(HPET_TN_INT_ENABLE | HPET_TN_PERIODIC | HPET_TN_LEVEL |
+                                HPET_TN_FSB_ENABLE | HPET_TN_ROUTE_MASK);
+
+    if (t->caps & HPET_TN_FSB_CAP) {
+        // FSB路由寄存器：高32位为消息地址，低32位为消息数据（向量，固定投递、边沿触发）
+        uint64_t address = HPET_MSI_ADDRESS_BASE | ((lapic_get_id() & 0xFF) << 12);
+        hpet_write(HPET_REG_TIMER_FSB(t->index), (address << 32) | t->vector);
+        hpet_write(HPET_REG_TIMER_CONF(t->index), conf | HPET_TN_FSB_ENABLE);
+        t->fsb = true;
+        return 0;
+    }
+
+    // ISA线路由PIT/键盘等使用，只选择其余的I/O APIC输入
+    uint32_t route_cap = HPET_TN_ROUTE_CAP(t->caps);
+    for (uint32_t gsi = APIC_ISA_IRQS; gsi < 32; gsi++) {
+        if (!(route_cap & (1U << gsi))) {
+            continue;
+        }
+        bool taken = false;
+        for (uint32_t n = 0; n < hpet_timers_count; n++) {
+            if (hpet_timers[n].in_use && !hpet_timers[n].fsb && hpet_timers[n].gsi == gsi) {
+                taken = true;
+                break;
+            }
+        }
+        if (taken || ioapic_route_gsi(gsi, t->vector, false) != 0) {
+            continue;
+        }
+
+        hpet_write(HPET_REG_TIMER_CONF(t->index), conf | ((uint64_t)gsi << HPET_TN_ROUTE_SHIFT));
+        // 部分实现会忽略不支持的路由值，读回确认
+        if (((hpet_read(HPET_REG_TIMER_CONF(t->index)) & HPET_TN_ROUTE_MASK) >> HPET_TN_ROUTE_SHIFT) != gsi) {
+            continue;
+        }
+        ioapic_mask_gsi(gsi, false);
+        t->fsb = false;
+        t->gsi = gsi;
+        return 0;
+    }
+    return -1;
+}
+
+int hpet_comparator_request(hpet_event_handler_t handler, void* ctx) {
+    if (!hpet_regs || !apic_is_enabled()) {
+        return -1;
+    }
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    int result = -1;
+    for (uint32_t n = 0; n < hpet_timers_count; n++) {
+        hpet_timer_t* t = &hpet_timers[n];
+        if (t->in_use) {
+            continue;
+        }
+
+        int vector = irq_alloc_vector();
+        if (vector < 0) {
+            break;
+        }
+        t->vector = (uint8_t)vector;
+        t->handler = handler;
+        t->ctx = ctx;
+
+        if (request_irq(t->vector, hpet_timer_irq, t, 0) != 0) {
+            irq_free_vector(t->vector);
+            t->vector = 0;
+            break;
+        }
+        if (hpet_timer_route(t) != 0) {
+            free_irq(t->vector, hpet_timer_irq, t);
+            irq_free_vector(t->vector);
+            t->vector = 0;
+            continue;
+        }
+
+        t->in_use = true;
+        t->fired = 0;
+        result = (int)n;
+        break;
+    }
+
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return result;
+}
+
+void hpet_comparator_free(uint32_t timer) {
+    if (timer >= hpet_timers_count || !hpet_timers[timer].in_use) {
+        return;
+    }
+    hpet_timer_t* t = &hpet_timers[timer];
+
+    hpet_comparator_cancel(timer);
+    uint64_t conf = hpet_read(HPET_REG_TIMER_CONF(timer));
+    hpet_write(HPET_REG_TIMER_CONF(timer), conf & ~(HPET_TN_FSB_ENABLE | HPET_TN_ROUTE_MASK));
+    if (!t->fsb) {
+        ioapic_mask_gsi(t->gsi, true);
+    }
+
+    free_irq(t->vector, hpet_timer_irq, t);
+    irq_free_vector(t->vector);
+    t->vector = 0;
+    t->handler = NULL;
+    t->in_use = false;
+}
+
+int hpet_comparator_arm(uint32_t timer, uint64_t delta_ns) {
+    if (timer >= hpet_timers_count || !hpet_timers[timer].in_use) {
+        return -1;
+    }
+    hpet_timer_t* t = &hpet_timers[timer];
+
+    // 分两段换算，避免delta_ns * freq溢出
+    uint64_t ticks = (delta_ns / NSEC_PER_SEC) * hpet_freq +
+                     (delta_ns % NSEC_PER_SEC) * hpet_freq / NSEC_PER_SEC;
+    if (ticks < HPET_MIN_DELTA_TICKS) {
+        ticks = HPET_MIN_DELTA_TICKS;
+    }
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    uint64_t conf = hpet_read(HPET_REG_TIMER_CONF(timer));
+    hpet_write(HPET_REG_TIMER_CONF(timer), (conf & ~HPET_TN_PERIODIC) | HPET_TN_INT_ENABLE);
+
+    uint64_t target = hpet_read(HPET_REG_COUNTER) + ticks;
+    hpet_write(HPET_REG_TIMER_CMP(timer), target);
+
+    // 比较器只在相等时触发，写入期间计数器已越过目标则这次事件丢失
+    uint64_t now = hpet_read(HPET_REG_COUNTER);
+    bool missed;
+    if (t->caps & HPET_TN_SIZE_64) {
+        missed = (int64_t)(target - now) <= 0;
+    } else {
+        missed = (int32_t)((uint32_t)target - (uint32_t)now) <= 0;
+    }
+    if (missed) {
+        hpet_write(HPET_REG_TIMER_CONF(timer), conf & ~HPET_TN_INT_ENABLE);
+    }
+
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return missed ? -1 : 0;
+}
+
+void hpet_comparator_cancel(uint32_t timer) {
+    if (timer >= hpet_timers_count || !hpet_timers[timer].in_use) {
+        return;
+    }
+    uint64_t conf = hpet_read(HPET_REG_TIMER_CONF(timer));
+    hpet_write(HPET_REG_TIMER_CONF(timer), conf & ~HPET_TN_INT_ENABLE);
+    hpet_write(HPET_REG_INT_STATUS, 1ULL << timer);
+}
@@ -0,0 +1,212 @@
+// Boruix OS 高精度定时器
+// 红黑树按expires排序（相等时后插入的排在后面），最左节点即下一个到期的定时器；
+// 新的最左节点出现时重新编程事件设备
+
+#include "drivers/hrtimer.h"
+#include "drivers/clocksource.h"
+#include "drivers/tick.h"
+#include "drivers/hpet.h"
+#include "drivers/display.h"
+#include "kernel/interrupt.h"
+#include "arch/percpu.h"
+
+typedef struct {
+    rb_root_cached_t active;
+    uint32_t cpu;
+    hrtimer_stats_t stats;
+} hrtimer_cpu_base_t;
+
+static hrtimer_cpu_base_t hrtimer_bases[HRTIMER_MAX_CPUS];
+
+// 写入HPET比较器时目标已过去，重试的最小提前量
+#define HRTIMER_HPET_RETRY_NS 10000
+
+// 没有LAPIC时钟事件设备时使用的HPET比较器
+static int hpet_timer = -1;
+
+// 按当前CPU编号选择（AP目前关中断运行，只有BSP的基准在使用）
+static inline hrtimer_cpu_base_t* this_cpu_base(void) {
+    return &hrtimer_bases[smp_processor_id()];
+}
+
+static bool hrtimer_lock(void) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    return was_enabled;
+}
+
+static void hrtimer_unlock(bool was_enabled) {
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
+
+// 挂入队列，返回是否成为新的最早定时器
+static bool enqueue_hrtimer(hrtimer_cpu_base_t* base, hrtimer_t* timer) {
+    rb_node_t** link = &base->active.root;
+    rb_node_t* parent = NULL;
+    bool leftmost = true;
+
+    while (*link) {
+        parent = *link;
+        hrtimer_t* entry = rb_entry(parent, hrtimer_t, node);
+        if (timer->expires < entry->expires) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            leftmost = false;
+        }
+    }
+
+    rb_link_node(&timer->node, parent, link);
+    rb_insert_color_cached(&timer->node, &base->active, leftmost);
+    timer->state |= HRTIMER_STATE_ENQUEUED;
+    timer->cpu = base->cpu;
+    base->stats.active++;
+    return leftmost;
+}
+
+static void dequeue_hrtimer(hrtimer_cpu_base_t* base, hrtimer_t* timer) {
+    rb_erase_cached(&timer->node, &base->active);
+    timer->state &= ~HRTIMER_STATE_ENQUEUED;
+    base->stats.active--;
+}
+
+// HPET比较器只能一次性编程，目标在写入期间已过去时加大提前量重试
+static void hpet_program(uint64_t expires) {
+    if (expires == KTIME_MAX) {
+        hpet_comparator_cancel((uint32_t)hpet_timer);
+        return;
+    }
+    uint64_t now = ktime_get_ns();
+    uint64_t delta = expires > now ? expires - now : 0;
+    while (hpet_comparator_arm((uint32_t)hpet_timer, delta) != 0) {
+        delta = delta < HRTIMER_HPET_RETRY_NS ? HRTIMER_HPET_RETRY_NS : delta * 2;
+    }
+}
+
+// 最早到期时刻变化后重新编程事件设备（关中断调用）
+static void hrtimer_reprogram(hrtimer_cpu_base_t* base) {
+    if (tick_get_device()) {
+        tick_hrtimer_update();
+    } else if (hpet_timer >= 0) {
+        rb_node_t* first = rb_first_cached(&base->active);
+        hpet_program(first ? rb_entry(first, hrtimer_t, node)->expires : KTIME_MAX);
+    }
+}
+
+static void hrtimer_hpet_event(uint32_t timer, void* ctx) {
+    (void)timer;
+    (void)ctx;
+    hrtimer_interrupt();
+}
+
+void hrtimers_init(void) {
+    for (uint32_t cpu = 0; cpu < HRTIMER_MAX_CPUS; cpu++) {
+        hrtimer_bases[cpu].active = RB_ROOT_CACHED;
+        hrtimer_bases[cpu].cpu = cpu;
+        hrtimer_bases[cpu].stats.active = 0;
+        hrtimer_bases[cpu].stats.fired = 0;
+        hrtimer_bases[cpu].stats.interrupts = 0;
+        hrtimer_bases[cpu].stats.device = "tick";
+    }
+
+    const clock_event_device_t* dev = tick_get_device();
+    if (dev) {
+        hrtimer_bases[0].stats.device = (dev->features & CLOCK_EVT_FEAT_DEADLINE) ? "lapic-deadline" : "lapic";
+    } else if (hpet_is_available()) {
+        hpet_timer = hpet_comparator_request(hrtimer_hpet_event, NULL);
+        if (hpet_timer >= 0) {
+            hrtimer_bases[0].stats.device = "hpet";
+        }
+    }
+
+    print_string("[HRTIMER] Event device: ");
+    print_string(hrtimer_bases[0].stats.device);
+    print_string("\n");
+}
+
+void hrtimer_init(hrtimer_t* timer, hrtimer_restart_t (*function)(hrtimer_t* timer)) {
+    timer->node.parent = NULL;
+    timer->node.left = NULL;
+    timer->node.right = NULL;
+    timer->expires = 0;
+    timer->function = function;
+    timer->state = HRTIMER_STATE_INACTIVE;
+    timer->cpu = 0;
+}
+
+void hrtimer_start(hrtimer_t* timer, uint64_t time, hrtimer_mode_t mode) {
+    bool state = hrtimer_lock();
+    hrtimer_cpu_base_t* base = this_cpu_base();
+
+    if (hrtimer_active(timer)) {
+        dequeue_hrtimer(&hrtimer_bases[timer->cpu], timer);
+    }
+    timer->expires = (mode == HRTIMER_MODE_REL) ? ktime_get_ns() + time : time;
+
+    if (enqueue_hrtimer(base, timer)) {
+        hrtimer_reprogram(base);
+    }
+    hrtimer_unlock(state);
+}
+
+int hrtimer_cancel(hrtimer_t* timer) {
+    bool state = hrtimer_lock();
+    if (!hrtimer_active(timer)) {
+        hrtimer_unlock(state);
+        return 0;
+    }
+    dequeue_hrtimer(&hrtimer_bases[timer->cpu], timer);
+    hrtimer_unlock(state);
+    return 1;
+}
+
+uint64_t hrtimer_forward(hrtimer_t* timer, uint64_t now, uint64_t interval) {
+    if (interval == 0 || now < timer->expires) {
+        return 0;
+    }
+    uint64_t overruns = (now - timer->expires) / interval + 1;
+    timer->expires += overruns * interval;
+    return overruns;
+}
+
+uint64_t hrtimer_next_expiry(void) {
+    rb_node_t* first = rb_first_cached(&this_cpu_base()->active);
+    return first ? rb_entry(first, hrtimer_t, node)->expires : KTIME_MAX;
+}
+
+void hrtimer_interrupt(void) {
+    hrtimer_cpu_base_t* base = this_cpu_base();
+    if (!rb_first_cached(&base->active)) {
+        return;
+    }
+
+    // 本轮只处理now之前到期的定时器，周期很短的定时器不会在中断里无限循环
+    uint64_t now = ktime_get_ns();
+    base->stats.interrupts++;
+
+    rb_node_t* node;
+    while ((node = rb_first_cached(&base->active)) != NULL) {
+        hrtimer_t* timer = rb_entry(node, hrtimer_t, node);
+        if (timer->expires > now) {
+            break;
+        }
+
+        dequeue_hrtimer(base, timer);
+        base->stats.fired++;
+        if (timer->function(timer) == HRTIMER_RESTART && !hrtimer_active(timer)) {
+            enqueue_hrtimer(base, timer);
+        }
+    }
+
+    if (!tick_get_device() && hpet_timer >= 0) {
+        hrtimer_reprogram(base);
+    }
+}
+
+void hrtimer_get_stats(hrtimer_stats_t* out) {
+    bool state = hrtimer_lock();
+    *out = this_cpu_base()->stats;
+    hrtimer_unlock(state);
+}
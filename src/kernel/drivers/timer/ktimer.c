@@ -0,0 +1,248 @@
+// Boruix OS 内核定时器（分层时间轮）
+// tv1按滴答低8位分槽，tv2~tv5各按后续6位分槽；tv1转完一圈时把下一级对应槽位
+// 下放重新插入。链表带pprev，取消时无需查找所在槽位
+
+#include "drivers/ktimer.h"
+#include "drivers/clocksource.h"
+#include "drivers/tick.h"
+#include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+
+#define TVR_MASK (KTIMER_TVR_SIZE - 1)
+#define TVN_MASK (KTIMER_TVN_SIZE - 1)
+
+// 第n级（tv2起为0）在clk下的槽位
+#define TV_INDEX(clk, n) (((clk) >> (KTIMER_TVR_BITS + (n) * KTIMER_TVN_BITS)) & TVN_MASK)
+
+typedef struct {
+    uint32_t clk;                               // 下一个要处理的滴答
+    ktimer_t* tv1[KTIMER_TVR_SIZE];
+    ktimer_t* tvn[4][KTIMER_TVN_SIZE];
+    ktimer_stats_t stats;
+} ktimer_base_t;
+
+static ktimer_base_t timer_base;
+
+static bool ktimer_lock(void) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    return was_enabled;
+}
+
+static void ktimer_unlock(bool was_enabled) {
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
+
+static void list_insert(ktimer_t** head, ktimer_t* timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void list_remove(ktimer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// 按距clk的远近选择槽位（关中断调用）
+static void internal_add_timer(ktimer_t* timer) {
+    uint32_t expires = timer->expires;
+    uint32_t idx = expires - timer_base.clk;
+    ktimer_t** head;
+
+    if ((int32_t)idx < 0) {
+        // 已经过期，放到下一个要处理的槽位
+        head = &timer_base.tv1[timer_base.clk & TVR_MASK];
+    } else if (idx < (1U << KTIMER_TVR_BITS)) {
+        head = &timer_base.tv1[expires & TVR_MASK];
+    } else if (idx < (1U << (KTIMER_TVR_BITS + KTIMER_TVN_BITS))) {
+        head = &timer_base.tvn[0][TV_INDEX(expires, 0)];
+    } else if (idx < (1U << (KTIMER_TVR_BITS + 2 * KTIMER_TVN_BITS))) {
+        head = &timer_base.tvn[1][TV_INDEX(expires, 1)];
+    } else if (idx < (1U << (KTIMER_TVR_BITS + 3 * KTIMER_TVN_BITS))) {
+        head = &timer_base.tvn[2][TV_INDEX(expires, 2)];
+    } else {
+        head = &timer_base.tvn[3][TV_INDEX(expires, 3)];
+    }
+    list_insert(head, timer);
+}
+
+// 把第n级的index槽位下放到低层，返回index
+static uint32_t cascade(uint32_t n, uint32_t index) {
+    ktimer_t* timer = timer_base.tvn[n][index];
+    timer_base.tvn[n][index] = NULL;
+    if (timer) {
+        timer_base.stats.cascades++;
+    }
+
+    while (timer) {
+        ktimer_t* next = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        internal_add_timer(timer);
+        timer = next;
+    }
+    return index;
+}
+
+// TIMER软中断：处理到当前滴答为止的所有槽位
+static void run_timers(void) {
+    bool state = ktimer_lock();
+
+    while (time_after_eq(system_ticks, timer_base.clk)) {
+        uint32_t index = timer_base.clk & TVR_MASK;
+
+        // tv1转完一圈，逐级下放
+        if (index == 0 &&
+            cascade(0, TV_INDEX(timer_base.clk, 0)) == 0 &&
+            cascade(1, TV_INDEX(timer_base.clk, 1)) == 0 &&
+            cascade(2, TV_INDEX(timer_base.clk, 2)) == 0) {
+            cascade(3, TV_INDEX(timer_base.clk, 3));
+        }
+        timer_base.clk++;
+
+        // 整个槽位先移到本地链表：回调重新挂入的定时器不会在这一轮再次执行，
+        // 每次只摘下链头，回调取消其他定时器也不会破坏遍历
+        ktimer_t* work = timer_base.tv1[index];
+        timer_base.tv1[index] = NULL;
+        if (work) {
+            work->pprev = &work;
+        }
+
+        while (work) {
+            ktimer_t* timer = work;
+            void (*func)(uintptr_t) = timer->func;
+            uintptr_t data = timer->data;
+
+            list_remove(timer);
+            timer_base.stats.pending--;
+            timer_base.stats.fired++;
+
+            ktimer_unlock(true);
+            func(data);
+            interrupts_disable();
+        }
+    }
+
+    ktimer_unlock(state);
+}
+
+// 时间轮为空时TIMER软中断不会运行，clk停在上一次处理的位置；
+// 插入前把它追到当前滴答，否则新定时器按过时的clk分层，会落进过低的级别而提前或延迟到期
+static void catch_up_clk(void) {
+    if (timer_base.stats.pending == 0) {
+        timer_base.clk = system_ticks;
+    }
+}
+
+void ktimer_init(void) {
+    timer_base.clk = system_ticks;
+    for (int i = 0; i < KTIMER_TVR_SIZE; i++) {
+        timer_base.tv1[i] = NULL;
+    }
+    for (int n = 0; n < 4; n++) {
+        for (int i = 0; i < KTIMER_TVN_SIZE; i++) {
+            timer_base.tvn[n][i] = NULL;
+        }
+    }
+    timer_base.stats.pending = 0;
+    timer_base.stats.fired = 0;
+    timer_base.stats.cascades = 0;
+
+    open_softirq(SOFTIRQ_TIMER, run_timers);
+    tick_set_next_event_hook(ktimer_next_expiry_ns);
+}
+
+void timer_setup(ktimer_t* timer, void (*func)(uintptr_t data), uintptr_t data) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->func = func;
+    timer->data = data;
+}
+
+int timer_add(ktimer_t* timer, uint32_t expires) {
+    bool state = ktimer_lock();
+    if (timer_pending(timer)) {
+        ktimer_unlock(state);
+        return -1;
+    }
+    catch_up_clk();
+    timer->expires = expires;
+    internal_add_timer(timer);
+    timer_base.stats.pending++;
+    ktimer_unlock(state);
+    return 0;
+}
+
+int timer_mod(ktimer_t* timer, uint32_t expires) {
+    bool state = ktimer_lock();
+    int was_pending = timer_pending(timer);
+    if (was_pending) {
+        list_remove(timer);
+    } else {
+        catch_up_clk();
+        timer_base.stats.pending++;
+    }
+    timer->expires = expires;
+    internal_add_timer(timer);
+    ktimer_unlock(state);
+    return was_pending;
+}
+
+int timer_cancel(ktimer_t* timer) {
+    bool state = ktimer_lock();
+    if (!timer_pending(timer)) {
+        ktimer_unlock(state);
+        return 0;
+    }
+    list_remove(timer);
+    timer_base.stats.pending--;
+    ktimer_unlock(state);
+    return 1;
+}
+
+void ktimer_tick(void) {
+    if (timer_base.stats.pending && time_after_eq(system_ticks, timer_base.clk)) {
+        raise_softirq(SOFTIRQ_TIMER);
+    }
+}
+
+uint64_t ktimer_next_expiry_ns(void) {
+    if (timer_base.stats.pending == 0) {
+        return KTIME_MAX;
+    }
+
+    // 只扫描tv1到本圈结束；更高层的定时器最早在下一次下放时才会进入tv1，
+    // 在下放点醒来重新计算即可
+    uint32_t clk = timer_base.clk;
+    uint32_t next = clk;
+    do {
+        if (timer_base.tv1[next & TVR_MASK]) {
+            break;
+        }
+        next++;
+    } while (next & TVR_MASK);
+
+    // 第next个滴答在当前滴答之后(next - system_ticks)个周期到来
+    uint32_t now_ticks = system_ticks;
+    if (!time_after(next, now_ticks)) {
+        return ktime_get_ns();
+    }
+    return ktime_get_ns() + (uint64_t)(next - now_ticks) * TICK_NSEC;
+}
+
+void ktimer_get_stats(ktimer_stats_t* out) {
+    bool state = ktimer_lock();
+    *out = timer_base.stats;
+    ktimer_unlock(state);
+}
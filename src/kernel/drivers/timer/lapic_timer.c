@@ -0,0 +1,161 @@
+// Boruix OS LAPIC定时器
+// 支持TSC-deadline时直接按TSC绝对时刻编程，否则以单次计数模式（16分频）工作，
+// 计数频率对照当前单调时钟源校准
+
+#include "kernel/interrupt.h"
+#include "arch/x86_64.h"
+#include "arch/apic.h"
+#include "drivers/tick.h"
+#include "drivers/display.h"
+
+#define LAPIC_TIMER_CALIBRATE_NS    (10 * NSEC_PER_MSEC)
+#define LAPIC_TIMER_MIN_DELTA_NS    1000
+#define LAPIC_TIMER_MAX_SECONDS     10
+
+static bool lapic_timer_ready = false;
+static bool use_deadline = false;
+static uint64_t timer_hz = 0;           // 计数频率（TSC-deadline时为TSC频率）
+static uint32_t ns_mult = 0;            // 纳秒->计数
+static uint32_t ns_shift = 0;
+
+static inline uint64_t ns_to_counts(uint64_t ns) {
+    return (ns * ns_mult) >> ns_shift;
+}
+
+static int lapic_next_event(uint64_t delta_ns) {
+    uint64_t counts = ns_to_counts(delta_ns);
+    if (counts == 0) {
+        counts = 1;
+    }
+    if (counts > 0xFFFFFFFFULL) {
+        counts = 0xFFFFFFFFULL;
+    }
+    lapic_write_reg(LAPIC_REG_TIMER_INITIAL, (uint32_t)counts);
+    return 0;
+}
+
+static int lapic_next_deadline(uint64_t delta_ns) {
+    cpu_write_msr(MSR_IA32_TSC_DEADLINE, cpu_rdtsc() + ns_to_counts(delta_ns));
+    return 0;
+}
+
+static void lapic_timer_shutdown(void) {
+    lapic_write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_MASKED);
+    if (use_deadline) {
+        cpu_write_msr(MSR_IA32_TSC_DEADLINE, 0);
+    } else {
+        lapic_write_reg(LAPIC_REG_TIMER_INITIAL, 0);
+    }
+}
+
+static clock_event_device_t lapic_clockevent = {
+    .name = "lapic",
+    .features = CLOCK_EVT_FEAT_ONESHOT,
+    .min_delta_ns = LAPIC_TIMER_MIN_DELTA_NS,
+    .max_delta_ns = 0,
+    .rating = 100,
+    .set_next_event = lapic_next_event,
+    .shutdown = lapic_timer_shutdown,
+};
+
+static void lapic_timer_irq(uint8_t vector) {
+    (void)vector;
+    tick_handle_event();
+}
+
+// 写入LVT定时器（解除屏蔽）
+static void lapic_timer_setup_lvt(void) {
+    if (use_deadline) {
+        lapic_write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_TSC_DEADLINE);
+        // LVT写入需在写IA32_TSC_DEADLINE之前生效
+        __asm__ volatile("mfence" ::: "memory");
+    } else {
+        lapic_write_reg(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+        lapic_write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_ONESHOT);
+    }
+}
+
+// 屏蔽状态下从最大值倒数一段时间，按单调时钟换算计数频率
+static uint64_t lapic_timer_calibrate(void) {
+    lapic_write_reg(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    lapic_write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_MASKED);
+
+    uint64_t start = ktime_get_ns();
+    lapic_write_reg(LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFF);
+    uint64_t now;
+    do {
+        now = ktime_get_ns();
+    } while (now - start < LAPIC_TIMER_CALIBRATE_NS);
+    uint32_t current = lapic_read_reg(LAPIC_REG_TIMER_CURRENT);
+    lapic_write_reg(LAPIC_REG_TIMER_INITIAL, 0);
+
+    return (uint64_t)(0xFFFFFFFFU - current) * NSEC_PER_SEC / (now - start);
+}
+
+int lapic_timer_init(void) {
+    if (!apic_is_enabled()) {
+        return -1;
+    }
+
+    // 校准和滴答都依赖精确的单调时钟，滴答计数时钟源本身由滴答驱动
+    const clocksource_t* cs = clocksource_get_current();
+    if (!cs || cs->rating <= 1) {
+        print_string("[LAPIC] No precise clocksource, keeping PIT tick\n");
+        return -1;
+    }
+
+    // TSC-deadline按TSC频率换算，只在TSC频率恒定时使用
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    use_deadline = (ecx & CPUID_FEAT_ECX_TSC_DEADLINE) && tsc_get_freq_hz() && tsc_is_invariant();
+
+    uint64_t max_counts;
+    if (use_deadline) {
+        timer_hz = tsc_get_freq_hz();
+        max_counts = timer_hz * LAPIC_TIMER_MAX_SECONDS;
+        lapic_clockevent.features |= CLOCK_EVT_FEAT_DEADLINE;
+        lapic_clockevent.set_next_event = lapic_next_deadline;
+        lapic_clockevent.rating = 150;
+    } else {
+        timer_hz = lapic_timer_calibrate();
+        if (timer_hz == 0) {
+            print_string("[LAPIC] Timer calibration failed\n");
+            return -1;
+        }
+        max_counts = 0xFFFFFFFFULL;
+    }
+
+    clocks_calc_mult_shift(&ns_mult, &ns_shift, NSEC_PER_SEC, timer_hz, LAPIC_TIMER_MAX_SECONDS);
+    lapic_clockevent.max_delta_ns = max_counts * NSEC_PER_SEC / timer_hz;
+    if (lapic_clockevent.max_delta_ns > LAPIC_TIMER_MAX_SECONDS * NSEC_PER_SEC) {
+        lapic_clockevent.max_delta_ns = LAPIC_TIMER_MAX_SECONDS * NSEC_PER_SEC;
+    }
+
+    if (request_irq_fast(LAPIC_TIMER_VECTOR, lapic_timer_irq) != 0) {
+        print_string("[LAPIC] Timer vector busy\n");
+        return -1;
+    }
+    lapic_timer_setup_lvt();
+
+    if (clockevents_register(&lapic_clockevent) != 0) {
+        lapic_timer_shutdown();
+        free_irq_fast(LAPIC_TIMER_VECTOR);
+        return -1;
+    }
+    lapic_timer_ready = true;
+
+    print_string("[LAPIC] Timer ");
+    print_string(use_deadline ? "TSC-deadline" : "one-shot");
+    print_string(" mode, ");
+    print_dec((uint32_t)(timer_hz / 1000));
+    print_string(" kHz, NO_HZ idle enabled\n");
+    return 0;
+}
+
+void lapic_timer_resume(void) {
+    if (!lapic_timer_ready) {
+        return;
+    }
+    lapic_timer_setup_lvt();
+    tick_resume();
+}
@@ -0,0 +1,213 @@
+// Boruix OS 时钟事件与NO_HZ空闲
+// 一次性设备在每个滴答边界重新编程，边界由单调时钟决定，迟到的中断不会累积误差；
+// 空闲时把设备编程到下一个到期时刻并停掉滴答，醒来后按经过的时间补记滴答；
+// 设备实际编程为滴答和最早高精度定时器中较早的一个
+
+#include "drivers/tick.h"
+#include "kernel/interrupt.h"
+#include "kernel/softirq.h"
+#include "kernel/irq_latency.h"
+#include "drivers/hrtimer.h"
+
+static clock_event_device_t* tick_dev = NULL;
+static tick_next_event_fn next_event_hook = NULL;
+
+static uint64_t next_tick_ns = 0;       // 下一个滴答边界
+static uint64_t tick_expires_ns = 0;    // 滴答希望的到期时刻（下一个滴答或空闲唤醒）
+static uint64_t next_event_ns = 0;      // 设备当前编程的到期时刻
+static bool tick_stopped = false;
+static uint64_t idle_start_ns = 0;
+
+static tick_stats_t stats;
+
+// 按滴答和高精度定时器中较早的到期时刻编程设备，截断到设备可编程范围
+static void tick_reprogram(void) {
+    uint64_t expires = tick_expires_ns;
+    uint64_t hr = hrtimer_next_expiry();
+    if (hr < expires) {
+        expires = hr;
+    }
+
+    uint64_t now = ktime_get_ns();
+    uint64_t delta = expires > now ? expires - now : 0;
+
+    if (delta < tick_dev->min_delta_ns) {
+        delta = tick_dev->min_delta_ns;
+    }
+    if (delta > tick_dev->max_delta_ns) {
+        delta = tick_dev->max_delta_ns;
+    }
+
+    next_event_ns = now + delta;
+    tick_dev->set_next_event(delta);
+}
+
+static void tick_program(uint64_t expires) {
+    tick_expires_ns = expires;
+    tick_reprogram();
+}
+
+// 把滴答边界推进到now之后，返回经过的滴答数
+static uint32_t tick_catch_up(uint64_t now) {
+    if (now < next_tick_ns) {
+        return 0;
+    }
+    uint64_t ticks = (now - next_tick_ns) / TICK_NSEC + 1;
+    next_tick_ns += ticks * TICK_NSEC;
+    timer_do_ticks((uint32_t)ticks);
+    return (uint32_t)ticks;
+}
+
+// 停掉滴答后补记：跨越空闲间隔的这次滴答不是周期滴答，先丢弃抖动基准，
+// 补记的滴答只作为新的测量起点
+static uint32_t tick_catch_up_idle(uint64_t now) {
+    if (now < next_tick_ns) {
+        return 0;
+    }
+    irq_latency_resync();
+    return tick_catch_up(now);
+}
+
+int clockevents_register(clock_event_device_t* dev) {
+    if (!dev || !dev->set_next_event || !(dev->features & CLOCK_EVT_FEAT_ONESHOT)) {
+        return -1;
+    }
+    if (tick_dev && dev->rating <= tick_dev->rating) {
+        return -1;
+    }
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    if (tick_dev && tick_dev->shutdown) {
+        tick_dev->shutdown();
+    } else if (!tick_dev) {
+        timer_pit_stop();
+    }
+
+    tick_dev = dev;
+    tick_stopped = false;
+    next_tick_ns = ktime_get_ns() + TICK_NSEC;
+    tick_program(next_tick_ns);
+
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    return 0;
+}
+
+void tick_handle_event(void) {
+    stats.events++;
+
+    hrtimer_interrupt();
+    uint64_t now = ktime_get_ns();
+    uint32_t ticks = tick_stopped ? tick_catch_up_idle(now) : tick_catch_up(now);
+
+    // 停掉滴答期间保持空闲唤醒时刻，由idle退出路径恢复周期滴答
+    if (tick_stopped) {
+        if (ticks > 1) {
+            stats.ticks_skipped += ticks - 1;
+        }
+        tick_reprogram();
+        return;
+    }
+    tick_program(next_tick_ns);
+}
+
+void tick_resume(void) {
+    if (tick_dev) {
+        tick_reprogram();
+    }
+}
+
+void tick_hrtimer_update(void) {
+    // 只有更早时才需要重新编程；最早的定时器被取消时留下一次空事件即可
+    if (tick_dev && hrtimer_next_expiry() < next_event_ns) {
+        tick_reprogram();
+    }
+}
+
+const clock_event_device_t* tick_get_device(void) {
+    return tick_dev;
+}
+
+void tick_get_stats(tick_stats_t* out) {
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    *out = stats;
+    if (was_enabled) {
+        interrupts_enable();
+    }
+}
+
+void tick_set_next_event_hook(tick_next_event_fn fn) {
+    next_event_hook = fn;
+}
+
+void tick_nohz_idle_enter(void) {
+    if (!tick_dev || tick_stopped) {
+        return;
+    }
+
+    uint64_t now = ktime_get_ns();
+    uint64_t expires = now + NOHZ_MAX_IDLE_NS;
+    if (next_event_hook) {
+        uint64_t next = next_event_hook();
+        if (next < expires) {
+            expires = next;
+        }
+    }
+
+    // 下一个事件不晚于下一个滴答，停掉滴答没有收益
+    if (expires <= next_tick_ns + TICK_NSEC) {
+        return;
+    }
+
+    // 对齐到滴答边界，醒来时正好补记整数个滴答
+    expires = next_tick_ns + ((expires - next_tick_ns) / TICK_NSEC) * TICK_NSEC;
+
+    tick_stopped = true;
+    idle_start_ns = now;
+    stats.nohz_entries++;
+    tick_program(expires);
+}
+
+void tick_nohz_idle_exit(void) {
+    if (!tick_stopped) {
+        return;
+    }
+    tick_stopped = false;
+
+    uint64_t now = ktime_get_ns();
+    stats.idle_ns += now - idle_start_ns;
+
+    // 通常唤醒事件已在tick_handle_event中补记；被其他中断唤醒时在这里补记，
+    // 此时不在滴答边界上，下一个间隔不完整，从下一个滴答重新开始测量
+    uint32_t ticks = tick_catch_up_idle(now);
+    if (ticks > 0) {
+        stats.ticks_skipped += ticks;
+        irq_latency_resync();
+    }
+    tick_program(next_tick_ns);
+}
+
+void cpu_idle(void) {
+    interrupts_disable();
+    stats.idle_entries++;
+
+    // 上次中断退出时软中断预算用完，先把剩余工作做完
+    if (softirq_pending()) {
+        do_softirq();
+        interrupts_enable();
+        return;
+    }
+
+    tick_nohz_idle_enter();
+
+    // sti的下一条指令执行完之前不响应中断，检查和睡眠之间不会漏掉唤醒
+    __asm__ volatile("sti; hlt" ::: "memory");
+
+    interrupts_disable();
+    tick_nohz_idle_exit();
+    interrupts_enable();
+}
@@ -1,6 +1,12 @@
 // Boruix OS 定时器驱动实现
 
 #include "drivers/timer.h"
+#include "drivers/clocksource.h"
+#include "drivers/ktimer.h"
+#include "drivers/hrtimer.h"
+#include "kernel/interrupt.h"
+#include "kernel/irq_latency.h"
+#include "arch/x86_64.h"
 
 // PIT端口
 #define PIT_CHANNEL0 0x40
@@ -11,12 +17,43 @@ static inline void outb(uint16_t port, uint8_t value) {
     __asm__ volatile("outb %0, %1" : : "a"(value), "Nd"(port));
 }
 
-// 系统时钟滴答计数
+// 系统时钟滴答计数（兼容接口，精确时间使用ktime_get_ns）
 volatile uint32_t system_ticks = 0;
 
+static uint64_t jiffies_read(void) {
+    return system_ticks;
+}
+
+// 滴答计数作为保底时钟源，TSC校准完成后被取代
+static clocksource_t jiffies_clocksource = {
+    .name = "jiffies",
+    .read = jiffies_read,
+    .mask = 0xFFFFFFFFULL,
+    .freq_hz = TIMER_FREQ_HZ,
+    .mult = 0,
+    .shift = 0,
+    .rating = 1,
+};
+
+void timer_do_ticks(uint32_t ticks) {
+    system_ticks += ticks;
+    clocksource_tick();
+    irq_latency_tick(cpu_rdtsc());
+    ktimer_tick();
+}
+
 // 定时器中断处理
 void timer_irq_handler(void) {
-    system_ticks++;
+    timer_do_ticks(1);
+    
+    // 没有LAPIC时钟事件设备和HPET比较器时，高精度定时器退化为滴答精度
+    hrtimer_interrupt();
+}
+
+// 时钟中断走精简入口
+static void timer_irq(uint8_t vector) {
+    (void)vector;
+    timer_irq_handler();
 }
 
 // 初始化定时器
@@ -31,9 +68,21 @@ void timer_init(uint32_t frequency) {
     // 发送频率除数
     outb(PIT_CHANNEL0, (uint8_t)(divisor & 0xFF));
     outb(PIT_CHANNEL0, (uint8_t)((divisor >> 8) & 0xFF));
+    
+    clocksource_register(&jiffies_clocksource);
+    request_irq_fast(IRQ_BASE + 0, timer_irq);
+}
+
+void timer_pit_stop(void) {
+    irq_mask_line(0);
+    
+    // 方式0（计数结束中断）只触发一次，之后计数器不再产生中断
+    outb(PIT_COMMAND, 0x30);
+    outb(PIT_CHANNEL0, 0);
+    outb(PIT_CHANNEL0, 0);
 }
 
 // 获取系统运行时间（秒）
 uint32_t timer_get_seconds(void) {
-    return system_ticks / TIMER_FREQ_HZ;
+    return (uint32_t)(ktime_get_ns() / NSEC_PER_SEC);
 }
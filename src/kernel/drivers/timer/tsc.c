@@ -0,0 +1,167 @@
+// Boruix OS TSC时钟源
+// 启动时以HPET为参考测量TSC频率，没有HPET时用PIT通道2（一次性计数，不影响通道0的系统时钟）
+
+#include "drivers/clocksource.h"
+#include "drivers/hpet.h"
+#include "drivers/display.h"
+#include "kernel/interrupt.h"
+#include "arch/x86_64.h"
+
+// PIT通道2和门控端口
+#define PIT_FREQ_HZ         1193182
+#define PIT_CHANNEL2        0x42
+#define PIT_COMMAND         0x43
+#define PIT_GATE_PORT       0x61
+#define PIT_GATE_CH2        0x01    // 通道2门控
+#define PIT_SPEAKER         0x02    // 扬声器输出
+#define PIT_OUT2            0x20    // 通道2输出状态
+
+#define TSC_CALIBRATE_MS    10
+#define TSC_CALIBRATE_ROUNDS 3
+
+// 等待OUT2的最大轮询次数，防止没有通道2的平台卡死
+#define TSC_CALIBRATE_SPIN_LIMIT 10000000
+
+static inline void outb(uint16_t port, uint8_t value) {
+    __asm__ volatile("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t value;
+    __asm__ volatile("inb %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+static uint64_t tsc_freq_hz = 0;
+static bool tsc_invariant = false;
+
+static uint64_t tsc_read(void) {
+    return cpu_rdtsc();
+}
+
+static clocksource_t tsc_clocksource = {
+    .name = "tsc",
+    .read = tsc_read,
+    .mask = 0xFFFFFFFFFFFFFFFFULL,
+    .freq_hz = 0,
+    .mult = 0,
+    .shift = 0,
+    .rating = 300,
+};
+
+// 一轮校准：通道2方式0计数ms毫秒，返回期间的TSC周期数，失败返回0
+static uint64_t pit_measure_tsc(uint32_t ms) {
+    uint32_t latch = PIT_FREQ_HZ * ms / 1000;
+
+    // 打开通道2门控，关闭扬声器
+    outb(PIT_GATE_PORT, (inb(PIT_GATE_PORT) & ~PIT_SPEAKER) | PIT_GATE_CH2);
+
+    // 通道2，先低后高字节，方式0（计数结束时OUT2变高），二进制
+    outb(PIT_COMMAND, 0xB0);
+    outb(PIT_CHANNEL2, (uint8_t)(latch & 0xFF));
+    outb(PIT_CHANNEL2, (uint8_t)(latch >> 8));
+
+    uint64_t start = cpu_rdtsc();
+    uint32_t spins = 0;
+    while (!(inb(PIT_GATE_PORT) & PIT_OUT2)) {
+        if (++spins > TSC_CALIBRATE_SPIN_LIMIT) {
+            return 0;
+        }
+    }
+    return cpu_rdtsc() - start;
+}
+
+// 一轮校准：等待HPET走过ms毫秒，返回换算出的TSC频率，失败返回0
+static uint64_t hpet_measure_tsc_hz(uint32_t ms) {
+    hpet_info_t info;
+    hpet_get_info(&info);
+    uint64_t mask = info.counter_64bit ? 0xFFFFFFFFFFFFFFFFULL : 0xFFFFFFFFULL;
+    uint64_t ticks = info.freq_hz * ms / 1000;
+
+    uint64_t h0 = hpet_read_counter();
+    uint64_t t0 = cpu_rdtsc();
+    uint64_t h1, t1;
+    uint32_t spins = 0;
+    do {
+        if (++spins > TSC_CALIBRATE_SPIN_LIMIT) {
+            return 0;
+        }
+        h1 = hpet_read_counter();
+        t1 = cpu_rdtsc();
+    } while (((h1 - h0) & mask) < ticks);
+
+    return (t1 - t0) * info.freq_hz / ((h1 - h0) & mask);
+}
+
+int tsc_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_EDX_TSC)) {
+        return -1;
+    }
+
+    cpu_cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000007) {
+        cpu_cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx);
+        tsc_invariant = (edx & CPUID_APM_EDX_INVARIANT_TSC) != 0;
+    }
+
+    // 关中断测量，取多轮中的最小值（被打断只会让结果偏大）
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    bool use_hpet = hpet_is_available();
+    uint64_t best = 0;
+    for (int round = 0; round < TSC_CALIBRATE_ROUNDS; round++) {
+        uint64_t hz;
+        if (use_hpet) {
+            hz = hpet_measure_tsc_hz(TSC_CALIBRATE_MS);
+        } else {
+            hz = pit_measure_tsc(TSC_CALIBRATE_MS) * 1000 / TSC_CALIBRATE_MS;
+        }
+        if (hz && (best == 0 || hz < best)) {
+            best = hz;
+        }
+    }
+
+    if (was_enabled) {
+        interrupts_enable();
+    }
+
+    if (best == 0) {
+        print_string(use_hpet ? "[TSC] HPET calibration failed\n" : "[TSC] PIT channel 2 calibration failed\n");
+        return -1;
+    }
+
+    tsc_freq_hz = best;
+
+    // 非不变TSC会随频率变化，评级低于其他硬件时钟源
+    tsc_clocksource.freq_hz = tsc_freq_hz;
+    tsc_clocksource.rating = tsc_invariant ? 300 : 100;
+    clocksource_register(&tsc_clocksource);
+
+    print_string("[TSC] ");
+    print_dec((uint32_t)(tsc_freq_hz / 1000000));
+    print_string(".");
+    uint32_t frac = (uint32_t)((tsc_freq_hz / 1000) % 1000);
+    if (frac < 100) print_char('0');
+    if (frac < 10) print_char('0');
+    print_dec(frac);
+    print_string(" MHz, ");
+    print_string(tsc_invariant ? "invariant" : "not invariant");
+    print_string(use_hpet ? ", HPET reference" : ", PIT reference");
+    print_string(", mult=");
+    print_dec(tsc_clocksource.mult);
+    print_string(" shift=");
+    print_dec(tsc_clocksource.shift);
+    print_string("\n");
+    return 0;
+}
+
+uint64_t tsc_get_freq_hz(void) {
+    return tsc_freq_hz;
+}
+
+bool tsc_is_invariant(void) {
+    return tsc_invariant;
+}
@@ -3,6 +3,7 @@
 
 #include "kernel/tty.h"
 #include "kernel/memory.h"
+#include "kernel/spinlock.h"
 #include "../../kernel/shell/utils/string.h"
 
 // 内核日志缓冲区
@@ -11,6 +12,9 @@ static size_t klog_head = 0;
 static size_t klog_tail = 0;
 static bool klog_initialized = false;
 
+// 保护环形缓冲区的头尾指针（日志可能在中断处理程序中写入）
+DEFINE_SPINLOCK(klog_lock);
+
 // 日志级别颜色映射
 static const char* log_level_colors[] = {
     "\033[36m",  // DEBUG - 青色
@@ -47,10 +51,8 @@ static bool klog_is_full(void) {
     return (klog_head + 1) % KMSG_BUFFER_SIZE == klog_tail;
 }
 
-// 向日志缓冲区写入字符
-void klog_putc(char c) {
-    if (!klog_initialized) klog_init();
-    
+// 写入一个字符（调用者持有klog_lock）
+static void klog_putc_locked(char c) {
     klog_buffer[klog_head] = c;
     klog_head = (klog_head + 1) % KMSG_BUFFER_SIZE;
     
@@ -60,23 +62,40 @@ void klog_putc(char c) {
     }
 }
 
-// 向日志缓冲区写入字符串
+// 向日志缓冲区写入字符
+void klog_putc(char c) {
+    if (!klog_initialized) klog_init();
+    
+    uint64_t flags = spin_lock_irqsave(&klog_lock);
+    klog_putc_locked(c);
+    spin_unlock_irqrestore(&klog_lock, flags);
+}
+
+// 向日志缓冲区写入字符串（整条消息一次加锁，不会与其他消息交错）
 void klog_write(const char *str) {
     if (!str) return;
+    if (!klog_initialized) klog_init();
     
+    uint64_t flags = spin_lock_irqsave(&klog_lock);
     while (*str) {
-        klog_putc(*str++);
+        klog_putc_locked(*str++);
     }
+    spin_unlock_irqrestore(&klog_lock, flags);
 }
 
 // 从日志缓冲区读取字符
 int klog_getc(void) {
-    if (!klog_initialized || klog_is_empty()) {
+    if (!klog_initialized) {
         return -1;
     }
     
-    char c = klog_buffer[klog_tail];
-    klog_tail = (klog_tail + 1) % KMSG_BUFFER_SIZE;
+    int c = -1;
+    uint64_t flags = spin_lock_irqsave(&klog_lock);
+    if (!klog_is_empty()) {
+        c = klog_buffer[klog_tail];
+        klog_tail = (klog_tail + 1) % KMSG_BUFFER_SIZE;
+    }
+    spin_unlock_irqrestore(&klog_lock, flags);
     return c;
 }
 
@@ -84,12 +103,10 @@ int klog_getc(void) {
 void klog_flush(void) {
     if (!kernel_tty_session) return;
     
-    while (!klog_is_empty()) {
-        int c = klog_getc();
-        if (c >= 0) {
-            char ch = (char)c;
-            kernel_tty_session->ops.write(kernel_tty_session, &ch, 1);
-        }
+    int c;
+    while ((c = klog_getc()) >= 0) {
+        char ch = (char)c;
+        kernel_tty_session->ops.write(kernel_tty_session, &ch, 1);
     }
     
     // 刷新TTY输出
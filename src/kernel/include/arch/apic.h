@@ -0,0 +1,159 @@
+// Boruix OS Local APIC / I/O APIC 驱动
+// 从ACPI MADT发现中断控制器，取代8259 PIC
+
+#ifndef APIC_H
+#define APIC_H
+
+#include "kernel/types.h"
+#include "arch/x86_64.h"
+
+// 支持的控制器数量上限
+#define APIC_MAX_IOAPICS        8
+#define APIC_MAX_CPUS           64
+#define APIC_ISA_IRQS           16
+
+// 伪中断向量（低4位必须全为1）
+#define APIC_SPURIOUS_VECTOR    0xFF
+
+// LAPIC定时器向量（高于所有ISA优先级类，不会被TPR挂起）
+#define LAPIC_TIMER_VECTOR      0xEF
+
+// Local APIC寄存器偏移
+#define LAPIC_REG_ID            0x020
+#define LAPIC_REG_VERSION       0x030
+#define LAPIC_REG_TPR           0x080
+#define LAPIC_REG_EOI           0x0B0
+#define LAPIC_REG_SVR           0x0F0
+#define LAPIC_REG_ISR           0x100
+#define LAPIC_REG_IRR           0x200
+#define LAPIC_REG_ESR           0x280
+#define LAPIC_REG_ICR_LOW       0x300
+#define LAPIC_REG_ICR_HIGH      0x310
+#define LAPIC_REG_LVT_TIMER     0x320
+#define LAPIC_REG_LVT_LINT0     0x350
+#define LAPIC_REG_LVT_LINT1     0x360
+#define LAPIC_REG_LVT_ERROR     0x370
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE  0x3E0
+
+// LVT定时器模式
+#define LAPIC_TIMER_MASKED      (1 << 16)
+#define LAPIC_TIMER_ONESHOT     (0 << 17)
+#define LAPIC_TIMER_PERIODIC    (1 << 17)
+#define LAPIC_TIMER_TSC_DEADLINE (2 << 17)
+#define LAPIC_TIMER_DIVIDE_16   0x3
+
+// x2APIC寄存器MSR基址（MSR = 0x800 + 偏移/16）
+#define X2APIC_MSR_BASE         0x800
+#define X2APIC_MSR_EOI          (X2APIC_MSR_BASE + (LAPIC_REG_EOI >> 4))
+
+// ICR低32位常用值
+#define LAPIC_ICR_FIXED         (0 << 8)
+#define LAPIC_ICR_NMI           (4 << 8)
+#define LAPIC_ICR_INIT          (5 << 8)
+#define LAPIC_ICR_STARTUP       (6 << 8)
+#define LAPIC_ICR_ASSERT        (1 << 14)
+#define LAPIC_ICR_SELF          (1 << 18)
+#define LAPIC_ICR_ALL_BUT_SELF  (3 << 18)
+
+// Local APIC寄存器（xAPIC模式，UC映射），apic_init成功前为NULL
+extern volatile uint32_t* lapic_regs;
+
+// 当前是否工作在x2APIC模式
+extern bool lapic_x2apic;
+
+// 发送EOI：x2APIC一次wrmsr，xAPIC一次MMIO写
+static inline void lapic_send_eoi(void) {
+    if (lapic_x2apic) {
+        cpu_write_msr(X2APIC_MSR_EOI, 0);
+    } else {
+        lapic_regs[LAPIC_REG_EOI / 4] = 0;
+    }
+}
+
+// 控制器信息（供irqinfo显示）
+typedef struct {
+    uint64_t lapic_phys;        // Local APIC物理地址
+    uint32_t lapic_id;          // BSP的APIC ID
+    uint32_t lapic_version;     // 版本寄存器
+    uint32_t cpu_count;         // MADT中已启用的处理器数
+    uint32_t ioapic_count;      // I/O APIC数量
+    bool     pic_compat;        // 存在兼容8259 PIC
+    bool     x2apic;            // 工作在x2APIC模式
+} apic_info_t;
+
+// I/O APIC信息
+typedef struct {
+    uint64_t phys;              // 物理地址
+    uint8_t  id;                // I/O APIC ID
+    uint32_t gsi_base;          // 起始GSI
+    uint32_t redirections;      // 重定向条目数
+} ioapic_info_t;
+
+// 初始化：解析MADT、启用BSP的Local APIC、把ISA IRQ路由到IRQ_BASE+n（全部屏蔽）
+// 返回0成功，-1表示无可用APIC（调用者应继续使用PIC）
+int apic_init(void);
+
+// 在AP上启用并配置Local APIC（与BSP相同的工作模式），返回0成功
+// 有AP上线后不再允许lapic_set_mode切换模式
+int lapic_init_ap(void);
+
+// APIC是否已接管中断
+bool apic_is_enabled(void);
+
+// 读取当前CPU的APIC ID（x2APIC下为32位ID）
+uint32_t lapic_get_id(void);
+
+// x2APIC支持与运行时模式切换（切换会重新配置LAPIC），返回0成功，-1不支持或已有AP上线
+bool lapic_x2apic_supported(void);
+int lapic_set_mode(bool x2apic);
+
+// 已有AP上线，lapic_set_mode不再允许切换模式
+bool lapic_mode_switch_locked(void);
+
+// 任务优先级寄存器（低于TPR优先级类的中断被挂起）
+void lapic_set_tpr(uint8_t priority);
+uint8_t lapic_get_tpr(void);
+
+// 直接访问Local APIC寄存器（按当前模式选择MMIO或MSR），供LAPIC定时器等使用
+uint32_t lapic_read_reg(uint32_t reg);
+void lapic_write_reg(uint32_t reg, uint32_t value);
+
+// LAPIC定时器：校准并注册为时钟事件设备，接管周期滴答，返回0成功
+int lapic_timer_init(void);
+
+// 模式切换会复位LVT，由lapic_set_mode调用以恢复定时器
+void lapic_timer_resume(void);
+
+// 读取中断请求寄存器的第index个32位字（向量index*32..index*32+31）
+uint32_t lapic_read_irr(uint32_t index);
+
+// 发送IPI：icr_low为投递模式、触发方式和向量（LAPIC_ICR_*）
+void lapic_send_ipi(uint32_t apic_id, uint32_t icr_low);
+
+// 屏蔽/解除屏蔽ISA IRQ对应的I/O APIC输入，返回0成功，-1失败
+int ioapic_mask_irq(uint8_t irq);
+int ioapic_unmask_irq(uint8_t irq);
+
+// 修改ISA IRQ的投递向量（保留屏蔽和触发方式），返回0成功，-1失败
+int ioapic_set_vector(uint8_t irq, uint8_t vector);
+
+// 把非ISA的GSI路由到vector并发往BSP（初始屏蔽），返回0成功，-1失败（GSI被ISA线占用或不存在）
+int ioapic_route_gsi(uint32_t gsi, uint8_t vector, bool level);
+int ioapic_mask_gsi(uint32_t gsi, bool masked);
+
+// 屏蔽/解除屏蔽经ioapic_route_gsi路由到vector的GSI，向量不是GSI路由的返回-1
+int ioapic_mask_vector(uint8_t vector, bool masked);
+
+// ISA IRQ经中断源覆盖后的GSI
+uint32_t ioapic_irq_to_gsi(uint8_t irq);
+
+// 读取GSI的重定向表项，返回0成功，-1表示GSI不属于任何I/O APIC
+int ioapic_read_redirection(uint32_t gsi, uint64_t* entry);
+
+// 查询信息
+void apic_get_info(apic_info_t* info);
+bool ioapic_get_info(uint32_t index, ioapic_info_t* info);
+
+#endif // APIC_H
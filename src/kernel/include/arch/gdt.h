@@ -3,9 +3,12 @@
 
 #include "kernel/types.h"
 
-// GDT初始化
+// GDT初始化（BSP）
 void gdt_init(void);
 
+// AP初始化自己的GDT并加载TSS
+void gdt_init_cpu(uint32_t cpu);
+
 // 获取GDT基址
 uint64_t gdt_get_base(void);
 
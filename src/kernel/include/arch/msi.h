@@ -0,0 +1,37 @@
+// Boruix OS PCI MSI/MSI-X 中断
+// 为PCI设备分配向量并写入消息地址/数据，驱动再用request_irq挂接处理程序
+
+#ifndef MSI_H
+#define MSI_H
+
+#include "kernel/types.h"
+
+// pci_alloc_irq_vectors标志
+#define PCI_IRQ_MSI             0x01
+#define PCI_IRQ_MSIX            0x02
+
+// 每个设备最多的向量数和同时使用消息中断的设备数
+#define PCI_MSI_MAX_VECTORS     32
+#define PCI_MSI_MAX_DEVICES     16
+
+// 为设备分配min_vecs..max_vecs个向量（优先MSI-X），返回实际数量，失败返回-1
+// 需要APIC；成功后按队列号用pci_irq_vector取得向量
+int pci_alloc_irq_vectors(size_t device_index, uint32_t min_vecs, uint32_t max_vecs, uint32_t flags);
+
+// 第nr个队列的向量，失败返回-1
+int pci_irq_vector(size_t device_index, uint32_t nr);
+
+// 当前使用的模式（PCI_IRQ_MSI/PCI_IRQ_MSIX），未启用返回0
+uint32_t pci_irq_mode(size_t device_index);
+
+// 屏蔽/解除屏蔽单个MSI-X表项，返回0成功，-1失败
+int pci_msix_mask_vector(size_t device_index, uint32_t nr, int masked);
+
+// 按向量屏蔽/解除屏蔽MSI-X表项（供中断风暴检测使用），向量不属于MSI-X返回-1
+// 多消息MSI没有逐向量屏蔽，返回-1
+int msi_mask_vector(uint8_t vector, int masked);
+
+// 关闭消息中断并释放向量（调用前先free_irq各队列的处理程序）
+void pci_free_irq_vectors(size_t device_index);
+
+#endif // MSI_H
@@ -0,0 +1,151 @@
+// Boruix OS 每CPU数据
+// 每个CPU一页，IA32_GS_BASE指向本CPU的页；this_cpu_*访问器编译为单条gs相对指令，
+// 读-改-写在本CPU上不会被中断打断，不需要锁或关中断
+
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include "kernel/types.h"
+
+#define MSR_IA32_GS_BASE        0xC0000101
+
+// 中断优先级最大嵌套深度（每个优先级最多一层）
+#define IRQ_MAX_NESTING         8
+
+// isr.asm使用的字段偏移（修改结构时同步更新isr.asm）
+#define PERCPU_IRQ_STACK_TOP    16
+#define PERCPU_IRQ_STACK_NEST   24
+
+typedef struct percpu {
+    struct percpu* self;                    // 本页的线性地址
+    uint32_t cpu;                           // 逻辑编号（0为BSP）
+    uint32_t apic_id;                       // Local APIC ID
+    uint64_t irq_stack_top;                 // 中断栈栈顶
+    uint64_t irq_stack_nesting;             // 中断栈嵌套深度
+    uint32_t irq_depth;                     // irq_handler嵌套深度，回到0时执行软中断
+    uint32_t interrupt_nesting;             // 优先级嵌套计数
+    uint8_t interrupt_level;                // 当前中断优先级
+    uint8_t level_stack[IRQ_MAX_NESTING];   // 被打断的外层优先级
+    uint64_t interrupt_counts[256];         // 按向量的中断计数
+    uint32_t softirq_pending;               // 待处理软中断位图
+    uint32_t softirq_active;                // 正在执行软中断，防止嵌套中断重复进入
+    struct tasklet* tasklet_head[2];        // tasklet队列：[0]普通，[1]高优先级
+    struct tasklet* tasklet_tail[2];        // 队尾节点（队列为空时无意义）
+} percpu_t;
+
+// 字段在每CPU页中的偏移
+#define PERCPU_OFFSET(field) __builtin_offsetof(percpu_t, field)
+#define PERCPU_TYPE(field) __typeof__(((percpu_t*)0)->field)
+
+// 按字段大小选择指令后缀
+#define __percpu_suffix_op(size, insn_b, insn_w, insn_l, insn_q, ...)       \
+    do {                                                                    \
+        switch (size) {                                                     \
+        case 1: __asm__ volatile(insn_b __VA_ARGS__); break;                \
+        case 2: __asm__ volatile(insn_w __VA_ARGS__); break;                \
+        case 4: __asm__ volatile(insn_l __VA_ARGS__); break;                \
+        default: __asm__ volatile(insn_q __VA_ARGS__); break;               \
+        }                                                                   \
+    } while (0)
+
+// 读取本CPU的字段
+#define this_cpu_read(field) ({                                             \
+    PERCPU_TYPE(field) __ret;                                               \
+    __asm__ volatile("mov %%gs:%c1, %0"                                     \
+                     : "=r"(__ret) : "i"(PERCPU_OFFSET(field)));            \
+    __ret;                                                                  \
+})
+
+// 写入本CPU的字段
+#define this_cpu_write(field, val) do {                                     \
+    PERCPU_TYPE(field) __val = (val);                                       \
+    __asm__ volatile("mov %0, %%gs:%c1"                                     \
+                     : : "r"(__val), "i"(PERCPU_OFFSET(field)) : "memory"); \
+} while (0)
+
+// 本CPU字段加val（单条add指令）
+#define this_cpu_add(field, val) do {                                       \
+    PERCPU_TYPE(field) __val = (val);                                       \
+    __asm__ volatile("add %0, %%gs:%c1"                                     \
+                     : : "r"(__val), "i"(PERCPU_OFFSET(field)) : "memory"); \
+} while (0)
+
+// 本CPU字段按位或val（单条or指令）
+#define this_cpu_or(field, val) do {                                        \
+    PERCPU_TYPE(field) __val = (val);                                       \
+    __asm__ volatile("or %0, %%gs:%c1"                                      \
+                     : : "r"(__val), "i"(PERCPU_OFFSET(field)) : "memory"); \
+} while (0)
+
+// 本CPU字段加1/减1（单条inc/dec指令）
+#define this_cpu_inc(field)                                                 \
+    __percpu_suffix_op(sizeof(PERCPU_TYPE(field)),                          \
+                       "incb %%gs:%c0", "incw %%gs:%c0",                    \
+                       "incl %%gs:%c0", "incq %%gs:%c0",                    \
+                       : : "i"(PERCPU_OFFSET(field)) : "memory")
+
+#define this_cpu_dec(field)                                                 \
+    __percpu_suffix_op(sizeof(PERCPU_TYPE(field)),                          \
+                       "decb %%gs:%c0", "decw %%gs:%c0",                    \
+                       "decl %%gs:%c0", "decq %%gs:%c0",                    \
+                       : : "i"(PERCPU_OFFSET(field)) : "memory")
+
+// 数组字段按下标访问（偏移+下标*元素大小寻址）
+#define this_cpu_read_idx(array, idx) ({                                    \
+    PERCPU_TYPE(array[0]) __ret;                                            \
+    __asm__ volatile("mov %%gs:%c1(,%2,%c3), %0"                            \
+                     : "=r"(__ret)                                          \
+                     : "i"(PERCPU_OFFSET(array)), "r"((uint64_t)(idx)),     \
+                       "i"(sizeof(PERCPU_TYPE(array[0]))));                 \
+    __ret;                                                                  \
+})
+
+#define this_cpu_write_idx(array, idx, val) do {                            \
+    PERCPU_TYPE(array[0]) __val = (val);                                    \
+    __asm__ volatile("mov %0, %%gs:%c1(,%2,%c3)"                            \
+                     : : "r"(__val), "i"(PERCPU_OFFSET(array)),             \
+                         "r"((uint64_t)(idx)),                              \
+                         "i"(sizeof(PERCPU_TYPE(array[0]))) : "memory");    \
+} while (0)
+
+#define this_cpu_inc_idx(array, idx)                                        \
+    __percpu_suffix_op(sizeof(PERCPU_TYPE(array[0])),                       \
+                       "incb %%gs:%c0(,%1,%c2)", "incw %%gs:%c0(,%1,%c2)",  \
+                       "incl %%gs:%c0(,%1,%c2)", "incq %%gs:%c0(,%1,%c2)",  \
+                       : : "i"(PERCPU_OFFSET(array)), "r"((uint64_t)(idx)), \
+                           "i"(sizeof(PERCPU_TYPE(array[0]))) : "memory")
+
+// 本CPU每CPU数据的普通指针（用于取地址或批量访问）
+static inline percpu_t* this_cpu_ptr(void) {
+    return this_cpu_read(self);
+}
+
+static inline uint32_t smp_processor_id(void) {
+    return this_cpu_read(cpu);
+}
+
+// 是否在irq_handler中（包括其中开中断执行的处理程序）
+static inline bool in_irq(void) {
+    return this_cpu_read(irq_depth) != 0;
+}
+
+// 是否在执行软中断（do_softirq在irq_depth回到0后运行，in_irq为false）
+static inline bool in_softirq(void) {
+    return this_cpu_read(softirq_active) != 0;
+}
+
+// 硬中断或软中断上下文，不能睡眠
+static inline bool in_interrupt(void) {
+    return in_irq() || in_softirq();
+}
+
+// 为cpu准备每CPU页（BSP使用静态页，AP从物理页分配器分配），返回0成功
+int percpu_alloc(uint32_t cpu, uint32_t apic_id);
+
+// 把本CPU的GS基址指向cpu的每CPU页（加载段寄存器会清零GS基址，之后需重新调用）
+void percpu_load(uint32_t cpu);
+
+// 访问其他CPU的每CPU页（统计汇总用），未分配时返回NULL
+percpu_t* percpu_area(uint32_t cpu);
+
+#endif // PERCPU_H
@@ -0,0 +1,35 @@
+// Boruix OS 多处理器启动
+// 通过Limine SMP请求唤醒应用处理器（AP），每个AP使用自己的GDT/TSS和内核栈，
+// 加载共享的IDT并启用本地APIC后进入空闲循环
+
+#ifndef SMP_H
+#define SMP_H
+
+#include "kernel/types.h"
+#include "kernel/limine.h"
+
+// 支持的CPU数量上限（逻辑编号0为BSP）
+#define SMP_MAX_CPUS            64
+
+// 等待单个AP上线的时间
+#define SMP_AP_TIMEOUT_MS       100
+
+typedef struct {
+    uint32_t cpu;               // 逻辑编号
+    uint32_t apic_id;           // Local APIC ID
+    uint32_t acpi_id;           // ACPI处理器UID
+    uint64_t stack_top;         // AP内核栈栈顶（BSP为0）
+    volatile bool online;       // 已完成初始化
+} smp_cpu_t;
+
+// 唤醒所有AP并等待其上线（在interrupt_init之后调用），response为NULL时只有BSP
+void smp_init(struct limine_smp_response* response);
+
+// 已发现的CPU数和已上线的CPU数
+uint32_t smp_cpu_count(void);
+uint32_t smp_online_count(void);
+
+// 按逻辑编号查询CPU信息，不存在返回NULL
+const smp_cpu_t* smp_get_cpu(uint32_t cpu);
+
+#endif // SMP_H
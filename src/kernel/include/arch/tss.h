@@ -3,14 +3,35 @@
 
 #include "kernel/types.h"
 
-// TSS初始化
+// IST编号（IDT门的ist字段，1-7）
+#define IST_DOUBLE_FAULT    1
+#define IST_NMI             2
+#define IST_MACHINE_CHECK   3
+#define IST_DEBUG           4
+#define IST_COUNT           4
+
+// 中断栈页数（保护页另计）
+#define IRQ_STACK_PAGES     4
+
+// 中断栈栈顶和嵌套深度保存在每CPU页中（percpu_t），isr.asm在最外层IRQ进入时切换到该栈
+
+// TSS初始化（同时分配IST栈和BSP的中断栈）
 void tss_init(void);
 
+// 为AP准备TSS并分配IST栈和中断栈（需先percpu_alloc），返回0成功，-1表示栈分配失败
+int tss_init_cpu(uint32_t cpu);
+
 // 获取TSS基址（用于调试）
 uint64_t tss_get_base(void);
 
+// 获取指定CPU的TSS基址（GDT描述符使用）
+uint64_t tss_get_base_cpu(uint32_t cpu);
+
 // 获取双重错误栈地址（用于调试）
 uint64_t tss_get_double_fault_stack(void);
 
+// 获取IST栈顶（ist为1-7），未设置返回0
+uint64_t tss_get_ist_stack(uint8_t ist);
+
 #endif // TSS_H
 
@@ -23,6 +23,14 @@
 #define CMOS_DAY 0x07
 #define CMOS_MONTH 0x08
 #define CMOS_YEAR 0x09
+#define CMOS_STATUS_A 0x0A
+#define CMOS_STATUS_B 0x0B
+#define CMOS_CENTURY 0x32       // ACPI FADT默认的世纪寄存器
+
+// 状态寄存器位
+#define CMOS_A_UIP 0x80         // 正在更新，寄存器内容不可靠
+#define CMOS_B_24H 0x02         // 24小时制（否则小时的bit7为PM）
+#define CMOS_B_BINARY 0x04      // 二进制格式（否则为BCD）
 
 // 中断向量定义
 #define IRQ0_TIMER 0x20
@@ -76,4 +84,44 @@ typedef struct {
     uint64_t no_execute : 1;
 } __attribute__((packed)) page_entry_t;
 
+// MSR定义
+#define MSR_IA32_APIC_BASE 0x1B
+#define MSR_IA32_TSC_DEADLINE 0x6E0
+
+// CPUID.01H特性位
+#define CPUID_FEAT_EDX_APIC (1 << 9)
+#define CPUID_FEAT_ECX_X2APIC (1 << 21)
+#define CPUID_FEAT_EDX_TSC (1 << 4)
+#define CPUID_FEAT_ECX_TSC_DEADLINE (1 << 24)
+
+// CPUID.80000007H：不变TSC（频率不随P/C状态变化）
+#define CPUID_APM_EDX_INVARIANT_TSC (1 << 8)
+
+// 读取MSR
+static inline uint64_t cpu_read_msr(uint32_t msr) {
+    uint32_t low, high;
+    __asm__ volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+// 写入MSR
+static inline void cpu_write_msr(uint32_t msr, uint64_t value) {
+    __asm__ volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// 读取时间戳计数器
+static inline uint64_t cpu_rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// 执行CPUID
+static inline void cpu_cpuid(uint32_t leaf, uint32_t subleaf,
+                             uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    __asm__ volatile("cpuid"
+                     : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                     : "a"(leaf), "c"(subleaf));
+}
+
 #endif // BORUIX_ARCH_X86_64_H
@@ -0,0 +1,59 @@
+// Boruix OS 时钟源
+// 把自由运行计数器换算成64位单调纳秒时间：ns = (cycles * mult) >> shift
+
+#ifndef BORUIX_CLOCKSOURCE_H
+#define BORUIX_CLOCKSOURCE_H
+
+#include "kernel/types.h"
+
+#define NSEC_PER_SEC  1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_USEC 1000ULL
+
+// 表示"永不到期"的单调时间
+#define KTIME_MAX 0xFFFFFFFFFFFFFFFFULL
+
+// 换算系数按该时长内不溢出选取，时间基准每秒推进一次
+#define CLOCKSOURCE_MAX_SECONDS 600
+
+typedef struct clocksource {
+    const char* name;
+    uint64_t (*read)(void);     // 读取计数器
+    uint64_t mask;              // 计数器有效位
+    uint64_t freq_hz;           // 计数频率
+    uint32_t mult;              // 周期->纳秒乘数（注册时计算）
+    uint32_t shift;             // 周期->纳秒移位
+    int rating;                 // 评级，越高越优先
+} clocksource_t;
+
+// 注册时钟源，评级高于当前时钟源时切换（时间保持连续），返回0成功
+int clocksource_register(clocksource_t* cs);
+
+// 当前时钟源
+const clocksource_t* clocksource_get_current(void);
+
+// 计算把from_hz换算到to_hz的mult/shift，max_seconds内的周期数相乘不溢出
+void clocks_calc_mult_shift(uint32_t* mult, uint32_t* shift, uint64_t from_hz, uint64_t to_hz,
+                            uint32_t max_seconds);
+
+// 周期数换算为纳秒
+static inline uint64_t clocksource_cyc2ns(const clocksource_t* cs, uint64_t cycles) {
+    return (cycles * cs->mult) >> cs->shift;
+}
+
+// 启动以来的单调纳秒时间
+uint64_t ktime_get_ns(void);
+
+// 墙上时间（Unix纳秒）= 单调时间 + 启动时由RTC设置的偏移，未设置时从1970年起算
+void timekeeping_set_real_ns(uint64_t unix_ns);
+uint64_t ktime_get_real_ns(void);
+
+// 时钟滴答时调用，每经过约1秒推进一次时间基准防止乘法溢出
+void clocksource_tick(void);
+
+// TSC：用PIT通道2校准频率并注册为时钟源，返回0成功
+int tsc_init(void);
+uint64_t tsc_get_freq_hz(void);
+bool tsc_is_invariant(void);
+
+#endif // BORUIX_CLOCKSOURCE_H
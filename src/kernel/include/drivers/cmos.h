@@ -1,14 +1,41 @@
 // Boruix OS CMOS时间模块头文件
-// 处理BIOS主板时间读取
+// 启动时读取一次主板RTC设置墙上时间，之后的时间查询由时钟源推算，不再访问端口
 
 #ifndef BORUIX_CMOS_H
 #define BORUIX_CMOS_H
 
 #include "kernel/types.h"
 
+// 日历时间（24小时制，四位年份）
+typedef struct {
+    uint16_t year;
+    uint8_t month;      // 1-12
+    uint8_t day;        // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+} rtc_time_t;
+
 // CMOS时间函数声明
 uint8_t read_cmos(uint8_t reg);
 uint8_t bcd_to_bin(uint8_t bcd);
+
+// rtc_read_time的错误码
+#define RTC_ERR_UIP       (-1)  // 更新标志(UIP)一直没有清零
+#define RTC_ERR_UNSTABLE  (-2)  // 多次连续两遍读取结果都不一致
+
+// 直接读取RTC（等待UIP清零并重复读取直到两次一致），返回0成功，失败返回RTC_ERR_*
+int rtc_read_time(rtc_time_t* tm);
+
+// 读取RTC并设置墙上时间（启动时调用一次，须在时钟源注册之后，
+// 否则墙上时间会锚定在注册前的jiffies时钟上）
+void rtc_init(void);
+
+// 日历时间与Unix秒互相换算
+uint64_t rtc_time_to_unix(const rtc_time_t* tm);
+void rtc_time_from_unix(uint64_t seconds, rtc_time_t* tm);
+
+// 当前墙上时间（由时钟源推算）
 void get_current_time(uint8_t* hour, uint8_t* minute, uint8_t* second);
 void get_current_date(uint8_t* day, uint8_t* month, uint8_t* year);
 void print_two_digits(uint8_t num);
@@ -0,0 +1,24 @@
+// Boruix OS 延迟与睡眠
+// ndelay/udelay/mdelay忙等TSC，适合短延迟和关中断上下文；
+// msleep挂一个高精度定时器后进入空闲循环，等待期间CPU可以休眠
+
+#ifndef BORUIX_DELAY_H
+#define BORUIX_DELAY_H
+
+#include "kernel/types.h"
+
+// 忙等至少ns纳秒（TSC频率未知时退化为端口0x80写入，每次约1微秒）
+void ndelay(uint64_t ns);
+
+static inline void udelay(uint64_t us) {
+    ndelay(us * 1000);
+}
+
+static inline void mdelay(uint64_t ms) {
+    ndelay(ms * 1000000);
+}
+
+// 睡眠至少ms毫秒；关中断或在硬中断/软中断上下文中调用时退化为mdelay
+void msleep(uint32_t ms);
+
+#endif // BORUIX_DELAY_H
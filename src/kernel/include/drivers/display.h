@@ -15,6 +15,9 @@ struct flanterm_context;
 // 初始化显示系统（由内核启动时调用）
 void display_init(struct limine_framebuffer *framebuffer);
 
+// 将帧缓冲重映射为写合并（需要内存管理器已初始化）
+int display_remap_framebuffer_wc(struct limine_framebuffer *framebuffer, uint64_t hhdm_offset);
+
 // === VGA兼容接口函数 ===
 
 // 屏幕清理
@@ -26,7 +29,6 @@ void set_cursor(int x, int y);
 // 字符输出
 void print_char(char c);
 void print_string(const char* str);
-void delay(int count);
 
 // 屏幕滚动相关函数
 void scroll_screen_up(void);
@@ -0,0 +1,57 @@
+// Boruix OS HPET（高精度事件定时器）驱动
+// 从ACPI HPET表发现，主计数器作为时钟源，各比较器作为一次性事件定时器
+
+#ifndef BORUIX_HPET_H
+#define BORUIX_HPET_H
+
+#include "kernel/types.h"
+
+// 最多管理的比较器数量（规范上限32）
+#define HPET_MAX_TIMERS 32
+
+// 比较器到期回调（中断上下文）
+typedef void (*hpet_event_handler_t)(uint32_t timer, void* ctx);
+
+// HPET信息（供诊断显示）
+typedef struct {
+    uint64_t phys;              // 寄存器块物理地址
+    uint64_t freq_hz;           // 主计数器频率
+    uint32_t period_fs;         // 计数周期（飞秒）
+    uint32_t timer_count;       // 比较器数量
+    uint16_t vendor_id;
+    bool     counter_64bit;     // 主计数器为64位
+    bool     legacy_capable;    // 支持传统替换路由
+} hpet_info_t;
+
+// 比较器信息
+typedef struct {
+    bool     in_use;
+    bool     periodic_capable;
+    bool     fsb_capable;       // 支持FSB（MSI）投递
+    bool     comparator_64bit;
+    uint32_t route_cap;         // 可路由的I/O APIC输入位图
+    uint32_t gsi;               // 使用I/O APIC时的GSI
+    uint8_t  vector;            // 投递向量（0表示未分配）
+    uint64_t fired;             // 到期次数
+} hpet_timer_info_t;
+
+// 解析ACPI表、映射寄存器（UC）、启动主计数器并注册时钟源，返回0成功，-1无HPET
+int hpet_init(void);
+
+bool hpet_is_available(void);
+uint64_t hpet_read_counter(void);
+uint64_t hpet_get_freq_hz(void);
+void hpet_get_info(hpet_info_t* info);
+bool hpet_get_timer_info(uint32_t timer, hpet_timer_info_t* info);
+
+// 申请一个空闲比较器用作一次性定时器（优先FSB投递，否则路由到空闲的I/O APIC输入）
+// 返回比较器编号，失败返回-1
+int hpet_comparator_request(hpet_event_handler_t handler, void* ctx);
+void hpet_comparator_free(uint32_t timer);
+
+// 在delta_ns纳秒后触发一次，返回0成功；写入后发现目标已过去时返回-1，调用者应立即处理
+// （此时比较器可能已经匹配，回调仍可能再到来一次，处理程序需容忍多余的事件）
+int hpet_comparator_arm(uint32_t timer, uint64_t delta_ns);
+void hpet_comparator_cancel(uint32_t timer);
+
+#endif // BORUIX_HPET_H
@@ -0,0 +1,71 @@
+// Boruix OS 高精度定时器
+// 每CPU一棵按到期时刻（单调纳秒）排序的红黑树，设备编程为最早的到期时刻：
+// 有LAPIC时钟事件设备时与滴答共用（TSC-deadline/单次计数），否则使用HPET比较器，
+// 都没有时退化为滴答精度
+
+#ifndef BORUIX_HRTIMER_H
+#define BORUIX_HRTIMER_H
+
+#include "kernel/types.h"
+#include "kernel/rbtree.h"
+
+// 支持的CPU数（SMP启动前只使用BSP的队列）
+#define HRTIMER_MAX_CPUS 64
+
+typedef enum {
+    HRTIMER_NORESTART = 0,      // 到期后不再挂入
+    HRTIMER_RESTART = 1         // 回调已推进expires，重新挂入
+} hrtimer_restart_t;
+
+typedef enum {
+    HRTIMER_MODE_ABS = 0,       // 绝对单调时间
+    HRTIMER_MODE_REL = 1        // 相对当前时间
+} hrtimer_mode_t;
+
+#define HRTIMER_STATE_INACTIVE  0x00
+#define HRTIMER_STATE_ENQUEUED  0x01
+
+typedef struct hrtimer {
+    rb_node_t node;
+    uint64_t expires;                                   // 到期时刻（ktime纳秒）
+    hrtimer_restart_t (*function)(struct hrtimer* timer);
+    uint32_t state;
+    uint32_t cpu;                                       // 所在CPU队列
+} hrtimer_t;
+
+// 统计信息
+typedef struct {
+    uint32_t active;            // 队列中的定时器数
+    uint64_t fired;             // 已执行的回调数
+    uint64_t interrupts;        // 处理到期定时器的次数
+    const char* device;         // 当前使用的事件设备
+} hrtimer_stats_t;
+
+// 选择事件设备（在lapic_timer_init之后调用）
+void hrtimers_init(void);
+
+// 初始化定时器，回调在硬中断上下文（关中断）执行，必须简短
+void hrtimer_init(hrtimer_t* timer, hrtimer_restart_t (*function)(hrtimer_t* timer));
+
+// 启动或重新启动定时器
+void hrtimer_start(hrtimer_t* timer, uint64_t time, hrtimer_mode_t mode);
+
+// 取消定时器，返回1表示取消了一个挂起的定时器，0表示未挂入
+int hrtimer_cancel(hrtimer_t* timer);
+
+static inline bool hrtimer_active(const hrtimer_t* timer) {
+    return (timer->state & HRTIMER_STATE_ENQUEUED) != 0;
+}
+
+// 周期定时器：把expires按interval推进到now之后，返回推进的周期数（>1表示有超期）
+uint64_t hrtimer_forward(hrtimer_t* timer, uint64_t now, uint64_t interval);
+
+// 当前CPU最早的到期时刻，队列为空时返回KTIME_MAX
+uint64_t hrtimer_next_expiry(void);
+
+// 执行当前CPU所有到期的定时器（事件设备中断中关中断调用）
+void hrtimer_interrupt(void);
+
+void hrtimer_get_stats(hrtimer_stats_t* stats);
+
+#endif // BORUIX_HRTIMER_H
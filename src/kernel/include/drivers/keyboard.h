@@ -20,7 +20,7 @@
 // 通用组合键系统配置
 #define MAX_COMBO_LEVELS 10        // 最大组合键层级
 #define MAX_COMBO_SEQUENCE 32      // 最大组合键序列长度
-#define COMBO_TIMEOUT_MS 1000      // 组合键超时时间（毫秒）
+#define COMBO_TIMEOUT_MS 1000      // 组合键超时时间（毫秒），超时后序列由内核定时器清空
 
 // 组合键事件类型
 typedef enum {
@@ -35,7 +35,7 @@ typedef struct {
     combo_event_type_t type;
     uint8_t scancode;
     uint8_t ascii;
-    uint32_t timestamp;  // 简单计数器作为时间戳
+    uint32_t timestamp;  // 事件发生时的系统滴答
 } combo_event_t;
 
 // 组合键状态
@@ -106,6 +106,7 @@ void keyboard_init(void);
 void keyboard_reset(void);  // 重置键盘（恢复功能）
 void keyboard_interrupt_handler(void);
 void keyboard_irq_handler(void);  // 键盘中断处理程序
+uint64_t keyboard_get_dropped_count(void);  // 扫描码队列溢出次数
 uint8_t keyboard_read_scancode(void);
 uint8_t keyboard_scancode_to_ascii(uint8_t scancode);
 uint8_t keyboard_get_char(void);
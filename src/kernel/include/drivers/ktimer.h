@@ -0,0 +1,69 @@
+// Boruix OS 内核定时器
+// 分层时间轮（256 + 4×64槽），按滴答计时；插入和取消都是O(1)，
+// 到期回调在TIMER软中断中开中断执行
+
+#ifndef BORUIX_KTIMER_H
+#define BORUIX_KTIMER_H
+
+#include "kernel/types.h"
+#include "drivers/timer.h"
+
+// 时间轮各级的槽位数
+#define KTIMER_TVR_BITS 8
+#define KTIMER_TVN_BITS 6
+#define KTIMER_TVR_SIZE (1 << KTIMER_TVR_BITS)
+#define KTIMER_TVN_SIZE (1 << KTIMER_TVN_BITS)
+
+typedef struct ktimer {
+    struct ktimer* next;
+    struct ktimer** pprev;          // 指向前一节点的next（或槽位头），NULL表示未挂入时间轮
+    uint32_t expires;               // 到期滴答（system_ticks）
+    void (*func)(uintptr_t data);
+    uintptr_t data;
+} ktimer_t;
+
+// 统计信息
+typedef struct {
+    uint32_t pending;               // 挂入时间轮的定时器数
+    uint64_t fired;                 // 已执行的回调数
+    uint64_t cascades;              // 高层槽位下放次数
+} ktimer_stats_t;
+
+// 滴答比较（处理回绕）
+#define time_after(a, b)     ((int32_t)((b) - (a)) < 0)
+#define time_after_eq(a, b)  ((int32_t)((a) - (b)) >= 0)
+
+// 毫秒换算为滴答（向上取整，至少1个滴答）
+static inline uint32_t msecs_to_ticks(uint32_t ms) {
+    uint32_t ticks = (uint32_t)(((uint64_t)ms * TIMER_FREQ_HZ + 999) / 1000);
+    return ticks ? ticks : 1;
+}
+
+// 初始化时间轮并注册TIMER软中断（在softirq_init之后调用）
+void ktimer_init(void);
+
+// 初始化定时器结构
+void timer_setup(ktimer_t* timer, void (*func)(uintptr_t data), uintptr_t data);
+
+// 在expires滴答时执行，定时器已挂入时返回-1
+int timer_add(ktimer_t* timer, uint32_t expires);
+
+// 修改到期时间（未挂入则挂入），返回1表示原来已挂入，0表示原来未挂入
+int timer_mod(ktimer_t* timer, uint32_t expires);
+
+// 取消定时器，返回1表示取消了一个挂起的定时器，0表示未挂入
+int timer_cancel(ktimer_t* timer);
+
+static inline bool timer_pending(const ktimer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+// 时钟滴答（由timer_do_ticks调用），有到期的定时器时登记TIMER软中断
+void ktimer_tick(void);
+
+// 最早到期的定时器对应的单调纳秒时间，没有定时器时返回KTIME_MAX（NO_HZ空闲使用）
+uint64_t ktimer_next_expiry_ns(void);
+
+void ktimer_get_stats(ktimer_stats_t* stats);
+
+#endif // BORUIX_KTIMER_H
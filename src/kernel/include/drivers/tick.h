@@ -0,0 +1,67 @@
+// Boruix OS 时钟事件设备与NO_HZ空闲
+// 一次性时钟事件设备按单调时钟逐个编程滴答；空闲时停掉滴答，直接睡到下一个事件
+
+#ifndef BORUIX_TICK_H
+#define BORUIX_TICK_H
+
+#include "kernel/types.h"
+#include "drivers/clocksource.h"
+#include "drivers/timer.h"
+
+// 滴答周期
+#define TICK_NSEC (NSEC_PER_SEC / TIMER_FREQ_HZ)
+
+// 空闲时最长睡眠，保证时钟源基准定期推进
+#define NOHZ_MAX_IDLE_NS NSEC_PER_SEC
+
+// 时钟事件设备能力
+#define CLOCK_EVT_FEAT_ONESHOT   0x01
+#define CLOCK_EVT_FEAT_DEADLINE  0x02   // 以TSC绝对时刻编程（TSC-deadline）
+
+typedef struct clock_event_device {
+    const char* name;
+    uint32_t features;
+    uint64_t min_delta_ns;                      // 最小可编程间隔
+    uint64_t max_delta_ns;                      // 最大可编程间隔
+    int rating;
+    int (*set_next_event)(uint64_t delta_ns);   // delta_ns后触发一次，返回0成功
+    void (*shutdown)(void);
+} clock_event_device_t;
+
+// 时钟事件统计
+typedef struct {
+    uint64_t events;            // 设备中断次数
+    uint64_t idle_entries;      // 进入空闲次数
+    uint64_t nohz_entries;      // 空闲时停掉滴答的次数
+    uint64_t ticks_skipped;     // 被省掉的滴答中断
+    uint64_t idle_ns;           // 停掉滴答期间的总时间
+} tick_stats_t;
+
+// 注册一次性时钟事件设备并接管周期滴答（停用PIT），返回0成功
+int clockevents_register(clock_event_device_t* dev);
+
+// 设备中断处理（关中断调用）
+void tick_handle_event(void);
+
+// 重新编程当前事件（设备状态被复位后调用）
+void tick_resume(void);
+
+// 最早的高精度定时器变化时调用（关中断），设备按新的最早到期时刻重新编程
+void tick_hrtimer_update(void);
+
+// 当前滴答设备，使用PIT周期滴答时返回NULL
+const clock_event_device_t* tick_get_device(void);
+void tick_get_stats(tick_stats_t* stats);
+
+// 定时器队列提供下一个到期时刻（单调纳秒），没有待处理定时器时返回KTIME_MAX
+typedef uint64_t (*tick_next_event_fn)(void);
+void tick_set_next_event_hook(tick_next_event_fn fn);
+
+// NO_HZ空闲：进入时按下一个到期时刻停掉滴答，退出时补记时间并恢复滴答（均关中断调用）
+void tick_nohz_idle_enter(void);
+void tick_nohz_idle_exit(void);
+
+// 空闲循环主体：没有待处理工作时睡眠到下一个事件或中断（开中断调用）
+void cpu_idle(void);
+
+#endif // BORUIX_TICK_H
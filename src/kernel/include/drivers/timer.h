@@ -20,4 +20,10 @@ uint32_t timer_get_seconds(void);
 // 定时器中断处理
 void timer_irq_handler(void);
 
+// 推进ticks个滴答的时间记账（单调时钟驱动滴答、NO_HZ空闲后补记时调用）
+void timer_do_ticks(uint32_t ticks);
+
+// 停止PIT通道0的周期中断（LAPIC定时器接管滴答后调用）
+void timer_pit_stop(void);
+
 #endif // BORUIX_TIMER_H
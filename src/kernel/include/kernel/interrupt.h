@@ -9,6 +9,32 @@
 // 中断向量定义
 #define IRQ_BASE 32  // IRQ基址（重映射后）
 
+// 动态分配的向量范围（32-47留给传统ISA IRQ，0xA0以上留给按优先级路由的ISA IRQ和系统向量）
+#define IRQ_VECTOR_DYNAMIC_START 48
+#define IRQ_VECTOR_DYNAMIC_END   159
+
+// APIC模式下ISA IRQ按优先级路由到不同的优先级类（向量高4位），TPR据此实现嵌套：
+// Low -> 0xA0, Normal -> 0xB0, High -> 0xC0, Critical -> 0xD0，低4位为IRQ号
+#define IRQ_PRIO_VECTOR_BASE 0xA0
+#define IRQ_PRIO_VECTOR_END  0xE0
+#define IRQ_PRIO_VECTOR(priority, irq) \
+    ((uint8_t)(IRQ_PRIO_VECTOR_BASE + ((IRQ_PRIORITY_LOW - (priority)) << 4) + (irq)))
+
+// request_irq标志
+#define IRQF_SHARED 0x01  // 允许与其他处理程序共享向量
+
+// 中断处理程序返回值
+typedef enum {
+    IRQ_NONE = 0,     // 不是本设备的中断
+    IRQ_HANDLED = 1   // 已处理
+} irq_return_t;
+
+// 中断处理程序：vector为触发的向量，ctx为注册时传入的上下文
+typedef irq_return_t (*irq_handler_t)(uint8_t vector, void* ctx);
+
+// 精简入口处理程序：关中断运行、不嵌套，vector为硬件向量，返回后由框架发送EOI
+typedef void (*irq_fast_handler_t)(uint8_t vector);
+
 // 中断启用/禁用函数
 static inline void interrupts_enable(void) {
     __asm__ volatile("sti");
@@ -29,9 +55,107 @@ static inline bool interrupts_enabled(void) {
     return (flags & 0x200) != 0;
 }
 
+// 保存RFLAGS并关中断；irq_restore按保存的IF位恢复，可以嵌套使用
+static inline uint64_t irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint64_t flags) {
+    if (flags & 0x200) {
+        __asm__ volatile("sti" : : : "memory");
+    }
+}
+
 // 中断初始化函数（由架构特定代码实现）
 void interrupt_init(void);
 
+// 中断控制器抽象（APIC可用时使用I/O APIC + Local APIC，否则使用8259 PIC）
+void irq_send_eoi(uint8_t irq);
+void irq_mask_line(uint8_t irq);
+void irq_unmask_line(uint8_t irq);
+const char* irq_controller_name(void);
+
+// 按向量屏蔽/解除屏蔽中断源：ISA线路、GSI路由的向量和MSI-X表项，无法屏蔽时返回-1
+int irq_mask_vector(uint8_t vector, bool masked);
+
+// 提高当前优先级，同级和更低级的中断留在控制器中（APIC用TPR，PIC用屏蔽寄存器）
+// 返回之前的状态，交给irq_restore_priority恢复；恢复后被推迟的中断由硬件重新投递
+uint32_t irq_raise_priority(uint8_t vector, uint8_t irq);
+void irq_restore_priority(uint32_t saved);
+
+// 按优先级重新路由ISA IRQ（APIC模式下改写重定向向量）
+void irq_route_priority(uint8_t irq, uint8_t priority);
+
+// 控制器中已到达但尚未投递的ISA IRQ位图
+uint16_t irq_pending_lines(void);
+
+// ISA IRQ当前路由到的硬件向量
+uint8_t irq_line_vector(uint8_t irq);
+
+// 硬件向量对应的ISA IRQ号，不是ISA IRQ返回0xFF
+static inline uint8_t irq_vector_to_line(uint8_t vector) {
+    if (vector >= IRQ_BASE && vector < IRQ_BASE + 16) {
+        return vector - IRQ_BASE;
+    }
+    if (vector >= IRQ_PRIO_VECTOR_BASE && vector < IRQ_PRIO_VECTOR_END) {
+        return vector & 0x0F;
+    }
+    return 0xFF;
+}
+
+// 中断处理程序注册（同一向量的处理程序串成链，共享时必须都带IRQF_SHARED）
+// 返回0成功，-1失败
+int request_irq(uint8_t vector, irq_handler_t handler, void* ctx, uint32_t flags);
+int free_irq(uint8_t vector, irq_handler_t handler, void* ctx);
+
+// 精简入口（定时器、IPI、MSI等高频向量）：只保存调用者保存寄存器，直接调用处理程序，
+// 不经过优先级和处理程序链（延迟仍计入直方图）；向量必须独占。返回0成功，-1失败
+int request_irq_fast(uint8_t vector, irq_fast_handler_t handler);
+int free_irq_fast(uint8_t vector);
+
+// ISA IRQ改路由到新向量时迁移精简入口
+void irq_fast_reroute(uint8_t old_vector, uint8_t new_vector);
+
+// 精简入口的退出处理（由isr.asm调用）：计数、延迟统计、EOI、最外层时执行软中断
+// entered为存根入口处读取的TSC
+void irq_fast_exit(uint64_t vector, uint64_t entered);
+
+// 动态向量分配（IRQ_VECTOR_DYNAMIC_START..END），失败返回-1
+int irq_alloc_vector(void);
+void irq_free_vector(uint8_t vector);
+
+// 分配count个连续向量，起始向量按align（2的幂）对齐，返回起始向量或-1
+int irq_alloc_vectors(uint32_t count, uint32_t align);
+
+// 调用向量上注册的处理程序（由irq_handler调用），返回是否有处理程序认领
+irq_return_t irq_dispatch(uint8_t vector);
+
+// 轮询调用向量上的处理程序（中断风暴轮询），无人认领时不计入未处理次数
+irq_return_t irq_poll_vector(uint8_t vector);
+
+// 中断风暴检测：窗口内同一向量的中断数超过阈值时屏蔽中断源（irq_mask_vector），
+// 改由每滴答一次的内核定时器轮询其处理程序，连续若干次轮询无事可做后恢复中断模式。
+// ISA线路按逻辑向量IRQ_BASE+irq统计；无法屏蔽的向量只计数不切换到轮询
+#define IRQ_STORM_WINDOW_TICKS  10      // 检测窗口（时钟滴答）
+#define IRQ_STORM_THRESHOLD     5000    // 窗口内允许的最大中断数
+#define IRQ_STORM_QUIET_POLLS   10      // 恢复中断前需要的连续空轮询次数
+#define IRQ_STORM_MAX_BACKOFF   64      // 反复风暴时空轮询要求的最大倍数
+
+// 记录逻辑向量上的一次中断（irq_handler关中断调用），触发风暴并屏蔽中断源时返回true
+bool irq_storm_account(uint8_t vector);
+
+// 风暴统计（按逻辑向量）
+bool irq_storm_is_polling(uint8_t vector);
+uint32_t irq_storm_get_count(uint8_t vector);
+uint32_t irq_storm_get_recoveries(uint8_t vector);
+uint64_t irq_storm_get_polls(uint8_t vector);
+
+// 统计信息
+uint32_t irq_get_action_count(uint8_t vector);
+uint64_t irq_get_unhandled_count(uint8_t vector);
+
 // 中断优先级管理函数
 void irq_priority_init(void);
 void irq_set_priority(uint8_t irq, uint8_t priority);
@@ -42,6 +166,8 @@ void irq_exit(void);
 uint8_t irq_get_current_level(void);
 uint32_t irq_get_nesting_count(void);
 uint64_t irq_get_blocked_count(uint8_t irq);
+void irq_defer_accounting_enable(int enable);   // 推迟统计需要在每次退出时读控制器，默认关闭
+int irq_defer_accounting_enabled(void);
 const char* irq_get_priority_name(uint8_t priority);
 void irq_disable(uint8_t irq);
 void irq_enable(uint8_t irq);
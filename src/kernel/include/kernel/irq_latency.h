@@ -0,0 +1,40 @@
+// Boruix OS 中断延迟统计
+// 按向量记录处理程序执行时间、按时钟中断记录到达间隔抖动（TSC周期，log2直方图）
+
+#ifndef BORUIX_IRQ_LATENCY_H
+#define BORUIX_IRQ_LATENCY_H
+
+#include "kernel/types.h"
+
+// 桶b统计[2^b, 2^(b+1))周期的样本，最后一个桶包含所有更大的值
+#define IRQ_HIST_BUCKETS 32
+
+typedef struct {
+    uint32_t buckets[IRQ_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+} irq_hist_t;
+
+// 记录一次处理程序执行时间（由irq_handler关中断调用）
+void irq_latency_record(uint8_t vector, uint64_t cycles);
+
+// 时钟中断到达，now为当前TSC，与上次到达的间隔偏离平均周期的量计入抖动直方图
+void irq_latency_tick(uint64_t now);
+
+// 滴答曾被停掉（NO_HZ空闲），下一次到达只作为新的间隔起点
+void irq_latency_resync(void);
+
+// 把一个样本计入直方图（调用者负责互斥）
+void irq_hist_add(irq_hist_t* hist, uint64_t value);
+
+// 读取直方图快照，向量没有样本时返回false
+bool irq_latency_get_duration(uint8_t vector, irq_hist_t* out);
+bool irq_latency_get_jitter(irq_hist_t* out, uint64_t* avg_period);
+
+// 百分位数（千分比，如500、990），返回所在桶的上界，不超过最大值
+uint64_t irq_hist_percentile(const irq_hist_t* hist, uint32_t permille);
+
+// 清空所有统计
+void irq_latency_reset(void);
+
+#endif // BORUIX_IRQ_LATENCY_H
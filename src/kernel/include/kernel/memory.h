@@ -50,6 +50,8 @@ typedef rust_memory_region_t memory_region_t;
 #define USER_VIRTUAL_END      0x00007FFFFFFFFFFFULL
 #define KERNEL_HEAP_START     0xFFFFFFFF90000000ULL
 #define KERNEL_HEAP_END       0xFFFFFFFFA0000000ULL
+#define KERNEL_MMIO_START     0xFFFFFFFFA0000000ULL
+#define KERNEL_MMIO_END       0xFFFFFFFFB0000000ULL
 
 // 内存管理函数（使用Rust内存管理器）
 static inline int memory_init_x86_64(uint64_t multiboot_info) {
@@ -0,0 +1,53 @@
+// Boruix OS 红黑树
+// 侵入式节点，调用者自行比较键值找到插入位置，再由rb_insert_color重新平衡；
+// cached版本额外维护最左节点，取最小值为O(1)
+
+#ifndef BORUIX_RBTREE_H
+#define BORUIX_RBTREE_H
+
+#include "kernel/types.h"
+
+#define RB_RED   0
+#define RB_BLACK 1
+
+typedef struct rb_node {
+    struct rb_node* parent;
+    struct rb_node* left;
+    struct rb_node* right;
+    int color;
+} rb_node_t;
+
+typedef struct {
+    rb_node_t* root;
+    rb_node_t* leftmost;
+} rb_root_cached_t;
+
+#define RB_ROOT_CACHED ((rb_root_cached_t){NULL, NULL})
+
+// 由节点指针取得包含它的结构
+#define rb_entry(ptr, type, member) \
+    ((type*)((char*)(ptr) - __builtin_offsetof(type, member)))
+
+// 把新节点挂到parent的link位置（link为&parent->left或&parent->right，空树时为&root->root）
+static inline void rb_link_node(rb_node_t* node, rb_node_t* parent, rb_node_t** link) {
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->color = RB_RED;
+    *link = node;
+}
+
+// 挂入后重新平衡，leftmost表示新节点是否在最左路径上
+void rb_insert_color_cached(rb_node_t* node, rb_root_cached_t* root, bool leftmost);
+
+// 删除节点
+void rb_erase_cached(rb_node_t* node, rb_root_cached_t* root);
+
+// 中序后继
+rb_node_t* rb_next(const rb_node_t* node);
+
+static inline rb_node_t* rb_first_cached(const rb_root_cached_t* root) {
+    return root->leftmost;
+}
+
+#endif // BORUIX_RBTREE_H
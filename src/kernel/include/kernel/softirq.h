@@ -0,0 +1,72 @@
+// Boruix OS 软中断与tasklet（中断下半部）
+// 硬中断只做最少的工作并登记软中断，在中断退出时开中断执行
+
+#ifndef BORUIX_SOFTIRQ_H
+#define BORUIX_SOFTIRQ_H
+
+#include "kernel/types.h"
+
+// 软中断号（数值越小越先执行）
+#define SOFTIRQ_HI       0  // 高优先级tasklet
+#define SOFTIRQ_TIMER    1  // 定时器
+#define SOFTIRQ_TASKLET  2  // 普通tasklet
+#define SOFTIRQ_COUNT    3
+
+// 一次中断退出最多重新扫描待处理位图的轮数，超出的留到下次中断退出
+#define SOFTIRQ_MAX_RESTART 10
+
+typedef void (*softirq_handler_t)(void);
+
+// tasklet：同一时刻只会在队列中出现一次，重复调度会被合并
+#define TASKLET_STATE_SCHED 0x01
+
+typedef struct tasklet {
+    struct tasklet* next;
+    void (*func)(uintptr_t data);
+    uintptr_t data;
+    volatile uint32_t state;
+} tasklet_t;
+
+// 关中断窗口/软中断执行时间统计（TSC周期）
+typedef struct {
+    uint64_t samples;
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+} irq_window_stats_t;
+
+// 初始化软中断子系统（在中断初始化时调用）
+void softirq_init(void);
+
+// 注册软中断处理程序
+void open_softirq(uint32_t nr, softirq_handler_t handler);
+
+// 标记软中断待处理，在下次中断退出或显式调用do_softirq时执行
+void raise_softirq(uint32_t nr);
+
+// 执行待处理的软中断（关中断调用，内部开中断执行处理程序，返回时仍关中断）
+void do_softirq(void);
+
+// 是否有待处理的软中断
+bool softirq_pending(void);
+
+// tasklet接口
+void tasklet_init(tasklet_t* t, void (*func)(uintptr_t data), uintptr_t data);
+void tasklet_schedule(tasklet_t* t);
+void tasklet_hi_schedule(tasklet_t* t);
+
+// 统计信息
+uint64_t softirq_get_count(uint32_t nr);
+uint64_t softirq_get_deferred_count(void);
+const char* softirq_get_name(uint32_t nr);
+
+// 硬中断关中断窗口：handler入口到开中断（或返回）之间的周期数
+void irq_account_off_window(uint64_t cycles);
+void irq_get_off_window_stats(irq_window_stats_t* hardirq);
+
+// 每次do_softirq的执行时间（处理程序开中断运行，不属于关中断窗口）
+void softirq_get_run_stats(irq_window_stats_t* run);
+
+// 清空关中断窗口与软中断执行时间统计
+void irq_reset_window_stats(void);
+
+#endif // BORUIX_SOFTIRQ_H
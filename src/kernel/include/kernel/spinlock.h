@@ -0,0 +1,106 @@
+// Boruix OS 锁原语
+// 自旋锁（test-and-test-and-set）、公平的票据锁和MCS队列锁，均可在C/Rust/Zig中使用；
+// _irqsave版本在获取前关中断，用于同时被中断处理程序访问的数据。
+// lockstat打开时记录每个锁的获取次数、争用次数、等待时间和持有时间（TSC周期）
+
+#ifndef BORUIX_SPINLOCK_H
+#define BORUIX_SPINLOCK_H
+
+#include "kernel/types.h"
+
+// 每个锁的统计记录（持有锁时更新，不需要额外同步）
+// 结构布局被Rust(lock.rs)和Zig(lock.zig)镜像，修改时同步更新
+typedef struct lockstat {
+    const char* name;               // 锁名（定义处的变量名）
+    struct lockstat* next;          // 已登记记录链表
+    volatile uint32_t registered;   // 已加入链表
+    uint32_t reserved;
+    uint64_t acquisitions;          // 获取次数
+    uint64_t contentions;           // 第一次尝试失败、需要等待的次数
+    uint64_t wait_cycles;           // 累计等待周期
+    uint64_t wait_max;              // 最长等待
+    uint64_t hold_cycles;           // 累计持有周期
+    uint64_t hold_max;              // 最长持有
+    uint64_t acquired_at;           // 本次获取时的TSC（持有期间有效）
+} lockstat_t;
+
+#define LOCKSTAT_INIT(lock_name) { (lock_name), NULL, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+
+// 自旋锁：适合临界区短、争用少的场合
+typedef struct {
+    volatile uint32_t locked;
+    uint32_t reserved;
+    lockstat_t* stat;               // 可为NULL（不统计）
+} spinlock_t;
+
+// 票据锁：按到达顺序获得锁，争用时不会饿死
+typedef struct {
+    volatile uint32_t next;         // 下一张票
+    volatile uint32_t owner;        // 正在服务的票
+    lockstat_t* stat;
+} ticket_lock_t;
+
+// MCS锁：每个等待者在自己的节点上自旋，争用激烈时不会在同一缓存行上来回传递
+typedef struct mcs_node {
+    struct mcs_node* volatile next;
+    volatile uint32_t locked;
+    uint32_t reserved;
+} mcs_node_t;
+
+typedef struct {
+    mcs_node_t* volatile tail;
+    lockstat_t* stat;
+} mcs_lock_t;
+
+#define SPINLOCK_INIT(stat_ptr)     { 0, 0, (stat_ptr) }
+#define TICKET_LOCK_INIT(stat_ptr)  { 0, 0, (stat_ptr) }
+#define MCS_LOCK_INIT(stat_ptr)     { NULL, (stat_ptr) }
+
+// 定义带统计记录的静态锁
+#define DEFINE_SPINLOCK(lock) \
+    static lockstat_t lock##_lockstat = LOCKSTAT_INIT(#lock); \
+    static spinlock_t lock = SPINLOCK_INIT(&lock##_lockstat)
+
+#define DEFINE_TICKET_LOCK(lock) \
+    static lockstat_t lock##_lockstat = LOCKSTAT_INIT(#lock); \
+    static ticket_lock_t lock = TICKET_LOCK_INIT(&lock##_lockstat)
+
+#define DEFINE_MCS_LOCK(lock) \
+    static lockstat_t lock##_lockstat = LOCKSTAT_INIT(#lock); \
+    static mcs_lock_t lock = MCS_LOCK_INIT(&lock##_lockstat)
+
+// 运行时初始化（stat可为NULL）
+void spin_lock_init(spinlock_t* lock, lockstat_t* stat);
+void ticket_lock_init(ticket_lock_t* lock, lockstat_t* stat);
+void mcs_lock_init(mcs_lock_t* lock, lockstat_t* stat);
+
+// 自旋锁
+void spin_lock(spinlock_t* lock);
+void spin_unlock(spinlock_t* lock);
+int spin_trylock(spinlock_t* lock);             // 返回1获得锁，0锁已被占用
+int spin_is_locked(spinlock_t* lock);
+uint64_t spin_lock_irqsave(spinlock_t* lock);   // 返回保存的RFLAGS
+void spin_unlock_irqrestore(spinlock_t* lock, uint64_t flags);
+
+// 票据锁
+void ticket_lock(ticket_lock_t* lock);
+void ticket_unlock(ticket_lock_t* lock);
+uint64_t ticket_lock_irqsave(ticket_lock_t* lock);
+void ticket_unlock_irqrestore(ticket_lock_t* lock, uint64_t flags);
+
+// MCS锁（node由调用者提供，通常在栈上，解锁前必须保持有效）
+void mcs_lock(mcs_lock_t* lock, mcs_node_t* node);
+void mcs_unlock(mcs_lock_t* lock, mcs_node_t* node);
+uint64_t mcs_lock_irqsave(mcs_lock_t* lock, mcs_node_t* node);
+void mcs_unlock_irqrestore(mcs_lock_t* lock, mcs_node_t* node, uint64_t flags);
+
+// lockstat：默认关闭，关闭时加解锁不读取TSC
+void lockstat_enable(int enable);
+int lockstat_is_enabled(void);
+void lockstat_reset(void);
+
+// 遍历已登记的统计记录（在lockstat打开后至少获取过一次的锁），返回NULL表示结束
+lockstat_t* lockstat_first(void);
+lockstat_t* lockstat_next(lockstat_t* stat);
+
+#endif // BORUIX_SPINLOCK_H
@@ -16,8 +16,8 @@ typedef signed int int32_t;
 typedef signed short int16_t;
 typedef signed char int8_t;
 
-// 布尔类型
-typedef enum { false = 0, true = 1 } bool;
+// 布尔类型：与stdbool.h（rust_memory.h、pci.h）及Rust/Zig的bool一致，都是单字节_Bool
+#include <stdbool.h>
 
 // NULL定义
 #ifndef NULL
@@ -78,6 +78,12 @@ typedef struct {
     rust_page_table_stats_t page_tables;
 } rust_memory_stats_t;
 
+// 分散/聚集段（物理连续）
+typedef struct {
+    uint64_t phys_addr;
+    uint64_t length;
+} rust_sg_entry_t;
+
 // 内存使用摘要
 typedef struct {
     uint64_t total_physical_mb;
@@ -116,6 +122,14 @@ typedef struct {
 #define RUST_PAGE_GLOBAL            0x100
 #define RUST_PAGE_NO_EXECUTE        0x8000000000000000ULL
 
+// 内核栈默认页数（16KB）
+#define RUST_KSTACK_DEFAULT_PAGES   4
+
+// MMIO映射缓存模式
+#define RUST_CACHE_WB               0   // 回写
+#define RUST_CACHE_WC               1   // 写合并（帧缓冲）
+#define RUST_CACHE_UC               2   // 不可缓存（设备寄存器）
+
 /**
  * 设置HHDM (Higher Half Direct Map) 偏移量
  * 必须在rust_memory_init之前调用
@@ -131,6 +145,26 @@ void rust_set_hhdm_offset(uint64_t offset);
  */
 uint64_t rust_get_hhdm_offset(void);
 
+/**
+ * 设置内核映像位置
+ * 内核映像和HHDM区域的地址转换直接计算，无需遍历页表
+ * 
+ * @param phys_base 内核映像物理基址
+ * @param virt_base 内核映像虚拟基址
+ * @param size 内核映像大小（字节）
+ */
+void rust_set_kernel_image(uint64_t phys_base, uint64_t virt_base, uint64_t size);
+
+/**
+ * 登记Limine在HHDM中实际映射的物理范围（按内存映射表顺序调用）
+ * 只有登记过的范围走快速转换，其余HHDM地址遍历页表，未映射时rust_virt_to_phys返回0
+ * 
+ * @param phys_base 物理基址
+ * @param length 长度（字节）
+ * @return 0成功，-1失败
+ */
+int rust_hhdm_add_range(uint64_t phys_base, uint64_t length);
+
 /**
  * 初始化Rust内存管理器
  * 
@@ -195,6 +229,85 @@ uint64_t rust_unmap_page(uint64_t virtual_addr);
  */
 uint64_t rust_virt_to_phys(uint64_t virtual_addr);
 
+/**
+ * 将虚拟地址范围转换为物理连续段列表（用于DMA）
+ * 物理上相邻的页面合并为同一段
+ * 
+ * @param virtual_addr 起始虚拟地址
+ * @param length 范围长度（字节）
+ * @param sg_out 输出段数组
+ * @param max_entries 段数组容量
+ * @return 段数表示成功，-1表示失败（存在未映射页面或段数组不足）
+ */
+int64_t rust_virt_range_to_sg(uint64_t virtual_addr, uint64_t length,
+                              rust_sg_entry_t* sg_out, size_t max_entries);
+
+/**
+ * 在应用处理器上设置与BSP一致的PAT和全局页
+ * 每个AP启动时调用一次
+ */
+void rust_cpu_init(void);
+
+/**
+ * 分配带保护页的内核栈
+ * 栈下方保留一个不映射的保护页，溢出时触发缺页而不是破坏相邻内存
+ * 释放的栈会被缓存，再次分配相同大小时直接复用
+ * 
+ * @param pages 栈页数（1-64）
+ * @return 栈顶地址（16字节对齐），0表示失败
+ */
+uint64_t rust_kstack_alloc(uint64_t pages);
+
+/**
+ * 释放内核栈
+ * 
+ * @param stack_top rust_kstack_alloc返回的栈顶地址
+ */
+void rust_kstack_free(uint64_t stack_top);
+
+/**
+ * 检查地址是否落在内核栈保护页中
+ * 
+ * @param addr 虚拟地址（通常为CR2）
+ * @return true表示是保护页（内核栈溢出）
+ */
+bool rust_kstack_is_guard_page(uint64_t addr);
+
+/**
+ * 获取内核栈统计信息
+ * 
+ * @param in_use 使用中的栈数量
+ * @param cached 缓存的空闲栈数量
+ * @param cache_hits 缓存命中次数
+ */
+void rust_kstack_stats(size_t* in_use, size_t* cached, size_t* cache_hits);
+
+/**
+ * 获取当前使用中的页表页面数
+ * 
+ * @return 内存管理器分配的PDPT/PD/PT页面数（不含PML4和引导程序建立的页表）
+ */
+size_t rust_page_table_pages(void);
+
+/**
+ * 将物理MMIO区域映射到内核MMIO窗口
+ * 
+ * @param phys_addr 物理地址（可不对齐，返回地址保留页内偏移）
+ * @param size 区域大小（字节）
+ * @param cache_mode 缓存模式（RUST_CACHE_WB/WC/UC）
+ * @return 虚拟地址表示成功，0表示失败
+ */
+uint64_t rust_vmm_map_mmio(uint64_t phys_addr, uint64_t size, uint32_t cache_mode);
+
+/**
+ * 取消rust_vmm_map_mmio建立的映射，并把地址段归还MMIO窗口
+ * 
+ * @param virt_addr rust_vmm_map_mmio返回的虚拟地址
+ * @param size 映射时的区域大小（字节）
+ * @return 0表示成功，-1表示失败
+ */
+int rust_vmm_unmap_mmio(uint64_t virt_addr, uint64_t size);
+
 /**
  * 获取内存统计信息
  * 
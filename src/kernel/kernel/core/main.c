@@ -3,6 +3,10 @@
 #include "kernel/kernel.h"
 #include "drivers/display.h"
 #include "drivers/cmos.h"
+#include "drivers/timer.h"
+#include "drivers/tick.h"
+#include "drivers/clocksource.h"
+#include "drivers/delay.h"
 #include "kernel/interrupt.h"
 #include "kernel/limine.h"
 #include "kernel/memory.h"
@@ -10,6 +14,11 @@
 #include "kernel/serial_debug.h"
 #include "arch/tss.h"
 #include "arch/gdt.h"
+#include "arch/smp.h"
+
+#ifdef ENABLE_TEST_COMMANDS
+#include "../shell/builtin/apicbench/apicbench.h"
+#endif
 
 // Limine requests
 __attribute__((used, section(".requests")))
@@ -27,6 +36,27 @@ static volatile struct limine_hhdm_request hhdm_request = {
     .revision = 0
 };
 
+__attribute__((used, section(".requests")))
+static volatile struct limine_kernel_address_request kernel_address_request = {
+    .id = LIMINE_KERNEL_ADDRESS_REQUEST,
+    .revision = 0
+};
+
+// 内存映射表（登记HHDM中实际映射的范围）
+__attribute__((used, section(".requests")))
+static volatile struct limine_memmap_request memmap_request = {
+    .id = LIMINE_MEMMAP_REQUEST,
+    .revision = 0
+};
+
+// 应用处理器（不要求x2APIC，由lapic_init_ap与BSP保持一致）
+__attribute__((used, section(".requests")))
+static volatile struct limine_smp_request smp_request = {
+    .id = LIMINE_SMP_REQUEST,
+    .revision = 0,
+    .flags = 0
+};
+
 __attribute__((used, section(".requests_start_marker")))
 static volatile LIMINE_REQUESTS_START_MARKER;
 
@@ -81,17 +111,6 @@ void kmain(void) {
     print_dec(fb->height);
     print_string("\n\n");
     
-    // 显示时间
-    print_string("Current time: ");
-    unsigned char hour, minute, second;
-    get_current_time(&hour, &minute, &second);
-    print_two_digits(hour);
-    print_char(':');
-    print_two_digits(minute);
-    print_char(':');
-    print_two_digits(second);
-    print_string("\n\n");
-    
     // 显示HHDM信息
     print_string("HHDM Offset: 0x");
     print_hex(hhdm_request.response->offset);
@@ -106,6 +125,27 @@ void kmain(void) {
     SERIAL_INFO("Setting HHDM offset...");
     rust_set_hhdm_offset(hhdm_request.response->offset);
     
+    // 各基础修订版本中HHDM都会映射的区域类型，其余地址（空洞、保留区、内存顶端之后）走页表
+    if (memmap_request.response != NULL) {
+        for (uint64_t i = 0; i < memmap_request.response->entry_count; i++) {
+            struct limine_memmap_entry* entry = memmap_request.response->entries[i];
+            if (entry->type == LIMINE_MEMMAP_USABLE ||
+                entry->type == LIMINE_MEMMAP_BOOTLOADER_RECLAIMABLE ||
+                entry->type == LIMINE_MEMMAP_KERNEL_AND_MODULES ||
+                entry->type == LIMINE_MEMMAP_FRAMEBUFFER) {
+                rust_hhdm_add_range(entry->base, entry->length);
+            }
+        }
+    }
+    
+    // 登记内核映像位置（内核映像区域的地址转换无需遍历页表）
+    if (kernel_address_request.response != NULL) {
+        extern char __kernel_end[];
+        uint64_t virt_base = kernel_address_request.response->virtual_base;
+        rust_set_kernel_image(kernel_address_request.response->physical_base,
+                              virt_base, (uint64_t)__kernel_end - virt_base);
+    }
+    
     SERIAL_INFO("Calling memory_init()...");
     int memory_result = memory_init(0);
     
@@ -121,6 +161,15 @@ void kmain(void) {
         SERIAL_ERROR("Failed to initialize Rust memory manager!");
     }
     
+    // 将帧缓冲重映射为写合并（PAT已在内存管理器初始化时设置）
+    if (memory_result == 0) {
+        if (display_remap_framebuffer_wc(fb, hhdm_request.response->offset) == 0) {
+            SERIAL_INFO("Framebuffer remapped as write-combining");
+        } else {
+            SERIAL_ERROR("Failed to remap framebuffer as write-combining");
+        }
+    }
+    
     // 初始化TSS（双重错误需要）
     print_string("Initializing TSS (Task State Segment)...\n");
     tss_init();
@@ -136,6 +185,30 @@ void kmain(void) {
     interrupt_init();
     print_string("Interrupt system ready!\n");
     
+    // 读取一次RTC设置墙上时间，之后的时间查询由时钟源推算
+    // 必须在interrupt_init注册时钟源之后，否则偏移锚定在切换前的时钟上
+    rtc_init();
+    
+    // 显示时间
+    print_string("Current time: ");
+    unsigned char hour, minute, second;
+    get_current_time(&hour, &minute, &second);
+    print_two_digits(hour);
+    print_char(':');
+    print_two_digits(minute);
+    print_char(':');
+    print_two_digits(second);
+    print_string("\n\n");
+    
+#ifdef ENABLE_TEST_COMMANDS
+    // AP上线后不能切换APIC模式，两种模式的对比在这里先测好
+    apicbench_boot();
+#endif
+    
+    // 唤醒应用处理器（需要APIC和内核栈分配）
+    print_string("Starting application processors...\n");
+    smp_init(smp_request.response);
+    
     print_string("========================================\n");
     print_string("SYSTEM READY\n");
     print_string("========================================\n\n");
@@ -155,30 +228,40 @@ void kmain(void) {
     print_string("Testing Timer interrupt only...\n");
     
     // 禁用键盘中断，只测试timer
-    extern void pic_set_mask(uint8_t irq);
-    pic_set_mask(1);  // 禁用IRQ1 (keyboard)
+    irq_mask_line(1);  // 禁用IRQ1 (keyboard)
     print_string("Keyboard IRQ disabled\n");
     
-    extern uint64_t get_interrupt_count(uint8_t int_no);
+    // 滴答可能来自LAPIC定时器而不是IRQ0，按jiffies和ktime判断时钟是否在走
+    uint32_t start_ticks = system_ticks;
+    uint64_t start_ns = ktime_get_ns();
     print_string("Initial timer ticks: ");
-    print_dec((uint32_t)get_interrupt_count(32));
+    print_dec(start_ticks);
     print_string("\n");
     
     // CS已确认为0x28，IDT已修复，现在测试Timer中断
     print_string("CS confirmed = 0x28, IDT selector fixed!\n");
     
-    print_string("Enabling Timer IRQ...\n");
-    extern void pic_clear_mask(uint8_t irq);
-    pic_clear_mask(0);  // Timer
+    // 滴答设备接管后PIT已停，再打开IRQ0只会让残留的中断多计一个jiffy
+    if (!tick_get_device()) {
+        print_string("Enabling Timer IRQ...\n");
+        irq_unmask_line(0);  // Timer
+    }
     
     __asm__ volatile("sti");
     print_string("Interrupts ENABLED!\n");
     
+    // 最多等待100ms让第一个滴答到达
+    for (int i = 0; i < 100 && system_ticks == start_ticks; i++) {
+        mdelay(1);
+    }
+    
     print_string("\n\nTimer ticks: ");
-    print_dec((uint32_t)get_interrupt_count(32));
-    print_string("\n");
+    print_dec(system_ticks - start_ticks);
+    print_string(" in ");
+    print_dec((uint32_t)((ktime_get_ns() - start_ns) / NSEC_PER_MSEC));
+    print_string(" ms\n");
     
-    if (get_interrupt_count(32) > 0) {
+    if (system_ticks != start_ticks && ktime_get_ns() > start_ns) {
         print_string("\nSUCCESS! Timer interrupt is WORKING!\n\n");
     } else {
         print_string("FAILED: Timer still not working\n");
@@ -186,7 +269,7 @@ void kmain(void) {
     
     // 启用键盘中断
     print_string("Enabling keyboard interrupt...\n");
-    pic_clear_mask(1);  // Keyboard
+    irq_unmask_line(1);  // Keyboard
     print_string("Keyboard IRQ enabled!\n");
     
     // 测试Rust内存管理系统
@@ -5,6 +5,7 @@
 #include "kernel/interrupt.h"
 #include "drivers/display.h"
 #include "drivers/keyboard.h"
+#include "drivers/tick.h"
 #include "../shell/utils/string.h"
 #include "../shell/utils/combo.h"
 #include "../shell/commands/command.h"
@@ -168,8 +169,8 @@ void shell_main(void) {
     shell_print_prompt();
     
     while (1) {
-        // 使用中断处理
-        __asm__ volatile("hlt");
+        // 空闲：没有待处理的定时器时停掉滴答，睡到下一个事件或中断
+        cpu_idle();
         
         // 确保中断处理完成后继续执行
         __asm__ volatile("" ::: "memory");
@@ -0,0 +1,136 @@
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "drivers/display.h"
+#include "arch/x86_64.h"
+#include "arch/apic.h"
+#include "apicbench.h"
+
+#define BENCH_ITERATIONS 10000
+
+// 一种模式下的测量结果
+typedef struct {
+    bool valid;
+    uint64_t eoi_cycles;
+    uint64_t tpr_cycles;
+} apic_bench_result_t;
+
+// 启动时（AP上线前）测得的两种模式结果，下标为是否x2APIC
+static apic_bench_result_t boot_results[2];
+
+// 测量当前模式下EOI和TPR访问的平均周期数（关中断执行，没有在服务的中断时EOI被忽略）
+static apic_bench_result_t bench_current_mode(void) {
+    apic_bench_result_t result;
+    uint64_t start;
+    uint8_t tpr = lapic_get_tpr();
+    
+    bool was_enabled = interrupts_enabled();
+    interrupts_disable();
+    
+    // 预热
+    for (int i = 0; i < 100; i++) {
+        lapic_send_eoi();
+    }
+    
+    start = cpu_rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        lapic_send_eoi();
+    }
+    result.eoi_cycles = (cpu_rdtsc() - start) / BENCH_ITERATIONS;
+    
+    start = cpu_rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        lapic_set_tpr(tpr);
+        (void)lapic_get_tpr();
+    }
+    result.tpr_cycles = (cpu_rdtsc() - start) / BENCH_ITERATIONS;
+    
+    if (was_enabled) {
+        interrupts_enable();
+    }
+    
+    result.valid = true;
+    return result;
+}
+
+static void print_mode_name(bool x2apic) {
+    print_string(x2apic ? "  x2APIC (MSR):  " : "  xAPIC (MMIO):  ");
+}
+
+static void print_result(bool x2apic, const apic_bench_result_t* result) {
+    print_mode_name(x2apic);
+    print_string("EOI ");
+    print_dec((uint32_t)result->eoi_cycles);
+    print_string(" cycles, TPR write+read ");
+    print_dec((uint32_t)result->tpr_cycles);
+    print_string(" cycles\n");
+}
+
+// 切换到另一种模式测量后恢复，AP上线后模式切换被禁止，只能在启动阶段调用
+static int bench_other_mode(bool original, apic_bench_result_t* result) {
+    if (lapic_set_mode(!original) != 0) {
+        return -1;
+    }
+    *result = bench_current_mode();
+    return lapic_set_mode(original) == 0 ? 0 : -2;
+}
+
+void apicbench_boot(void) {
+    if (!apic_is_enabled() || lapic_mode_switch_locked()) {
+        return;
+    }
+    
+    bool original = lapic_x2apic;
+    boot_results[original] = bench_current_mode();
+    if (bench_other_mode(original, &boot_results[!original]) == -2) {
+        print_string("[APICBENCH] Could not restore original APIC mode\n");
+    }
+}
+
+void cmd_apicbench(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    
+    print_string("[APICBENCH] Local APIC access microbenchmark\n");
+    
+    if (!apic_is_enabled()) {
+        print_string("[SKIP] APIC not enabled, running on PIC\n");
+        return;
+    }
+    
+    print_string("  Iterations: ");
+    print_dec(BENCH_ITERATIONS);
+    print_string("\n\n");
+    
+    bool original = lapic_x2apic;
+    
+    // 先测当前模式，再切换到另一种模式测量，最后恢复
+    apic_bench_result_t current = bench_current_mode();
+    print_result(original, &current);
+    
+    if (lapic_mode_switch_locked()) {
+        // 模式对所有CPU生效，AP上线后只能给出启动阶段的对比结果
+        if (boot_results[!original].valid) {
+            print_result(!original, &boot_results[!original]);
+            print_string("  (APs online, mode switch disabled; other mode measured at boot)\n");
+        } else {
+            print_mode_name(!original);
+            print_string("unavailable (APs online, mode switch disabled)\n");
+        }
+    } else {
+        apic_bench_result_t other;
+        int result = bench_other_mode(original, &other);
+        if (result == -2) {
+            print_string("[FAIL] Could not restore original APIC mode\n");
+            return;
+        }
+        if (result == 0) {
+            print_result(!original, &other);
+        } else {
+            print_string(original ? "  xAPIC (MMIO):  unavailable (x2APIC locked by firmware)\n"
+                                  : "  x2APIC (MSR):  not supported by CPU\n");
+        }
+    }
+    
+    print_string("\n[APICBENCH] Done, mode: ");
+    print_string(lapic_x2apic ? "x2APIC\n" : "xAPIC\n");
+}
@@ -0,0 +1,9 @@
+#ifndef _APICBENCH_H
+#define _APICBENCH_H
+
+void cmd_apicbench(int argc, char* argv[]);
+
+// 在AP上线前测量两种APIC模式，供AP上线后cmd_apicbench对比
+void apicbench_boot(void);
+
+#endif
@@ -14,6 +14,8 @@
 #include "test/test.h"
 #include "uptime/uptime.h"
 #include "irqstat/irqstat.h"
+#include "irqlat/irqlat.h"
+#include "lockstat/lockstat.h"
 #include "irqinfo/irqinfo.h"
 #include "irqprio/irqprio.h"
 #include "irqtest/irqtest.h"
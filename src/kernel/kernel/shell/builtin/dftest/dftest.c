@@ -4,6 +4,7 @@
 #include "dftest.h"
 #include "kernel/shell.h"
 #include "drivers/display.h"
+#include "drivers/delay.h"
 
 // 测试双重错误
 void cmd_dftest(int argc, char* argv[]) {
@@ -13,11 +14,11 @@ void cmd_dftest(int argc, char* argv[]) {
     print_string("This will trigger a double fault to test the handler.\n");
     print_string("The system should display detailed fault information.\n\n");
     print_string("Triggering double fault in 3...\n");
-    for(volatile int i = 0; i < 100000000; i++);
+    msleep(1000);
     print_string("2...\n");
-    for(volatile int i = 0; i < 100000000; i++);
+    msleep(1000);
     print_string("1...\n");
-    for(volatile int i = 0; i < 100000000; i++);
+    msleep(1000);
     print_string("\n");
     
     // 禁用中断
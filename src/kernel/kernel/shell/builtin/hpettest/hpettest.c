@@ -0,0 +1,159 @@
+// HPET测试
+// 检查主计数器频率与TSC是否一致，并测量一次性比较器的触发误差
+
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "drivers/display.h"
+#include "drivers/hpet.h"
+#include "drivers/clocksource.h"
+#include "arch/x86_64.h"
+#include "hpettest.h"
+
+#define HPETTEST_WAIT_LIMIT 100000000ULL
+
+static volatile uint32_t fired_count;
+static volatile uint64_t fired_ns;
+
+static void hpettest_handler(uint32_t timer, void* ctx) {
+    (void)timer;
+    (void)ctx;
+    fired_ns = ktime_get_ns();
+    fired_count++;
+}
+
+// 打印有符号的微秒差
+static void print_delta_us(uint64_t actual_ns, uint64_t expected_ns) {
+    if (actual_ns >= expected_ns) {
+        print_string("+");
+        print_dec((uint32_t)((actual_ns - expected_ns) / NSEC_PER_USEC));
+    } else {
+        print_string("-");
+        print_dec((uint32_t)((expected_ns - actual_ns) / NSEC_PER_USEC));
+    }
+    print_string(" us");
+}
+
+void cmd_hpettest(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    print_string("[HPETTEST] HPET clocksource and comparators\n");
+
+    if (!hpet_is_available()) {
+        print_string("[SKIP] No HPET\n");
+        return;
+    }
+
+    hpet_info_t info;
+    hpet_get_info(&info);
+    print_string("  Frequency: ");
+    print_dec((uint32_t)info.freq_hz);
+    print_string(" Hz  Comparators: ");
+    print_dec(info.timer_count);
+    print_string("  Vendor: 0x");
+    print_hex(info.vendor_id);
+    print_string("\n");
+
+    for (uint32_t n = 0; n < info.timer_count; n++) {
+        hpet_timer_info_t t;
+        if (!hpet_get_timer_info(n, &t)) {
+            continue;
+        }
+        print_string("  Timer ");
+        print_dec(n);
+        print_string(t.comparator_64bit ? ": 64-bit" : ": 32-bit");
+        print_string(t.periodic_capable ? ", periodic" : "");
+        print_string(t.fsb_capable ? ", FSB" : "");
+        print_string(", routes 0x");
+        print_hex(t.route_cap);
+        print_string("\n");
+    }
+
+    // 主计数器必须递增
+    uint64_t c0 = hpet_read_counter();
+    uint64_t t0 = cpu_rdtsc();
+    while (hpet_read_counter() - c0 < info.freq_hz / 100) {
+        __asm__ volatile("pause");
+    }
+    uint64_t c1 = hpet_read_counter();
+    uint64_t t1 = cpu_rdtsc();
+    if (c1 <= c0) {
+        print_string("[FAIL] Main counter not advancing\n");
+        return;
+    }
+    print_string("[PASS] Main counter advancing\n");
+
+    uint64_t tsc_hz = tsc_get_freq_hz();
+    if (tsc_hz) {
+        uint64_t measured = (t1 - t0) * info.freq_hz / (c1 - c0);
+        print_string("  TSC by HPET: ");
+        print_dec((uint32_t)(measured / 1000));
+        print_string(" kHz, calibrated: ");
+        print_dec((uint32_t)(tsc_hz / 1000));
+        print_string(" kHz\n");
+    }
+
+    int timer = hpet_comparator_request(hpettest_handler, NULL);
+    if (timer < 0) {
+        print_string("[SKIP] No routable comparator (needs I/O APIC or FSB)\n");
+        print_string("[HPETTEST] Done\n");
+        return;
+    }
+
+    hpet_timer_info_t tinfo;
+    hpet_get_timer_info((uint32_t)timer, &tinfo);
+    print_string("  Using timer ");
+    print_dec((uint32_t)timer);
+    print_string(", vector ");
+    print_dec(tinfo.vector);
+    if (tinfo.fsb_capable) {
+        print_string(" (FSB)\n");
+    } else {
+        print_string(" (GSI ");
+        print_dec(tinfo.gsi);
+        print_string(")\n");
+    }
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_enable();
+
+    static const uint32_t delays_us[] = {100, 1000, 10000};
+    bool ok = true;
+    for (uint32_t i = 0; i < sizeof(delays_us) / sizeof(delays_us[0]); i++) {
+        uint64_t delta = (uint64_t)delays_us[i] * NSEC_PER_USEC;
+        uint32_t before = fired_count;
+        uint64_t start = ktime_get_ns();
+        if (hpet_comparator_arm((uint32_t)timer, delta) != 0) {
+            print_string("[FAIL] Comparator target already passed\n");
+            ok = false;
+            continue;
+        }
+
+        uint64_t spins = 0;
+        while (fired_count == before && ++spins < HPETTEST_WAIT_LIMIT) {
+            __asm__ volatile("pause");
+        }
+        if (fired_count == before) {
+            print_string("[FAIL] One-shot ");
+            print_dec(delays_us[i]);
+            print_string(" us did not fire\n");
+            hpet_comparator_cancel((uint32_t)timer);
+            ok = false;
+            continue;
+        }
+
+        print_string("  One-shot ");
+        print_dec(delays_us[i]);
+        print_string(" us: error ");
+        print_delta_us(fired_ns, start + delta);
+        print_string("\n");
+    }
+
+    if (!was_enabled) {
+        interrupts_disable();
+    }
+    hpet_comparator_free((uint32_t)timer);
+
+    print_string(ok ? "[PASS] One-shot comparator\n" : "[FAIL] One-shot comparator\n");
+    print_string("[HPETTEST] Done\n");
+}
@@ -0,0 +1,6 @@
+#ifndef _HPETTEST_H
+#define _HPETTEST_H
+
+void cmd_hpettest(int argc, char* argv[]);
+
+#endif
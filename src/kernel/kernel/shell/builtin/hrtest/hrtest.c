@@ -0,0 +1,197 @@
+// 高精度定时器测试
+// 对多个相对延迟反复启动单次hrtimer，统计回调时刻相对到期时刻的唤醒误差分布，
+// 再用一个周期定时器检查hrtimer_forward的周期保持
+
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "kernel/irq_latency.h"
+#include "drivers/display.h"
+#include "drivers/hrtimer.h"
+#include "drivers/clocksource.h"
+#include "hrtest.h"
+
+#define HRTEST_SAMPLES      100
+#define HRTEST_WAIT_NS      (100 * NSEC_PER_MSEC)
+#define HRTEST_PERIOD_NS    NSEC_PER_MSEC
+#define HRTEST_PERIODS      200
+
+static hrtimer_t test_timer;
+static volatile bool fired;
+static volatile uint64_t fired_ns;
+static volatile uint32_t period_count;
+static volatile uint64_t period_overruns;
+static irq_hist_t period_hist;
+
+static hrtimer_restart_t hrtest_oneshot(hrtimer_t* timer) {
+    (void)timer;
+    fired_ns = ktime_get_ns();
+    fired = true;
+    return HRTIMER_NORESTART;
+}
+
+static hrtimer_restart_t hrtest_periodic(hrtimer_t* timer) {
+    uint64_t now = ktime_get_ns();
+    irq_hist_add(&period_hist, now - timer->expires);
+    if (++period_count >= HRTEST_PERIODS) {
+        return HRTIMER_NORESTART;
+    }
+    uint64_t n = hrtimer_forward(timer, now, HRTEST_PERIOD_NS);
+    if (n > 1) {
+        period_overruns += n - 1;
+    }
+    return HRTIMER_RESTART;
+}
+
+// 右对齐输出64位十进制数
+static void print_padded(uint64_t value, int width) {
+    char buf[21];
+    int len = 0;
+    do {
+        buf[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    for (int i = len; i < width; i++) {
+        print_char(' ');
+    }
+    while (len > 0) {
+        print_char(buf[--len]);
+    }
+}
+
+static void hist_clear(irq_hist_t* hist) {
+    for (int i = 0; i < IRQ_HIST_BUCKETS; i++) {
+        hist->buckets[i] = 0;
+    }
+    hist->count = 0;
+    hist->max = 0;
+}
+
+// 测量一种延迟，返回false表示有回调提前或未触发
+static bool hrtest_measure(uint64_t delay_ns) {
+    irq_hist_t hist;
+    hist_clear(&hist);
+    uint64_t total = 0;
+    uint64_t min = KTIME_MAX;
+    uint32_t early = 0;
+    uint32_t missed = 0;
+
+    for (uint32_t i = 0; i < HRTEST_SAMPLES; i++) {
+        fired = false;
+        hrtimer_start(&test_timer, delay_ns, HRTIMER_MODE_REL);
+        uint64_t expires = test_timer.expires;
+        while (!fired && ktime_get_ns() < expires + HRTEST_WAIT_NS) {
+            __asm__ volatile("pause");
+        }
+        if (!fired) {
+            hrtimer_cancel(&test_timer);
+            missed++;
+            continue;
+        }
+        if (fired_ns < expires) {
+            early++;
+            continue;
+        }
+
+        uint64_t error = fired_ns - expires;
+        irq_hist_add(&hist, error);
+        total += error;
+        if (error < min) {
+            min = error;
+        }
+    }
+
+    print_padded(delay_ns / NSEC_PER_USEC, 9);
+    print_padded(hist.count, 7);
+    if (hist.count > 0) {
+        print_padded(min, 10);
+        print_padded(total / hist.count, 10);
+        print_padded(irq_hist_percentile(&hist, 500), 10);
+        print_padded(irq_hist_percentile(&hist, 990), 10);
+        print_padded(hist.max, 11);
+    }
+    print_string("\n");
+
+    if (early > 0) {
+        print_string("  [FAIL] ");
+        print_dec(early);
+        print_string(" callbacks ran before expiry\n");
+    }
+    if (missed > 0) {
+        print_string("  [FAIL] ");
+        print_dec(missed);
+        print_string(" timers did not fire\n");
+    }
+    return early == 0 && missed == 0;
+}
+
+void cmd_hrtest(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    print_string("[HRTEST] High-resolution timers\n");
+
+    hrtimer_stats_t stats;
+    hrtimer_get_stats(&stats);
+    print_string("  Event device: ");
+    print_string(stats.device);
+    print_string("\n");
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_enable();
+
+    // 唤醒误差 = 回调中读到的ktime - expires（纳秒，百分位为log2桶上界）
+    static const uint64_t delays[] = {
+        50 * NSEC_PER_USEC, 100 * NSEC_PER_USEC, 250 * NSEC_PER_USEC,
+        500 * NSEC_PER_USEC, NSEC_PER_MSEC
+    };
+    print_string("\n  Wakeup error (ns)\n");
+    print_string("  Delay(us) Count       Min       Avg       p50       p99        Max\n");
+    bool ok = true;
+    hrtimer_init(&test_timer, hrtest_oneshot);
+    for (uint32_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+        print_string("  ");
+        ok = hrtest_measure(delays[i]) && ok;
+    }
+
+    // 周期定时器：每个周期的到期误差，超期会被hrtimer_forward跳过
+    hist_clear(&period_hist);
+    period_count = 0;
+    period_overruns = 0;
+    hrtimer_init(&test_timer, hrtest_periodic);
+    uint64_t start = ktime_get_ns();
+    hrtimer_start(&test_timer, HRTEST_PERIOD_NS, HRTIMER_MODE_REL);
+    uint64_t limit = start + HRTEST_PERIODS * HRTEST_PERIOD_NS * 2;
+    while (period_count < HRTEST_PERIODS && ktime_get_ns() < limit) {
+        __asm__ volatile("pause");
+    }
+    hrtimer_cancel(&test_timer);
+
+    print_string("\n  Periodic 1 ms: ");
+    print_dec(period_count);
+    print_string(" periods, p99 error ");
+    print_padded(irq_hist_percentile(&period_hist, 990), 0);
+    print_string(" ns, overruns ");
+    print_dec((uint32_t)period_overruns);
+    print_string("\n");
+    if (period_count < HRTEST_PERIODS) {
+        print_string("  [FAIL] Periodic timer stalled\n");
+        ok = false;
+    }
+
+    if (!was_enabled) {
+        interrupts_disable();
+    }
+
+    hrtimer_get_stats(&stats);
+    print_string("  Active: ");
+    print_dec(stats.active);
+    print_string("  Fired: ");
+    print_dec((uint32_t)stats.fired);
+    print_string("  Interrupts: ");
+    print_dec((uint32_t)stats.interrupts);
+    print_string("\n");
+
+    print_string(ok ? "[PASS] High-resolution timers\n" : "[FAIL] High-resolution timers\n");
+    print_string("[HRTEST] Done\n");
+}
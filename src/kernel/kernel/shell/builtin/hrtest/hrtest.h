@@ -0,0 +1,6 @@
+#ifndef _HRTEST_H
+#define _HRTEST_H
+
+void cmd_hrtest(int argc, char* argv[]);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "info.h"
 #include "drivers/display.h"
+#include "arch/smp.h"
 
 void cmd_info(int argc, char* argv[]) {
     (void)argc; (void)argv;
@@ -10,5 +11,19 @@ void cmd_info(int argc, char* argv[]) {
     print_string("BORUIX SYSTEM INFORMATION\n");
     print_string("==================\n");
     print_string("Architecture: x86_64 (64-bit)\n");
+    print_string("CPUs: ");
+    print_dec(smp_online_count());
+    print_string(" online / ");
+    print_dec(smp_cpu_count());
+    print_string(" present\n");
+    for (uint32_t i = 0; i < smp_cpu_count(); i++) {
+        const smp_cpu_t* cpu = smp_get_cpu(i);
+        print_string("  CPU");
+        print_dec(cpu->cpu);
+        print_string("  APIC ID ");
+        print_dec(cpu->apic_id);
+        print_string(cpu->online ? "  online" : "  offline");
+        print_string(i == 0 ? " (BSP)\n" : "\n");
+    }
     print_string("\n\n");
 }
@@ -0,0 +1,89 @@
+// 中断入口/退出开销测试
+// 向动态向量发送自IPI并等待处理程序运行，比较完整入口和精简入口的每次中断周期数
+
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "drivers/display.h"
+#include "arch/x86_64.h"
+#include "arch/apic.h"
+#include "irqbench.h"
+
+#define BENCH_ITERATIONS 10000
+
+static volatile uint32_t bench_hits;
+
+static irq_return_t bench_full_handler(uint8_t vector, void* ctx) {
+    (void)vector;
+    (void)ctx;
+    bench_hits++;
+    return IRQ_HANDLED;
+}
+
+static void bench_fast_handler(uint8_t vector) {
+    (void)vector;
+    bench_hits++;
+}
+
+// 发送自IPI并等待处理程序完成，返回平均每次中断的周期数
+static uint64_t bench_round_trip(uint8_t vector) {
+    uint32_t icr = LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | vector;
+    bench_hits = 0;
+    
+    uint64_t start = cpu_rdtsc();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        lapic_send_ipi(lapic_get_id(), icr);
+        while (bench_hits == i) {
+            __asm__ volatile("pause");
+        }
+    }
+    return (cpu_rdtsc() - start) / BENCH_ITERATIONS;
+}
+
+void cmd_irqbench(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    
+    print_string("[IRQBENCH] Interrupt entry/exit overhead\n");
+    
+    if (!apic_is_enabled()) {
+        print_string("[SKIP] Self-IPI needs the Local APIC\n");
+        return;
+    }
+    
+    int vector = irq_alloc_vector();
+    if (vector < 0) {
+        print_string("[FAIL] No free vector\n");
+        return;
+    }
+    
+    bool was_enabled = interrupts_enabled();
+    interrupts_enable();
+    
+    // 完整入口：保存全部寄存器、提高TPR、处理程序链、延迟统计
+    request_irq((uint8_t)vector, bench_full_handler, NULL, 0);
+    uint64_t full = bench_round_trip((uint8_t)vector);
+    free_irq((uint8_t)vector, bench_full_handler, NULL);
+    
+    // 精简入口：只保存调用者保存寄存器并直接调用处理程序
+    request_irq_fast((uint8_t)vector, bench_fast_handler);
+    uint64_t fast = bench_round_trip((uint8_t)vector);
+    free_irq_fast((uint8_t)vector);
+    
+    if (!was_enabled) {
+        interrupts_disable();
+    }
+    irq_free_vector((uint8_t)vector);
+    
+    print_string("  Vector: ");
+    print_dec(vector);
+    print_string("  Iterations: ");
+    print_dec(BENCH_ITERATIONS);
+    print_string("\n  Full stub (IPI + entry + exit):  ");
+    print_dec((uint32_t)full);
+    print_string(" cycles\n  Fast stub (IPI + entry + exit):  ");
+    print_dec((uint32_t)fast);
+    print_string(" cycles\n  Saved per interrupt:             ");
+    print_dec(full > fast ? (uint32_t)(full - fast) : 0);
+    print_string(" cycles\n");
+    print_string("[IRQBENCH] Done\n");
+}
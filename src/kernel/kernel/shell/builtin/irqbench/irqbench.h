@@ -0,0 +1,6 @@
+#ifndef _IRQBENCH_H
+#define _IRQBENCH_H
+
+void cmd_irqbench(int argc, char* argv[]);
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "kernel/shell.h"
 #include "kernel/interrupt.h"
+#include "arch/apic.h"
 #include "drivers/display.h"
 
 void cmd_irqinfo(int argc, char** argv) {
@@ -18,13 +19,24 @@ void cmd_irqinfo(int argc, char** argv) {
     } else {
         print_string("DISABLED\n");
     }
-    print_string("\n");
+    print_string("Controller: ");
+    print_string(irq_controller_name());
+    print_string("\n\n");
+    
+    bool apic = apic_is_enabled();
     
     // IRQ映射表
-    print_string("IRQ Mapping (PIC 8259A):\n");
-    print_string("------------------------\n");
-    print_string("IRQ  INT  Device\n");
-    print_string("---  ---  -----------------\n");
+    if (apic) {
+        print_string("IRQ Mapping (I/O APIC):\n");
+        print_string("-----------------------\n");
+        print_string("IRQ  INT  GSI  Trig   Pol   Mask  Device\n");
+        print_string("---  ---  ---  -----  ----  ----  -----------------\n");
+    } else {
+        print_string("IRQ Mapping (PIC 8259A):\n");
+        print_string("------------------------\n");
+        print_string("IRQ  INT  Device\n");
+        print_string("---  ---  -----------------\n");
+    }
     
     const char* irq_names[] = {
         "Timer (PIT)",
@@ -52,12 +64,60 @@ void cmd_irqinfo(int argc, char** argv) {
         print_string("  ");
         print_dec(32 + i);
         print_string("  ");
+        if (apic) {
+            uint32_t gsi = ioapic_irq_to_gsi(i);
+            uint64_t entry;
+            print_dec(gsi);
+            print_string(gsi < 10 ? "    " : "   ");
+            if (i == 2 || ioapic_read_redirection(gsi, &entry) != 0) {
+                print_string("-      -     -     ");
+            } else {
+                print_string((entry & (1 << 15)) ? "level  " : "edge   ");
+                print_string((entry & (1 << 13)) ? "low   " : "high  ");
+                print_string((entry & (1 << 16)) ? "yes   " : "no    ");
+            }
+        }
         print_string(irq_names[i]);
         print_string("\n");
     }
     
     print_string("\n");
-    print_string("PIC Base Vectors:\n");
-    print_string("  Master PIC: INT 32-39 (IRQ 0-7)\n");
-    print_string("  Slave PIC:  INT 40-47 (IRQ 8-15)\n");
+    if (apic) {
+        apic_info_t info;
+        apic_get_info(&info);
+        print_string("Local APIC:\n");
+        print_string("  Base: 0x");
+        print_hex(info.lapic_phys);
+        print_string("  ID: ");
+        print_dec(info.lapic_id);
+        print_string("  Version: 0x");
+        print_hex(info.lapic_version & 0xFF);
+        print_string("  Mode: ");
+        print_string(info.x2apic ? "x2APIC (MSR)" : "xAPIC (MMIO)");
+        print_string("\n  CPUs in MADT: ");
+        print_dec(info.cpu_count);
+        print_string("  Legacy PIC: ");
+        print_string(info.pic_compat ? "present (masked)\n" : "absent\n");
+        
+        for (uint32_t n = 0; n < info.ioapic_count; n++) {
+            ioapic_info_t io;
+            if (!ioapic_get_info(n, &io)) {
+                break;
+            }
+            print_string("I/O APIC ");
+            print_dec(io.id);
+            print_string(": Base 0x");
+            print_hex(io.phys);
+            print_string("  GSI ");
+            print_dec(io.gsi_base);
+            print_string("-");
+            print_dec(io.gsi_base + io.redirections - 1);
+            print_string("\n");
+        }
+        print_string("Spurious Vector: INT 255\n");
+    } else {
+        print_string("PIC Base Vectors:\n");
+        print_string("  Master PIC: INT 32-39 (IRQ 0-7)\n");
+        print_string("  Slave PIC:  INT 40-47 (IRQ 8-15)\n");
+    }
 }
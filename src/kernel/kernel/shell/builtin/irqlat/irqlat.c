@@ -0,0 +1,94 @@
+// Boruix OS irqlat命令 - 显示中断处理时间和时钟抖动分布
+// 数值为TSC周期，取自log2直方图（百分位为所在桶的上界）
+
+#include "kernel/shell.h"
+#include "kernel/interrupt.h"
+#include "kernel/irq_latency.h"
+#include "drivers/display.h"
+
+// 外部字符串工具函数
+extern int shell_strcmp(const char* str1, const char* str2);
+
+// 右对齐输出64位十进制数
+static void print_padded(uint64_t value, int width) {
+    char buf[21];
+    int len = 0;
+    do {
+        buf[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    for (int i = len; i < width; i++) {
+        print_char(' ');
+    }
+    while (len > 0) {
+        print_char(buf[--len]);
+    }
+}
+
+static void print_hist_row(const irq_hist_t* hist) {
+    print_padded(hist->count, 10);
+    print_padded(irq_hist_percentile(hist, 500), 10);
+    print_padded(irq_hist_percentile(hist, 990), 10);
+    print_padded(hist->max, 12);
+}
+
+static void show_latency(void) {
+    print_string("Interrupt Handler Duration (TSC cycles)\n");
+    print_string("========================================\n\n");
+    print_string("Vector  IRQ     Count       p50       p99         Max\n");
+    print_string("------  ---  --------  --------  --------  ----------\n");
+    
+    int rows = 0;
+    irq_hist_t hist;
+    for (int v = IRQ_BASE; v < 256; v++) {
+        if (!irq_latency_get_duration((uint8_t)v, &hist)) {
+            continue;
+        }
+        rows++;
+        
+        print_padded(v, 6);
+        print_string("  ");
+        if (v < IRQ_BASE + 16) {
+            print_padded(v - IRQ_BASE, 3);
+        } else {
+            print_string("  -");
+        }
+        print_hist_row(&hist);
+        print_string("\n");
+    }
+    if (rows == 0) {
+        print_string("No interrupts recorded.\n");
+    }
+    
+    uint64_t avg_period = 0;
+    print_string("\nTimer Inter-arrival Jitter (|period - avg|, cycles)\n");
+    print_string("---------------------------------------------------\n");
+    if (irq_latency_get_jitter(&hist, &avg_period)) {
+        print_string("Average period: ");
+        print_padded(avg_period, 0);
+        print_string("\n");
+        print_string("              Count       p50       p99         Max\n");
+        print_string("           ");
+        print_hist_row(&hist);
+        print_string("\n");
+    } else {
+        print_string("Not enough timer ticks recorded.\n");
+    }
+    
+    print_string("\nTip: 'irqlat reset' clears the histograms\n");
+}
+
+void cmd_irqlat(int argc, char** argv) {
+    if (argc > 1 && shell_strcmp(argv[1], "reset") == 0) {
+        irq_latency_reset();
+        print_string("Interrupt latency statistics cleared\n");
+        return;
+    }
+    if (argc > 1) {
+        print_string("Usage: irqlat [reset]\n");
+        return;
+    }
+    
+    show_latency();
+}
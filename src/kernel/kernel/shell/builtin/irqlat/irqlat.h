@@ -0,0 +1,8 @@
+// Boruix OS irqlat命令头文件
+
+#ifndef BORUIX_CMD_IRQLAT_H
+#define BORUIX_CMD_IRQLAT_H
+
+void cmd_irqlat(int argc, char** argv);
+
+#endif // BORUIX_CMD_IRQLAT_H
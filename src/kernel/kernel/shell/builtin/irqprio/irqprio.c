@@ -29,6 +29,7 @@ static void show_help(void) {
     print_string("  set IRQ PRIORITY   Set IRQ priority\n");
     print_string("  reset              Reset all priorities to default\n");
     print_string("  status             Show priority system status\n");
+    print_string("  defer on|off       Count deferred interrupts (reads the controller on every IRQ exit)\n");
     print_string("  help               Show this help message\n\n");
     print_string("Priority levels:\n");
     print_string("  0 - Critical (highest)\n");
@@ -39,6 +40,7 @@ static void show_help(void) {
     print_string("  irqprio              # Show all priorities\n");
     print_string("  irqprio set 1 0      # Set keyboard to critical\n");
     print_string("  irqprio reset        # Reset to defaults\n");
+    print_string("  irqprio defer on     # Start counting deferred interrupts\n");
 }
 
 // 显示所有IRQ优先级
@@ -65,8 +67,8 @@ static void show_all_priorities(void) {
         "Secondary ATA"
     };
     
-    print_string("IRQ  Priority   Blocked  Device\n");
-    print_string("---  ---------  -------  ---------------------\n");
+    print_string("IRQ  Priority   Deferred Device\n");
+    print_string("---  ---------  -------- ---------------------\n");
     
     for (int i = 0; i < 16; i++) {
         uint8_t priority = irq_get_priority(i);
@@ -88,7 +90,7 @@ static void show_all_priorities(void) {
         for (int j = name_len; j < 9; j++) print_char(' ');
         print_string("  ");
         
-        // 被阻塞次数
+        // 被推迟次数
         if (blocked > 0) {
             print_dec((uint32_t)blocked);
         } else {
@@ -102,6 +104,9 @@ static void show_all_priorities(void) {
     }
     
     print_string("\n");
+    if (!irq_defer_accounting_enabled()) {
+        print_string("Deferred counting is off, use 'irqprio defer on'\n");
+    }
 }
 
 // 显示优先级系统状态
@@ -126,18 +131,18 @@ static void show_status(void) {
     print_dec(nesting_count);
     print_string("\n\n");
     
-    // 统计被阻塞的中断
+    // 统计被推迟的中断
     uint64_t total_blocked = 0;
     for (int i = 0; i < 16; i++) {
         total_blocked += irq_get_blocked_count(i);
     }
     
-    print_string("Total Blocked Interrupts: ");
+    print_string("Total Deferred Interrupts: ");
     print_dec((uint32_t)total_blocked);
-    print_string("\n\n");
+    print_string(irq_defer_accounting_enabled() ? "\n\n" : " (counting off)\n\n");
     
     if (total_blocked > 0) {
-        print_string("IRQs with blocked interrupts:\n");
+        print_string("IRQs with deferred interrupts:\n");
         for (int i = 0; i < 16; i++) {
             uint64_t blocked = irq_get_blocked_count(i);
             if (blocked > 0) {
@@ -145,7 +150,7 @@ static void show_status(void) {
                 print_dec(i);
                 print_string(": ");
                 print_dec((uint32_t)blocked);
-                print_string(" blocked\n");
+                print_string(" deferred\n");
             }
         }
     }
@@ -194,6 +199,16 @@ void cmd_irqprio(int argc, char** argv) {
         show_status();
     } else if (shell_strcmp(argv[1], "reset") == 0) {
         reset_priorities();
+    } else if (shell_strcmp(argv[1], "defer") == 0) {
+        if (argc >= 3 && shell_strcmp(argv[2], "on") == 0) {
+            irq_defer_accounting_enable(1);
+            print_string("Deferred interrupt counting enabled\n");
+        } else if (argc >= 3 && shell_strcmp(argv[2], "off") == 0) {
+            irq_defer_accounting_enable(0);
+            print_string("Deferred interrupt counting disabled\n");
+        } else {
+            print_string("Usage: irqprio defer on|off\n");
+        }
     } else if (shell_strcmp(argv[1], "set") == 0) {
         if (argc < 4) {
             print_string("Error: 'set' requires IRQ and priority\n");
@@ -1,8 +1,12 @@
 // Boruix OS irqstat命令 - 显示中断统计信息
 
 #include "kernel/shell.h"
+#include "kernel/interrupt.h"
+#include "kernel/softirq.h"
 #include "drivers/display.h"
 #include "drivers/timer.h"
+#include "drivers/tick.h"
+#include "drivers/ktimer.h"
 
 // 外部函数
 #ifdef __x86_64__
@@ -38,7 +42,10 @@ void cmd_irqstat(int argc, char** argv) {
     print_dec(seconds);
     print_string(" (");
     print_dec(system_ticks);
-    print_string(" ticks)\n\n");
+    print_string(" ticks)\n");
+    print_string("Controller: ");
+    print_string(irq_controller_name());
+    print_string("\n\n");
     
     // 显示中断计数
     print_string("IRQ Statistics:\n");
@@ -107,6 +114,110 @@ void cmd_irqstat(int argc, char** argv) {
         print_string("No IRQ activity detected.\n");
     }
     
+    // 中断风暴（中断源被屏蔽并改为轮询），ISA线路按IRQ号显示，其余按向量显示
+    int storm_lines = 0;
+    for (uint32_t v = IRQ_BASE; v < 256; v++) {
+        uint8_t vector = (uint8_t)v;
+        uint32_t storms = irq_storm_get_count(vector);
+        if (storms == 0) {
+            continue;
+        }
+        if (storm_lines++ == 0) {
+            print_string("\nInterrupt storms (source masked, polled from timer):\n");
+        }
+        if (vector < IRQ_BASE + 16) {
+            print_string("  IRQ");
+            print_dec(vector - IRQ_BASE);
+        } else {
+            print_string("  Vector ");
+            print_dec(vector);
+        }
+        print_string(": ");
+        print_dec(storms);
+        print_string(" storm(s), ");
+        print_dec(irq_storm_get_recoveries(vector));
+        print_string(" recovery(s), ");
+        print_dec((uint32_t)irq_storm_get_polls(vector));
+        print_string(" poll(s), mode: ");
+        print_string(irq_storm_is_polling(vector) ? "polling\n" : "interrupt\n");
+    }
+    if (storm_lines == 0) {
+        print_string("\nInterrupt storms: none\n");
+    }
+    
+    // 软中断执行次数
+    print_string("\nSoftirqs:\n");
+    for (uint32_t nr = 0; nr < SOFTIRQ_COUNT; nr++) {
+        print_string("  ");
+        print_string(softirq_get_name(nr));
+        print_string(": ");
+        print_dec((uint32_t)softirq_get_count(nr));
+        print_string("\n");
+    }
+    print_string("  Deferred (budget exhausted): ");
+    print_dec((uint32_t)softirq_get_deferred_count());
+    print_string("\n");
+    
+    ktimer_stats_t kts;
+    ktimer_get_stats(&kts);
+    print_string("  Kernel timers: ");
+    print_dec(kts.pending);
+    print_string(" pending, ");
+    print_dec((uint32_t)kts.fired);
+    print_string(" fired, ");
+    print_dec((uint32_t)kts.cascades);
+    print_string(" cascades\n");
+    
+    // 关中断窗口（TSC周期）
+    irq_window_stats_t hardirq, softirq;
+    irq_get_off_window_stats(&hardirq);
+    print_string("\nIRQ-off window (cycles):\n");
+    print_string("  Hard IRQ  avg ");
+    print_dec(hardirq.samples ? (uint32_t)(hardirq.total_cycles / hardirq.samples) : 0);
+    print_string("  max ");
+    print_dec((uint32_t)hardirq.max_cycles);
+    print_string("  samples ");
+    print_dec((uint32_t)hardirq.samples);
+    print_string("\n");
+    
+    // 软中断执行时间（开中断运行，不计入关中断窗口）
+    softirq_get_run_stats(&softirq);
+    print_string("Softirq run time (cycles, IRQs on):\n");
+    print_string("  do_softirq  avg ");
+    print_dec(softirq.samples ? (uint32_t)(softirq.total_cycles / softirq.samples) : 0);
+    print_string("  max ");
+    print_dec((uint32_t)softirq.max_cycles);
+    print_string("  runs ");
+    print_dec((uint32_t)softirq.samples);
+    print_string("\n");
+    
+    // 滴答设备与NO_HZ空闲
+    const clock_event_device_t* tick_dev = tick_get_device();
+    print_string("\nTick: ");
+    if (tick_dev) {
+        tick_stats_t ts;
+        tick_get_stats(&ts);
+        print_string(tick_dev->name);
+        print_string((tick_dev->features & CLOCK_EVT_FEAT_DEADLINE) ? " (TSC-deadline)" : " (one-shot)");
+        print_string(", clocksource ");
+        print_string(clocksource_get_current()->name);
+        print_string("\n  Events: ");
+        print_dec((uint32_t)ts.events);
+        print_string("  Idle entries: ");
+        print_dec((uint32_t)ts.idle_entries);
+        print_string("  Tick stopped: ");
+        print_dec((uint32_t)ts.nohz_entries);
+        print_string("\n  Ticks skipped: ");
+        print_dec((uint32_t)ts.ticks_skipped);
+        print_string("  Idle time: ");
+        print_dec((uint32_t)(ts.idle_ns / NSEC_PER_MSEC));
+        print_string(" ms\n");
+    } else {
+        print_string("PIT periodic, clocksource ");
+        print_string(clocksource_get_current()->name);
+        print_string("\n");
+    }
+    
     print_string("\n");
     print_string("Tip: Use 'irqinfo' to see IRQ configuration\n");
 }
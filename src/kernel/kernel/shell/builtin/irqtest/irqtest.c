@@ -1,5 +1,5 @@
 // Boruix OS irqtest命令 - 测试中断优先级系统
-// 通过调整优先级来测试阻塞机制
+// 通过调整优先级来测试嵌套和推迟机制
 
 #include "kernel/shell.h"
 #include "kernel/interrupt.h"
@@ -54,8 +54,8 @@ void cmd_irqtest(int argc, char** argv) {
     irq_set_priority(0, IRQ_PRIORITY_HIGH);
     print_string("IRQ0 priority set to HIGH\n\n");
     
-    print_string("Now try typing on keyboard - IRQ1 should be blocked by IRQ0\n");
-    print_string("Use 'irqprio' to check blocked counts\n");
+    print_string("Now try typing on keyboard - IRQ1 is deferred while IRQ0 runs, not lost\n");
+    print_string("Use 'irqprio defer on' then 'irqprio' to check deferred counts\n");
     print_string("Use 'irqprio reset' to restore defaults\n\n");
     
     print_string("Test completed. Priority system is working!\n");
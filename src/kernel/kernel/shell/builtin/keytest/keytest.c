@@ -4,6 +4,7 @@
 #include "keytest.h"
 #include "drivers/display.h"
 #include "drivers/keyboard.h"
+#include "drivers/delay.h"
 #include "../../utils/string.h"
 
 // 键盘测试命令
@@ -39,8 +40,8 @@ void cmd_keytest(int argc, char* argv[]) {
             key_count++;
         }
         
-        // 简单的延迟
-        for (volatile int i = 0; i < 100000; i++);
+        // 等待下一个按键，期间让CPU休眠
+        msleep(1);
     }
     
     print_string("Keyboard test completed.\n");
@@ -0,0 +1,80 @@
+#include "kernel/kernel.h"
+#include "drivers/display.h"
+#include "rust/rust_memory.h"
+#include "kstacktest.h"
+
+#define TEST_STACK_PAGES 4
+
+void cmd_kstacktest(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    
+    print_string("[KSTACKTEST] Starting kernel stack allocator test...\n");
+    
+    // 测试1: 分配内核栈
+    print_string("[TEST 1] Allocating 16 KB kernel stack...\n");
+    uint64_t top = rust_kstack_alloc(TEST_STACK_PAGES);
+    if (top == 0) {
+        print_string("[FAIL] Failed to allocate kernel stack\n");
+        return;
+    }
+    print_string("  Stack top:    0x");
+    print_hex((uint32_t)(top >> 32));
+    print_hex((uint32_t)top);
+    print_string("\n");
+    print_string("[OK] Kernel stack allocated\n\n");
+    
+    // 测试2: 整个栈可读写
+    print_string("[TEST 2] Writing to every stack page...\n");
+    uint64_t bottom = top - TEST_STACK_PAGES * 4096;
+    for (uint64_t addr = bottom; addr < top; addr += 4096) {
+        *(volatile uint64_t*)addr = addr;
+    }
+    int ok = 1;
+    for (uint64_t addr = bottom; addr < top; addr += 4096) {
+        if (*(volatile uint64_t*)addr != addr) {
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        print_string("[FAIL] Stack memory read/write failed\n");
+        rust_kstack_free(top);
+        return;
+    }
+    print_string("[OK] Stack memory read/write successful\n\n");
+    
+    // 测试3: 栈底下方是保护页
+    print_string("[TEST 3] Checking guard page below stack...\n");
+    if (!rust_kstack_is_guard_page(bottom - 1) || rust_virt_to_phys(bottom - 4096) != 0) {
+        print_string("[FAIL] Guard page missing\n");
+        rust_kstack_free(top);
+        return;
+    }
+    print_string("[OK] Guard page is unmapped\n\n");
+    
+    // 测试4: 释放后再次分配应复用缓存的栈
+    print_string("[TEST 4] Free and reallocate (cache reuse)...\n");
+    rust_kstack_free(top);
+    uint64_t top2 = rust_kstack_alloc(TEST_STACK_PAGES);
+    if (top2 != top) {
+        print_string("[FAIL] Cached stack was not reused\n");
+        rust_kstack_free(top2);
+        return;
+    }
+    print_string("[OK] Cached stack reused without remapping\n\n");
+    rust_kstack_free(top2);
+    
+    size_t in_use, cached, hits;
+    rust_kstack_stats(&in_use, &cached, &hits);
+    print_string("  In use: ");
+    print_dec((uint32_t)in_use);
+    print_string("  Cached: ");
+    print_dec((uint32_t)cached);
+    print_string("  Cache hits: ");
+    print_dec((uint32_t)hits);
+    print_string("\n\n");
+    
+    print_string("==============================================\n");
+    print_string("[KSTACKTEST] All tests completed successfully!\n");
+    print_string("==============================================\n");
+}
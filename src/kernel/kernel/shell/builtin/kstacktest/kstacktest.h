@@ -0,0 +1,6 @@
+#ifndef _KSTACKTEST_H
+#define _KSTACKTEST_H
+
+void cmd_kstacktest(int argc, char* argv[]);
+
+#endif
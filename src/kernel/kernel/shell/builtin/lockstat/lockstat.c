@@ -0,0 +1,88 @@
+// Boruix OS lockstat命令 - 显示锁的获取、争用、等待和持有时间
+// 时间为TSC周期；只列出lockstat打开后获取过的锁
+
+#include "kernel/shell.h"
+#include "kernel/spinlock.h"
+#include "drivers/display.h"
+
+// 外部字符串工具函数
+extern int shell_strcmp(const char* str1, const char* str2);
+
+// 右对齐输出64位十进制数
+static void print_padded(uint64_t value, int width) {
+    char buf[21];
+    int len = 0;
+    do {
+        buf[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    for (int i = len; i < width; i++) {
+        print_char(' ');
+    }
+    while (len > 0) {
+        print_char(buf[--len]);
+    }
+}
+
+// 左对齐输出名字，过长时截断
+static void print_name(const char* name, int width) {
+    int len = 0;
+    while (name[len] && len < width) {
+        print_char(name[len++]);
+    }
+    for (; len < width; len++) {
+        print_char(' ');
+    }
+}
+
+static void show_lockstat(void) {
+    print_string("Lock Statistics (TSC cycles, lockstat ");
+    print_string(lockstat_is_enabled() ? "on" : "off");
+    print_string(")\n");
+    print_string("==========================================\n\n");
+    print_string("Name                    Acquired  Contended   AvgWait   MaxWait   AvgHold   MaxHold\n");
+    print_string("--------------------  ----------  ---------  --------  --------  --------  --------\n");
+    
+    int rows = 0;
+    for (lockstat_t* s = lockstat_first(); s; s = lockstat_next(s)) {
+        // 读取期间锁可能被获取，数值只作参考
+        uint64_t acquired = s->acquisitions;
+        uint64_t contended = s->contentions;
+        rows++;
+        
+        print_name(s->name, 20);
+        print_padded(acquired, 12);
+        print_padded(contended, 11);
+        print_padded(contended ? s->wait_cycles / contended : 0, 10);
+        print_padded(s->wait_max, 10);
+        print_padded(acquired ? s->hold_cycles / acquired : 0, 10);
+        print_padded(s->hold_max, 10);
+        print_string("\n");
+    }
+    if (rows == 0) {
+        print_string("No locks recorded.\n");
+    }
+    
+    print_string("\nTip: 'lockstat on|off' toggles recording, 'lockstat reset' clears counters\n");
+}
+
+void cmd_lockstat(int argc, char** argv) {
+    if (argc == 1) {
+        show_lockstat();
+        return;
+    }
+    
+    if (argc == 2 && shell_strcmp(argv[1], "on") == 0) {
+        lockstat_enable(1);
+        print_string("Lock statistics enabled\n");
+    } else if (argc == 2 && shell_strcmp(argv[1], "off") == 0) {
+        lockstat_enable(0);
+        print_string("Lock statistics disabled\n");
+    } else if (argc == 2 && shell_strcmp(argv[1], "reset") == 0) {
+        lockstat_reset();
+        print_string("Lock statistics cleared\n");
+    } else {
+        print_string("Usage: lockstat [on|off|reset]\n");
+    }
+}
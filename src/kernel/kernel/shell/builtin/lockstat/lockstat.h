@@ -0,0 +1,8 @@
+// Boruix OS lockstat命令头文件
+
+#ifndef BORUIX_CMD_LOCKSTAT_H
+#define BORUIX_CMD_LOCKSTAT_H
+
+void cmd_lockstat(int argc, char** argv);
+
+#endif // BORUIX_CMD_LOCKSTAT_H
@@ -0,0 +1,6 @@
+#ifndef _LOCKTEST_H
+#define _LOCKTEST_H
+
+void cmd_locktest(int argc, char* argv[]);
+
+#endif
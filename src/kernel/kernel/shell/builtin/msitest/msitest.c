@@ -0,0 +1,128 @@
+// MSI/MSI-X测试程序
+// 为第一个支持消息中断的PCI设备分配每队列向量，用自发IPI验证分发路径
+
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "drivers/display.h"
+#include "drivers/delay.h"
+#include "arch/apic.h"
+#include "arch/msi.h"
+#include "msitest.h"
+#include "pci.h"
+
+#define TEST_MAX_QUEUES 4
+#define PCI_CONFIG_COMMAND 0x04
+
+static volatile uint32_t queue_hits[TEST_MAX_QUEUES];
+
+static irq_return_t msitest_irq(uint8_t vector, void* ctx) {
+    (void)vector;
+    (*(volatile uint32_t*)ctx)++;
+    return IRQ_HANDLED;
+}
+
+void cmd_msitest(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+    
+    print_string("[MSITEST] Starting MSI/MSI-X test...\n");
+    
+    if (!apic_is_enabled()) {
+        print_string("[SKIP] APIC not enabled, MSI unavailable\n");
+        return;
+    }
+    
+    if (pci_get_device_count() == 0) {
+        pci_init();
+    }
+    
+    // 测试1: 查找支持MSI/MSI-X的设备
+    print_string("[TEST 1] Looking for MSI-capable device...\n");
+    size_t count = pci_get_device_count();
+    size_t index = count;
+    pci_msi_info_t info;
+    for (size_t i = 0; i < count; i++) {
+        if (pci_get_msi_info(i, &info)) {
+            index = i;
+            break;
+        }
+    }
+    if (index == count) {
+        print_string("[SKIP] No device with MSI or MSI-X\n");
+        return;
+    }
+    
+    pci_device_t dev;
+    pci_get_device(index, &dev);
+    print_string("  Device ");
+    print_hex(dev.vendor_id);
+    print_string(":");
+    print_hex(dev.device_id);
+    print_string("  MSI vectors: ");
+    print_dec(info.msi_offset ? info.msi_max_vectors : 0);
+    print_string("  MSI-X entries: ");
+    print_dec(info.msix_offset ? info.msix_table_size : 0);
+    print_string("\n[OK] Device found\n\n");
+    
+    // 启用消息中断会打开总线主控和INTx屏蔽，测试结束后恢复原命令寄存器
+    // （状态寄存器的错误位写1清除，回写时高16位置0）
+    uint16_t saved_command = pci_read_config_word(dev.bus, dev.device, dev.function, PCI_CONFIG_COMMAND);
+    
+    // 测试2: 分配每队列向量
+    print_string("[TEST 2] Allocating per-queue vectors...\n");
+    int queues = pci_alloc_irq_vectors(index, 1, TEST_MAX_QUEUES, PCI_IRQ_MSI | PCI_IRQ_MSIX);
+    if (queues < 0) {
+        print_string("[FAIL] pci_alloc_irq_vectors failed\n");
+        pci_write_config_dword(dev.bus, dev.device, dev.function, PCI_CONFIG_COMMAND, saved_command);
+        return;
+    }
+    print_string("  Mode: ");
+    print_string(pci_irq_mode(index) == PCI_IRQ_MSIX ? "MSI-X" : "MSI");
+    print_string("  Queues: ");
+    print_dec(queues);
+    print_string("  Vectors:");
+    for (int q = 0; q < queues; q++) {
+        print_string(" ");
+        print_dec(pci_irq_vector(index, q));
+        queue_hits[q] = 0;
+        request_irq((uint8_t)pci_irq_vector(index, q), msitest_irq, (void*)&queue_hits[q], 0);
+    }
+    print_string("\n[OK] Vectors allocated and handlers registered\n\n");
+    
+    // 测试3: 向每个向量发送自IPI，检查对应队列的处理程序被调用
+    print_string("[TEST 3] Self-IPI to each queue vector...\n");
+    bool was_enabled = interrupts_enabled();
+    interrupts_enable();
+    for (int q = 0; q < queues; q++) {
+        lapic_send_ipi(lapic_get_id(), LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | (uint32_t)pci_irq_vector(index, q));
+    }
+    mdelay(1);
+    if (!was_enabled) {
+        interrupts_disable();
+    }
+    
+    int ok = 1;
+    for (int q = 0; q < queues; q++) {
+        if (queue_hits[q] == 0) {
+            ok = 0;
+        }
+    }
+    print_string(ok ? "[OK] Every queue handler ran\n\n" : "[FAIL] Some queue handlers did not run\n\n");
+    
+    // 测试4: 释放
+    print_string("[TEST 4] Freeing vectors...\n");
+    for (int q = 0; q < queues; q++) {
+        free_irq((uint8_t)pci_irq_vector(index, q), msitest_irq, (void*)&queue_hits[q]);
+    }
+    pci_free_irq_vectors(index);
+    pci_write_config_dword(dev.bus, dev.device, dev.function, PCI_CONFIG_COMMAND, saved_command);
+    if (pci_irq_vector(index, 0) != -1) {
+        print_string("[FAIL] Vectors still assigned after free\n");
+        return;
+    }
+    print_string("[OK] Vectors released, INTx restored\n\n");
+    
+    print_string("==========================================\n");
+    print_string(ok ? "[MSITEST] All tests completed successfully!\n" : "[MSITEST] Tests completed with failures\n");
+    print_string("==========================================\n");
+}
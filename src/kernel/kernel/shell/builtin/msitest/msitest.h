@@ -0,0 +1,6 @@
+#ifndef _MSITEST_H
+#define _MSITEST_H
+
+void cmd_msitest(int argc, char* argv[]);
+
+#endif
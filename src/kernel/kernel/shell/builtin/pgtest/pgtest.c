@@ -9,6 +9,7 @@ extern void rust_free_page(uint64_t page_addr);
 extern int rust_map_page(uint64_t virtual_addr, uint64_t physical_addr, uint64_t flags);
 extern uint64_t rust_unmap_page(uint64_t virtual_addr);
 extern uint64_t rust_virt_to_phys(uint64_t virtual_addr);
+extern size_t rust_page_table_pages(void);
 
 // 页表标志位
 #define PAGE_PRESENT    (1 << 0)
@@ -16,6 +17,8 @@ extern uint64_t rust_virt_to_phys(uint64_t virtual_addr);
 #define PAGE_USER       (1 << 2)
 
 #define TEST_VIRT_ADDR  0xFFFFFFFF90000000ULL  // 测试虚拟地址（内核堆区域）
+#define TEST_RECLAIM_ADDR 0xFFFFFFC000000000ULL // 页表回收测试地址（独立的PDPT项）
+#define TEST_RECLAIM_ROUNDS 64
 
 void cmd_pgtest(int argc, char* argv[]) {
     (void)argc;  // 未使用的参数
@@ -123,8 +126,31 @@ void cmd_pgtest(int argc, char* argv[]) {
         print_string("[WARN] Page still appears to be mapped\n");
     }
     
-    // 测试7: 释放物理页面
-    print_string("[TEST 7] Freeing physical page...\n");
+    // 测试7: 反复映射/取消映射，页表页面应被回收
+    print_string("[TEST 7] Map/unmap churn, checking page table reclamation...\n");
+    size_t tables_before = rust_page_table_pages();
+    for (int i = 0; i < TEST_RECLAIM_ROUNDS; i++) {
+        uint64_t virt = TEST_RECLAIM_ADDR + (uint64_t)i * 0x200000ULL;  // 每轮使用新的PT
+        if (rust_map_page(virt, phys_page, PAGE_WRITABLE) != 0) {
+            print_string("[FAIL] Failed to map churn page\n");
+            break;
+        }
+        rust_unmap_page(virt);
+    }
+    size_t tables_after = rust_page_table_pages();
+    print_string("  Page table pages: ");
+    print_dec((uint32_t)tables_before);
+    print_string(" -> ");
+    print_dec((uint32_t)tables_after);
+    print_string("\n");
+    if (tables_after <= tables_before) {
+        print_string("[OK] No page table pages leaked\n");
+    } else {
+        print_string("[FAIL] Page table pages leaked\n");
+    }
+    
+    // 测试8: 释放物理页面
+    print_string("[TEST 8] Freeing physical page...\n");
     rust_free_page(phys_page);
     print_string("[OK] Physical page freed\n");
     
@@ -3,6 +3,7 @@
 
 #include "reboot.h"
 #include "drivers/display.h"
+#include "drivers/delay.h"
 #include "../../utils/system.h"
 
 void cmd_reboot(int argc, char* argv[]) {
@@ -12,7 +13,7 @@ void cmd_reboot(int argc, char* argv[]) {
     print_string("Goodbye!\n");
     
     // 等待一下让用户看到消息
-    for (volatile int i = 0; i < 10000000; i++);
+    msleep(200);
     
     // 重启系统
     reboot_system();
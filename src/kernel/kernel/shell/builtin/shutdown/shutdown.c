@@ -3,12 +3,13 @@
 
 #include "shutdown.h"
 #include "drivers/display.h"
+#include "drivers/delay.h"
 #include "../../utils/system.h"
 
 void cmd_shutdown(int argc, char* argv[]) {
     (void)argc; (void)argv;
     
-    for (volatile int i = 0; i < 5000000; i++);
+    msleep(100);
     
     print_string("\nInitiating power-down sequence...\n");
     print_string("\n");
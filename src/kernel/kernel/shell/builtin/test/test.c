@@ -25,9 +25,8 @@ void cmd_test(int argc, char* argv[]) {
     
     // 显示当前时间
     print_string("Current time: ");
-    uint8_t sec = read_cmos(0x00);
-    uint8_t min = read_cmos(0x02);
-    uint8_t hour = read_cmos(0x04);
+    uint8_t hour, min, sec;
+    get_current_time(&hour, &min, &sec);
     
     print_dec(hour);
     print_char(':');
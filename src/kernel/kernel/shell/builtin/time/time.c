@@ -4,10 +4,21 @@
 #include "time.h"
 #include "drivers/display.h"
 #include "drivers/cmos.h"
+#include "drivers/clocksource.h"
 
 void cmd_time(int argc, char* argv[]) {
     (void)argc; (void)argv;
     print_string("Current time: ");
     print_current_time();
     print_char('\n');
+    
+    uint64_t now = ktime_get_real_ns();
+    print_string("Unix time: ");
+    print_dec((uint32_t)(now / NSEC_PER_SEC));
+    print_char('.');
+    uint32_t ms = (uint32_t)(now % NSEC_PER_SEC / NSEC_PER_MSEC);
+    print_char('0' + ms / 100);
+    print_char('0' + ms / 10 % 10);
+    print_char('0' + ms % 10);
+    print_char('\n');
 }
@@ -0,0 +1,135 @@
+// 内核定时器测试
+// 覆盖tv1内的定时器、需要下放的远期定时器、取消和修改，检查触发滴答与顺序
+
+#include "kernel/kernel.h"
+#include "kernel/interrupt.h"
+#include "drivers/display.h"
+#include "drivers/ktimer.h"
+#include "drivers/tick.h"
+#include "timertest.h"
+
+#define TIMERTEST_COUNT 5
+
+typedef struct {
+    ktimer_t timer;
+    uint32_t expected;      // 期望触发的滴答
+    uint32_t fired_at;      // 实际触发的滴答
+    bool fired;
+} timertest_entry_t;
+
+static timertest_entry_t entries[TIMERTEST_COUNT];
+static uint32_t fire_order[TIMERTEST_COUNT];
+static volatile uint32_t fire_count;
+
+static void timertest_callback(uintptr_t data) {
+    timertest_entry_t* entry = &entries[data];
+    entry->fired = true;
+    entry->fired_at = system_ticks;
+    if (fire_count < TIMERTEST_COUNT) {
+        fire_order[fire_count] = (uint32_t)data;
+    }
+    fire_count++;
+}
+
+void cmd_timertest(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    print_string("[TIMERTEST] Hierarchical timer wheel\n");
+
+    bool was_enabled = interrupts_enabled();
+    interrupts_enable();
+
+    fire_count = 0;
+    for (uint32_t i = 0; i < TIMERTEST_COUNT; i++) {
+        timer_setup(&entries[i].timer, timertest_callback, i);
+        entries[i].fired = false;
+        entries[i].fired_at = 0;
+    }
+
+    // 0: 1滴答  1: 5滴答  2: 300滴答（需从tv2下放）  3: 取消  4: 先10滴答再改为2滴答
+    uint32_t now = system_ticks;
+    uint32_t offsets[TIMERTEST_COUNT] = {1, 5, 300, 3, 2};
+    timer_add(&entries[0].timer, now + 1);
+    timer_add(&entries[1].timer, now + 5);
+    timer_add(&entries[2].timer, now + 300);
+    timer_add(&entries[3].timer, now + 3);
+    timer_add(&entries[4].timer, now + 10);
+    for (uint32_t i = 0; i < TIMERTEST_COUNT; i++) {
+        entries[i].expected = now + offsets[i];
+    }
+
+    bool ok = true;
+    if (timer_add(&entries[0].timer, now + 1) != -1) {
+        print_string("[FAIL] Double add accepted\n");
+        ok = false;
+    }
+    if (timer_cancel(&entries[3].timer) != 1 || timer_pending(&entries[3].timer)) {
+        print_string("[FAIL] Cancel\n");
+        ok = false;
+    }
+    if (timer_mod(&entries[4].timer, now + 2) != 1) {
+        print_string("[FAIL] Modify pending timer\n");
+        ok = false;
+    }
+
+    print_string("  Waiting about 3 seconds for the cascaded timer...\n");
+    uint32_t deadline = now + 400;
+    while (fire_count < TIMERTEST_COUNT - 1 && time_after(deadline, system_ticks)) {
+        cpu_idle();
+    }
+
+    for (uint32_t i = 0; i < TIMERTEST_COUNT; i++) {
+        print_string("  Timer ");
+        print_dec(i);
+        if (i == 3) {
+            print_string(entries[i].fired ? ": fired after cancel\n" : ": cancelled\n");
+            ok = ok && !entries[i].fired;
+            continue;
+        }
+        if (!entries[i].fired) {
+            print_string(": did not fire\n");
+            ok = false;
+            continue;
+        }
+        print_string(": expected tick +");
+        print_dec(offsets[i]);
+        print_string(", fired at +");
+        print_dec(entries[i].fired_at - now);
+        print_string("\n");
+        // 回调在到期滴答的软中断中执行，不能提前
+        if (time_after(entries[i].expected, entries[i].fired_at)) {
+            ok = false;
+        }
+    }
+
+    // 触发顺序应为 0, 4, 1, 2
+    static const uint32_t expected_order[] = {0, 4, 1, 2};
+    for (uint32_t i = 0; i < 4 && i < fire_count; i++) {
+        if (fire_order[i] != expected_order[i]) {
+            print_string("[FAIL] Wrong firing order\n");
+            ok = false;
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < TIMERTEST_COUNT; i++) {
+        timer_cancel(&entries[i].timer);
+    }
+    if (!was_enabled) {
+        interrupts_disable();
+    }
+
+    ktimer_stats_t stats;
+    ktimer_get_stats(&stats);
+    print_string("  Pending: ");
+    print_dec(stats.pending);
+    print_string("  Fired: ");
+    print_dec((uint32_t)stats.fired);
+    print_string("  Cascades: ");
+    print_dec((uint32_t)stats.cascades);
+    print_string("\n");
+
+    print_string(ok ? "[PASS] Timer wheel\n" : "[FAIL] Timer wheel\n");
+    print_string("[TIMERTEST] Done\n");
+}
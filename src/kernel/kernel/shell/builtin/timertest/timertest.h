@@ -0,0 +1,6 @@
+#ifndef _TIMERTEST_H
+#define _TIMERTEST_H
+
+void cmd_timertest(int argc, char* argv[]);
+
+#endif
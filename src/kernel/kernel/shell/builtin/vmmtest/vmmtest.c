@@ -1,6 +1,7 @@
 #include "kernel/kernel.h"
 #include "kernel/serial_debug.h"
 #include "drivers/display.h"
+#include "rust/rust_memory.h"
 #include "vmmtest.h"
 
 // 外部Rust函数声明
@@ -146,6 +147,28 @@ void cmd_vmmtest(int argc, char* argv[]) {
     print_string(" MB\n");
     print_string("[OK] Heap usage updated\n\n");
     
+    // 测试7: 将64KB块转换为物理段列表
+    print_string("[TEST 7] Translating 64 KB block to scatter-gather list...\n");
+    rust_sg_entry_t sg[16];
+    int64_t segments = rust_virt_range_to_sg(large_addr, 64 * 1024, sg, 16);
+    if (segments <= 0) {
+        print_string("[FAIL] Failed to build scatter-gather list\n");
+        return;
+    }
+    uint64_t sg_total = 0;
+    for (int64_t i = 0; i < segments; i++) {
+        sg_total += sg[i].length;
+    }
+    print_string("  Segments:     ");
+    print_dec((uint32_t)segments);
+    print_string("\n");
+    if (sg_total == 64 * 1024 && sg[0].phys_addr == rust_virt_to_phys(large_addr)) {
+        print_string("[OK] Scatter-gather list covers the whole block\n\n");
+    } else {
+        print_string("[FAIL] Scatter-gather list does not match page tables\n");
+        return;
+    }
+    
     print_string("==============================================\n");
     print_string("[VMMTEST] All tests completed successfully!\n");
     print_string("==============================================\n");
@@ -19,6 +19,14 @@ void cmd_pgtest(int argc, char* argv[]);
 void cmd_vmmtest(int argc, char* argv[]);
 void cmd_heaptest(int argc, char* argv[]);
 void cmd_memprottest(int argc, char* argv[]);
+void cmd_kstacktest(int argc, char* argv[]);
+void cmd_apicbench(int argc, char* argv[]);
+void cmd_msitest(int argc, char* argv[]);
+void cmd_irqbench(int argc, char* argv[]);
+void cmd_hpettest(int argc, char* argv[]);
+void cmd_timertest(int argc, char* argv[]);
+void cmd_hrtest(int argc, char* argv[]);
+void cmd_locktest(int argc, char* argv[]);
 #endif
 
 // 命令表
@@ -31,8 +39,10 @@ static shell_command_t commands[] = {
     {"info", "Show system information", cmd_info},
     {"uptime", "Show system uptime", cmd_uptime},
     {"irqstat", "Show interrupt statistics", cmd_irqstat},
+    {"irqlat", "Show interrupt handler latency histograms", cmd_irqlat},
     {"irqinfo", "Show IRQ configuration", cmd_irqinfo},
     {"irqprio", "Manage IRQ priorities", cmd_irqprio},
+    {"lockstat", "Show lock contention statistics", cmd_lockstat},
     {"reboot", "Reboot system", cmd_reboot},
     {"shutdown", "Shutdown system", cmd_shutdown},
     {"great", "Let the great Yang Borui give you the answer.", cmd_great},
@@ -51,6 +61,14 @@ static shell_command_t commands[] = {
     {"test_pci", "Test PCI driver functionality", cmd_test_pci},
     {"pci_info", "Show detailed PCI device information", cmd_pci_info},
     {"memprottest", "Test memory protection mechanism", cmd_memprottest},
+    {"kstacktest", "Test guard-paged kernel stack allocator", cmd_kstacktest},
+    {"apicbench", "Benchmark APIC EOI cost in xAPIC and x2APIC modes", cmd_apicbench},
+    {"msitest", "Test PCI MSI/MSI-X vector allocation", cmd_msitest},
+    {"irqbench", "Benchmark full vs fast interrupt entry cost", cmd_irqbench},
+    {"hpettest", "Test HPET clocksource and one-shot comparators", cmd_hpettest},
+    {"timertest", "Test kernel timer wheel (add/mod/cancel, cascading)", cmd_timertest},
+    {"hrtest", "Measure high-resolution timer wakeup error", cmd_hrtest},
+    {"locktest", "Test spinlock, ticket and MCS lock primitives", cmd_locktest},
     {"memtest", "Test TTY memory management and page tables", cmd_memtest},
     {"test", "Test command", cmd_test},
 #endif
@@ -3,6 +3,7 @@
 
 #include "system.h"
 #include "drivers/display.h"
+#include "drivers/delay.h"
 
 // 简单的端口输出函数
 static void outb(uint16_t port, uint8_t value) {
@@ -35,7 +36,7 @@ void reboot_system(void) {
         outb(0x64, 0xFE);
         
         // 等待重启生效
-        for (volatile int i = 0; i < 1000000; i++);
+        mdelay(100);
     }
     
     // 方法2: 通过Triple Fault（如果8042失败）
@@ -109,7 +110,7 @@ void acpi_shutdown(void) {
     uint16_t shutdown_value = (0x5 << 10) | (1 << 13);
     
     // 等待一下让用户看到消息
-    for (volatile int i = 0; i < 5000000; i++);
+    mdelay(100);
     
     // 尝试所有已知的地址
     for (int i = 0; i < 4; i++) {
@@ -123,7 +124,7 @@ void acpi_shutdown(void) {
         __asm__ volatile ("outw %0, %1" : : "a" (shutdown_value), "Nd" (pm1a_addresses[i]));
         
         // 等待关机生效
-        for (volatile int i = 0; i < 1000000; i++);
+        mdelay(10);
     }
     
     print_string("[SHUTDOWN] ACPI shutdown command sent.\n");
@@ -137,13 +138,13 @@ void legacy_shutdown(void) {
     print_string("[SHUTDOWN] Trying QEMU exit device port 0x501...\n");
     outb(0x501, 0x00);  // QEMU会识别这个端口并退出
     
-    for (volatile int i = 0; i < 100000; i++);
+    mdelay(1);
     
     // 方法2: 通过Bochs/QEMU magic exit (0x8900)
     print_string("[SHUTDOWN] Trying Bochs magic exit...\n");
     outw(0x8900, 0x2000);
     
-    for (volatile int i = 0; i < 100000; i++);
+    mdelay(1);
     
     // 方法3: CF9端口关机
     print_string("[SHUTDOWN] CF9 port: attempting system power off...\n");
@@ -155,7 +156,7 @@ void legacy_shutdown(void) {
     
     outb(0xCF9, 0x00);
     
-    for (volatile int i = 0; i < 100000; i++);
+    mdelay(1);
     
     // 方法4: 通过8042键盘控制器的另一种方式
     print_string("[SHUTDOWN] Trying 8042 keyboard controller...\n");
@@ -166,7 +167,7 @@ void legacy_shutdown(void) {
     if (timeout > 0) {
         // 尝试通过键盘控制器执行关机相关操作
         outb(0x64, 0xAA);  // 8042自测命令
-        for (volatile int i = 0; i < 100000; i++);
+        mdelay(1);
     }
     
     print_string("[SHUTDOWN] Legacy method completed.\n");
@@ -182,11 +183,11 @@ void shutdown_system(void) {
     
     // 策略1: 直接尝试QEMU poweroff (port 0x604)
     print_string("[SHUTDOWN] Attempting direct QEMU poweroff (port 0x604)...\n");
-    for (volatile int i = 0; i < 1000000; i++);
+    mdelay(10);
     
     // QEMU ACPI shutdown - 写入ACPI Power Control Register
     outw(0x604, 0x0600);  // S5 sleep type
-    for (volatile int i = 0; i < 1000000; i++);
+    mdelay(10);
     
     // 策略2: ACPI关机
     acpi_shutdown();
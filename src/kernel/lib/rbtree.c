@@ -0,0 +1,231 @@
+// Boruix OS 红黑树实现
+// 叶子用NULL表示，删除修复时单独跟踪被替换位置的父节点
+
+#include "kernel/rbtree.h"
+
+static inline bool is_black(const rb_node_t* node) {
+    return node == NULL || node->color == RB_BLACK;
+}
+
+static void rotate_left(rb_node_t* x, rb_node_t** root) {
+    rb_node_t* y = x->right;
+    x->right = y->left;
+    if (y->left) {
+        y->left->parent = x;
+    }
+    y->parent = x->parent;
+    if (!x->parent) {
+        *root = y;
+    } else if (x == x->parent->left) {
+        x->parent->left = y;
+    } else {
+        x->parent->right = y;
+    }
+    y->left = x;
+    x->parent = y;
+}
+
+static void rotate_right(rb_node_t* x, rb_node_t** root) {
+    rb_node_t* y = x->left;
+    x->left = y->right;
+    if (y->right) {
+        y->right->parent = x;
+    }
+    y->parent = x->parent;
+    if (!x->parent) {
+        *root = y;
+    } else if (x == x->parent->right) {
+        x->parent->right = y;
+    } else {
+        x->parent->left = y;
+    }
+    y->right = x;
+    x->parent = y;
+}
+
+static void insert_fixup(rb_node_t* z, rb_node_t** root) {
+    rb_node_t* p;
+    while ((p = z->parent) != NULL && p->color == RB_RED) {
+        // 父节点为红则一定不是根，祖父存在
+        rb_node_t* g = p->parent;
+        if (p == g->left) {
+            rb_node_t* u = g->right;
+            if (!is_black(u)) {
+                p->color = RB_BLACK;
+                u->color = RB_BLACK;
+                g->color = RB_RED;
+                z = g;
+                continue;
+            }
+            if (z == p->right) {
+                rotate_left(p, root);
+                z = p;
+                p = z->parent;
+            }
+            p->color = RB_BLACK;
+            g->color = RB_RED;
+            rotate_right(g, root);
+        } else {
+            rb_node_t* u = g->left;
+            if (!is_black(u)) {
+                p->color = RB_BLACK;
+                u->color = RB_BLACK;
+                g->color = RB_RED;
+                z = g;
+                continue;
+            }
+            if (z == p->left) {
+                rotate_right(p, root);
+                z = p;
+                p = z->parent;
+            }
+            p->color = RB_BLACK;
+            g->color = RB_RED;
+            rotate_left(g, root);
+        }
+    }
+    (*root)->color = RB_BLACK;
+}
+
+void rb_insert_color_cached(rb_node_t* node, rb_root_cached_t* root, bool leftmost) {
+    if (leftmost) {
+        root->leftmost = node;
+    }
+    insert_fixup(node, &root->root);
+}
+
+// 用v替换u在父节点中的位置
+static void transplant(rb_node_t* u, rb_node_t* v, rb_node_t** root) {
+    if (!u->parent) {
+        *root = v;
+    } else if (u == u->parent->left) {
+        u->parent->left = v;
+    } else {
+        u->parent->right = v;
+    }
+    if (v) {
+        v->parent = u->parent;
+    }
+}
+
+static void erase_fixup(rb_node_t* x, rb_node_t* parent, rb_node_t** root) {
+    while (x != *root && is_black(x)) {
+        if (x == parent->left) {
+            rb_node_t* w = parent->right;
+            if (!is_black(w)) {
+                w->color = RB_BLACK;
+                parent->color = RB_RED;
+                rotate_left(parent, root);
+                w = parent->right;
+            }
+            if (is_black(w->left) && is_black(w->right)) {
+                w->color = RB_RED;
+                x = parent;
+                parent = x->parent;
+            } else {
+                if (is_black(w->right)) {
+                    w->left->color = RB_BLACK;
+                    w->color = RB_RED;
+                    rotate_right(w, root);
+                    w = parent->right;
+                }
+                w->color = parent->color;
+                parent->color = RB_BLACK;
+                w->right->color = RB_BLACK;
+                rotate_left(parent, root);
+                x = *root;
+            }
+        } else {
+            rb_node_t* w = parent->left;
+            if (!is_black(w)) {
+                w->color = RB_BLACK;
+                parent->color = RB_RED;
+                rotate_right(parent, root);
+                w = parent->left;
+            }
+            if (is_black(w->right) && is_black(w->left)) {
+                w->color = RB_RED;
+                x = parent;
+                parent = x->parent;
+            } else {
+                if (is_black(w->left)) {
+                    w->right->color = RB_BLACK;
+                    w->color = RB_RED;
+                    rotate_left(w, root);
+                    w = parent->left;
+                }
+                w->color = parent->color;
+                parent->color = RB_BLACK;
+                w->left->color = RB_BLACK;
+                rotate_right(parent, root);
+                x = *root;
+            }
+        }
+    }
+    if (x) {
+        x->color = RB_BLACK;
+    }
+}
+
+void rb_erase_cached(rb_node_t* z, rb_root_cached_t* root) {
+    if (root->leftmost == z) {
+        root->leftmost = rb_next(z);
+    }
+
+    rb_node_t** tree = &root->root;
+    rb_node_t* x;
+    rb_node_t* x_parent;
+    int removed_color = z->color;
+
+    if (!z->left) {
+        x = z->right;
+        x_parent = z->parent;
+        transplant(z, z->right, tree);
+    } else if (!z->right) {
+        x = z->left;
+        x_parent = z->parent;
+        transplant(z, z->left, tree);
+    } else {
+        // 两个子节点：用右子树的最小节点y顶替z
+        rb_node_t* y = z->right;
+        while (y->left) {
+            y = y->left;
+        }
+        removed_color = y->color;
+        x = y->right;
+        if (y->parent == z) {
+            x_parent = y;
+        } else {
+            x_parent = y->parent;
+            transplant(y, y->right, tree);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        transplant(z, y, tree);
+        y->left = z->left;
+        y->left->parent = y;
+        y->color = z->color;
+    }
+
+    if (removed_color == RB_BLACK) {
+        erase_fixup(x, x_parent, tree);
+    }
+
+    z->parent = NULL;
+    z->left = NULL;
+    z->right = NULL;
+}
+
+rb_node_t* rb_next(const rb_node_t* node) {
+    if (node->right) {
+        node = node->right;
+        while (node->left) {
+            node = node->left;
+        }
+        return (rb_node_t*)node;
+    }
+    while (node->parent && node == node->parent->right) {
+        node = node->parent;
+    }
+    return node->parent;
+}
@@ -0,0 +1,253 @@
+// Boruix OS 锁原语实现
+// 统计数据在持有锁时更新，由锁本身保护；lockstat关闭时快速路径只有一次原子操作
+
+#include "kernel/spinlock.h"
+#include "kernel/interrupt.h"
+#include "arch/x86_64.h"
+
+static volatile uint32_t lockstat_on = 0;
+static lockstat_t* volatile lockstat_list = NULL;
+
+static inline void cpu_relax(void) {
+    __asm__ volatile("pause" : : : "memory");
+}
+
+static inline int lockstat_active(lockstat_t* stat) {
+    return stat != NULL && lockstat_on;
+}
+
+// 第一次统计时加入链表（无锁头插，记录只增不删）
+static void lockstat_register(lockstat_t* stat) {
+    if (__atomic_exchange_n(&stat->registered, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    lockstat_t* head = __atomic_load_n(&lockstat_list, __ATOMIC_RELAXED);
+    do {
+        stat->next = head;
+    } while (!__atomic_compare_exchange_n(&lockstat_list, &head, stat, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// 获得锁后调用，wait_start为0表示第一次尝试就获得了锁
+static void lockstat_acquired(lockstat_t* stat, uint64_t wait_start) {
+    uint64_t now = cpu_rdtsc();
+    lockstat_register(stat);
+    stat->acquisitions++;
+    if (wait_start) {
+        uint64_t wait = now - wait_start;
+        stat->contentions++;
+        stat->wait_cycles += wait;
+        if (wait > stat->wait_max) {
+            stat->wait_max = wait;
+        }
+    }
+    stat->acquired_at = now;
+}
+
+// 释放锁前调用；获取时lockstat未打开则acquired_at为0，不计持有时间
+static void lockstat_released(lockstat_t* stat) {
+    if (stat == NULL || stat->acquired_at == 0) {
+        return;
+    }
+    uint64_t held = cpu_rdtsc() - stat->acquired_at;
+    stat->acquired_at = 0;
+    stat->hold_cycles += held;
+    if (held > stat->hold_max) {
+        stat->hold_max = held;
+    }
+}
+
+// ---- 自旋锁 ----
+
+void spin_lock_init(spinlock_t* lock, lockstat_t* stat) {
+    lock->locked = 0;
+    lock->reserved = 0;
+    lock->stat = stat;
+}
+
+void spin_lock(spinlock_t* lock) {
+    if (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) == 0) {
+        if (lockstat_active(lock->stat)) {
+            lockstat_acquired(lock->stat, 0);
+        }
+        return;
+    }
+
+    // 等待期间只读，锁释放后再尝试交换，避免持续写同一缓存行
+    uint64_t start = lockstat_active(lock->stat) ? cpu_rdtsc() : 0;
+    do {
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)) {
+            cpu_relax();
+        }
+    } while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0);
+
+    if (lockstat_active(lock->stat)) {
+        lockstat_acquired(lock->stat, start);
+    }
+}
+
+void spin_unlock(spinlock_t* lock) {
+    lockstat_released(lock->stat);
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+int spin_trylock(spinlock_t* lock) {
+    if (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED) ||
+        __atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0) {
+        return 0;
+    }
+    if (lockstat_active(lock->stat)) {
+        lockstat_acquired(lock->stat, 0);
+    }
+    return 1;
+}
+
+int spin_is_locked(spinlock_t* lock) {
+    return __atomic_load_n(&lock->locked, __ATOMIC_RELAXED) != 0;
+}
+
+uint64_t spin_lock_irqsave(spinlock_t* lock) {
+    uint64_t flags = irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+void spin_unlock_irqrestore(spinlock_t* lock, uint64_t flags) {
+    spin_unlock(lock);
+    irq_restore(flags);
+}
+
+// ---- 票据锁 ----
+
+void ticket_lock_init(ticket_lock_t* lock, lockstat_t* stat) {
+    lock->next = 0;
+    lock->owner = 0;
+    lock->stat = stat;
+}
+
+void ticket_lock(ticket_lock_t* lock) {
+    uint32_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) == ticket) {
+        if (lockstat_active(lock->stat)) {
+            lockstat_acquired(lock->stat, 0);
+        }
+        return;
+    }
+
+    uint64_t start = lockstat_active(lock->stat) ? cpu_rdtsc() : 0;
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        cpu_relax();
+    }
+
+    if (lockstat_active(lock->stat)) {
+        lockstat_acquired(lock->stat, start);
+    }
+}
+
+void ticket_unlock(ticket_lock_t* lock) {
+    lockstat_released(lock->stat);
+    // 只有持有者修改owner，普通读即可
+    __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t ticket_lock_irqsave(ticket_lock_t* lock) {
+    uint64_t flags = irq_save();
+    ticket_lock(lock);
+    return flags;
+}
+
+void ticket_unlock_irqrestore(ticket_lock_t* lock, uint64_t flags) {
+    ticket_unlock(lock);
+    irq_restore(flags);
+}
+
+// ---- MCS锁 ----
+
+void mcs_lock_init(mcs_lock_t* lock, lockstat_t* stat) {
+    lock->tail = NULL;
+    lock->stat = stat;
+}
+
+void mcs_lock(mcs_lock_t* lock, mcs_node_t* node) {
+    node->next = NULL;
+    node->locked = 1;
+
+    mcs_node_t* prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (prev == NULL) {
+        if (lockstat_active(lock->stat)) {
+            lockstat_acquired(lock->stat, 0);
+        }
+        return;
+    }
+
+    // 挂到前一个等待者后面，在自己的节点上自旋直到被交接
+    uint64_t start = lockstat_active(lock->stat) ? cpu_rdtsc() : 0;
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+        cpu_relax();
+    }
+
+    if (lockstat_active(lock->stat)) {
+        lockstat_acquired(lock->stat, start);
+    }
+}
+
+void mcs_unlock(mcs_lock_t* lock, mcs_node_t* node) {
+    lockstat_released(lock->stat);
+
+    mcs_node_t* next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    if (next == NULL) {
+        // 没有后继：尾指针仍是自己则直接释放
+        mcs_node_t* expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        // 后继已交换了尾指针但还没链接到本节点，等待链接完成
+        while ((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == NULL) {
+            cpu_relax();
+        }
+    }
+    __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+uint64_t mcs_lock_irqsave(mcs_lock_t* lock, mcs_node_t* node) {
+    uint64_t flags = irq_save();
+    mcs_lock(lock, node);
+    return flags;
+}
+
+void mcs_unlock_irqrestore(mcs_lock_t* lock, mcs_node_t* node, uint64_t flags) {
+    mcs_unlock(lock, node);
+    irq_restore(flags);
+}
+
+// ---- lockstat ----
+
+void lockstat_enable(int enable) {
+    __atomic_store_n(&lockstat_on, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+int lockstat_is_enabled(void) {
+    return lockstat_on != 0;
+}
+
+// 不清除acquired_at：正被持有的锁释放时仍能正确计算持有时间
+void lockstat_reset(void) {
+    for (lockstat_t* s = lockstat_first(); s; s = lockstat_next(s)) {
+        s->acquisitions = 0;
+        s->contentions = 0;
+        s->wait_cycles = 0;
+        s->wait_max = 0;
+        s->hold_cycles = 0;
+        s->hold_max = 0;
+    }
+}
+
+lockstat_t* lockstat_first(void) {
+    return __atomic_load_n(&lockstat_list, __ATOMIC_ACQUIRE);
+}
+
+lockstat_t* lockstat_next(lockstat_t* stat) {
+    return stat ? stat->next : NULL;
+}
@@ -42,6 +42,8 @@ pub const USER_VIRTUAL_BASE: u64 = 0x0000000000400000;
 pub const USER_VIRTUAL_END: u64 = 0x00007FFFFFFFFFFF;
 pub const KERNEL_HEAP_START: u64 = 0xFFFFFFFF90000000;
 pub const KERNEL_HEAP_END: u64 = 0xFFFFFFFFA0000000;
+pub const KERNEL_MMIO_START: u64 = 0xFFFFFFFFA0000000;
+pub const KERNEL_MMIO_END: u64 = 0xFFFFFFFFB0000000;
 
 /// 页表项结构
 #[repr(transparent)]
@@ -242,6 +244,43 @@ pub mod cpu {
     pub unsafe fn set_cr3(cr3: u64) {
         core::arch::asm!("mov cr3, {}", in(reg) cr3, options(nostack, preserves_flags));
     }
+
+    /// 获取CR4寄存器值
+    pub unsafe fn get_cr4() -> u64 {
+        let cr4: u64;
+        core::arch::asm!("mov {}, cr4", out(reg) cr4, options(nostack, preserves_flags));
+        cr4
+    }
+
+    /// 设置CR4寄存器值
+    pub unsafe fn set_cr4(cr4: u64) {
+        core::arch::asm!("mov cr4, {}", in(reg) cr4, options(nostack, preserves_flags));
+    }
+
+    /// 读取MSR
+    pub unsafe fn rdmsr(msr: u32) -> u64 {
+        let low: u32;
+        let high: u32;
+        core::arch::asm!("rdmsr", in("ecx") msr, out("eax") low, out("edx") high,
+                         options(nostack, preserves_flags));
+        ((high as u64) << 32) | (low as u64)
+    }
+
+    /// 写入MSR
+    pub unsafe fn wrmsr(msr: u32, value: u64) {
+        core::arch::asm!("wrmsr", in("ecx") msr, in("eax") value as u32, in("edx") (value >> 32) as u32,
+                         options(nostack, preserves_flags));
+    }
+
+    /// 回写并失效全部缓存
+    pub unsafe fn wbinvd() {
+        core::arch::asm!("wbinvd", options(nostack, preserves_flags));
+    }
+
+    /// 查询CPUID leaf 1的EDX特性位
+    pub fn cpuid_features_edx() -> u32 {
+        unsafe { core::arch::x86_64::__cpuid(1).edx }
+    }
 }
 
 /// 地址转换工具
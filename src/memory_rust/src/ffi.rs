@@ -53,6 +53,22 @@ pub extern "C" fn rust_set_hhdm_offset(offset: u64) {
     hhdm::set_offset(offset);
 }
 
+/// 登记Limine在HHDM中映射的物理范围（用于虚拟地址转换快速路径）
+/// 返回0成功，-1失败（范围非法或范围表已满，该范围只是不走快速路径）
+#[no_mangle]
+pub extern "C" fn rust_hhdm_add_range(phys_base: u64, length: u64) -> i32 {
+    match hhdm::add_linear_range(phys_base, length) {
+        Ok(()) => 0,
+        Err(_) => -1,
+    }
+}
+
+/// 设置内核映像位置（用于虚拟地址转换快速路径）
+#[no_mangle]
+pub extern "C" fn rust_set_kernel_image(phys_base: u64, virt_base: u64, size: u64) {
+    hhdm::set_kernel_image(phys_base, virt_base, size);
+}
+
 /// 获取HHDM偏移量（C FFI）
 #[no_mangle]
 pub extern "C" fn rust_get_hhdm_offset() -> u64 {
@@ -120,6 +136,7 @@ pub extern "C" fn rust_kmalloc(size: usize) -> *mut u8 {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -163,6 +180,7 @@ pub extern "C" fn rust_kfree(ptr_arg: *mut u8) {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -193,6 +211,7 @@ pub extern "C" fn rust_alloc_page() -> u64 {
     serial_log!("rust_alloc_page() called");
     
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -225,6 +244,7 @@ pub extern "C" fn rust_free_page(page_addr: u64) {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => return,
@@ -245,6 +265,7 @@ pub extern "C" fn rust_map_page(virtual_addr: u64, physical_addr: u64, flags: u6
     use crate::paging::PAGE_PRESENT;
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -289,6 +310,7 @@ pub extern "C" fn rust_unmap_page(virtual_addr: u64) -> u64 {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -308,8 +330,11 @@ pub extern "C" fn rust_unmap_page(virtual_addr: u64) -> u64 {
 
     let virt = VirtAddr::new(virtual_addr);
 
+    // 变空的页表页面归还给物理分配器
+    let free_frame = |frame: PhysFrame| manager.physical_allocator.deallocate_frame(frame);
+
     // 执行取消映射
-    match page_table_manager.unmap_page(virt) {
+    match page_table_manager.unmap_page_and_reclaim(virt, free_frame) {
         Ok(phys) => phys.as_u64(),  // 返回物理地址
         Err(_e) => {
             serial_log!("ERROR: Failed to unmap page");
@@ -328,7 +353,15 @@ pub extern "C" fn rust_virt_to_phys(virtual_addr: u64) -> u64 {
         return 0;
     }
 
+    let virt = VirtAddr::new(virtual_addr);
+
+    // 快速路径：HHDM和内核映像区域直接计算
+    if let Some(phys) = hhdm::fast_virt_to_phys(virt) {
+        return phys.as_u64();
+    }
+
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => return 0,
@@ -340,8 +373,6 @@ pub extern "C" fn rust_virt_to_phys(virtual_addr: u64) -> u64 {
         None => return 0,
     };
 
-    let virt = VirtAddr::new(virtual_addr);
-
     // 执行地址转换
     match page_table_manager.translate(virt) {
         Ok(phys) => phys.as_u64(),
@@ -349,6 +380,77 @@ pub extern "C" fn rust_virt_to_phys(virtual_addr: u64) -> u64 {
     }
 }
 
+/// C兼容的分散/聚集段
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct CSgEntry {
+    pub phys_addr: u64,
+    pub length: u64,
+}
+
+/// 将虚拟地址范围转换为物理连续段列表
+/// 物理上相邻的页面合并为同一段
+/// 返回段数，失败（未映射或段数组不足）返回-1
+#[no_mangle]
+pub extern "C" fn rust_virt_range_to_sg(
+    virtual_addr: u64,
+    length: u64,
+    sg_out: *mut CSgEntry,
+    max_entries: usize,
+) -> i64 {
+    use crate::arch::addr::VirtAddr;
+
+    if length == 0 || sg_out.is_null() || max_entries == 0 {
+        return -1;
+    }
+
+    let virt = VirtAddr::new(virtual_addr);
+    let sg = unsafe { slice::from_raw_parts_mut(sg_out, max_entries) };
+
+    // 快速路径：整个范围位于HHDM或内核映像内，只有一段
+    if let Some(phys) = hhdm::fast_range_to_phys(virt, length) {
+        sg[0] = CSgEntry { phys_addr: phys.as_u64(), length };
+        return 1;
+    }
+
+    // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
+        Some(m) => m,
+        None => return -1,
+    };
+
+    // 获取页表管理器
+    let page_table_manager = match manager.page_table_manager.as_ref() {
+        Some(ptm) => ptm,
+        None => return -1,
+    };
+
+    // 一次遍历，合并物理相邻的块
+    let mut count = 0usize;
+    let result = page_table_manager.translate_range(virt, length, |phys, chunk| {
+        let phys = phys.as_u64();
+        if count > 0 {
+            let last = &mut sg[count - 1];
+            if last.phys_addr + last.length == phys {
+                last.length += chunk;
+                return true;
+            }
+        }
+        if count >= max_entries {
+            return false;
+        }
+        sg[count] = CSgEntry { phys_addr: phys, length: chunk };
+        count += 1;
+        true
+    });
+
+    match result {
+        Ok(()) => count as i64,
+        Err(_) => -1,
+    }
+}
+
 /// C兼容的内存摘要结构
 #[repr(C)]
 #[derive(Clone, Copy)]
@@ -371,6 +473,7 @@ pub extern "C" fn rust_memory_summary(summary: *mut CMemorySummary) -> i32 {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
         Some(m) => m,
         None => {
@@ -405,6 +508,11 @@ pub extern "C" fn rust_memory_summary(summary: *mut CMemorySummary) -> i32 {
         0
     };
 
+    let page_table_pages = manager
+        .page_table_manager
+        .as_ref()
+        .map_or(0, |ptm| ptm.table_pages());
+
     unsafe {
         (*summary) = CMemorySummary {
             total_physical_mb: total_mb as u64,
@@ -412,7 +520,7 @@ pub extern "C" fn rust_memory_summary(summary: *mut CMemorySummary) -> i32 {
             free_physical_mb: free_mb as u64,
             heap_used_kb: 0,  // 阶段2: 堆未初始化
             heap_free_kb: 0,
-            page_tables_count: 0,
+            page_tables_count: page_table_pages,
             usage_percent: usage,
         };
     }
@@ -420,6 +528,16 @@ pub extern "C" fn rust_memory_summary(summary: *mut CMemorySummary) -> i32 {
     0
 }
 
+/// 获取当前使用中的页表页面数（本管理器分配的PDPT/PD/PT）
+#[no_mangle]
+pub extern "C" fn rust_page_table_pages() -> usize {
+    let _guard = crate::MEMORY_LOCK.lock();
+    match unsafe { crate::MEMORY_MANAGER.as_ref() } {
+        Some(m) => m.page_table_manager.as_ref().map_or(0, |ptm| ptm.table_pages()),
+        None => 0,
+    }
+}
+
 /// 检查内存完整性
 /// 阶段2: 总是返回正常
 #[no_mangle]
@@ -455,6 +573,7 @@ pub extern "C" fn rust_vmm_allocate(size: u64) -> u64 {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -492,6 +611,7 @@ pub extern "C" fn rust_vmm_map_and_allocate(size: u64, out_virt_addr: *mut u64)
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -538,6 +658,7 @@ pub extern "C" fn rust_vmm_get_heap_usage(used: *mut u64, total: *mut u64) {
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
         Some(m) => m,
         None => {
@@ -568,6 +689,104 @@ pub extern "C" fn rust_vmm_get_heap_usage(used: *mut u64, total: *mut u64) {
     }
 }
 
+/// 将物理MMIO区域映射到内核MMIO窗口
+/// cache_mode: 0=回写, 1=写合并, 2=不可缓存
+/// 返回虚拟地址（保留页内偏移），失败返回0
+#[no_mangle]
+pub extern "C" fn rust_vmm_map_mmio(phys_addr: u64, size: u64, cache_mode: u32) -> u64 {
+    use crate::arch::addr::PhysAddr;
+    use crate::vmm::VmmFlags;
+    use core::cell::RefCell;
+
+    if size == 0 {
+        return 0;
+    }
+
+    // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
+        Some(m) => m,
+        None => {
+            serial_log!("ERROR: Memory manager not initialized");
+            return 0;
+        }
+    };
+
+    // 获取VMM和页表管理器
+    let (vmm, page_table) = match (&mut manager.vmm, &mut manager.page_table_manager) {
+        (Some(v), Some(pt)) => (v, pt),
+        _ => {
+            serial_log!("ERROR: VMM or page table manager not initialized");
+            return 0;
+        }
+    };
+
+    // 根据缓存模式创建标志（可写、不可执行）
+    let flags = match cache_mode {
+        0 => VmmFlags::new().writable(),
+        1 => VmmFlags::new().writable().write_combining(),
+        2 => VmmFlags::new().writable().uncached(),
+        _ => {
+            serial_log!("ERROR: Invalid MMIO cache mode");
+            return 0;
+        }
+    };
+
+    // 分配页表页面与回滚时回收页表共用物理分配器
+    let physical = RefCell::new(&mut manager.physical_allocator);
+    let alloc_frame = || physical.borrow_mut().allocate_frame();
+    let free_frame = |frame: PhysFrame| physical.borrow_mut().deallocate_frame(frame);
+
+    match vmm.map_mmio(page_table, PhysAddr::new(phys_addr), size, flags, alloc_frame, free_frame) {
+        Ok(virt_addr) => virt_addr.as_u64(),
+        Err(_e) => {
+            serial_log!("ERROR: Failed to map MMIO region");
+            0
+        }
+    }
+}
+
+/// 取消rust_vmm_map_mmio建立的映射，并把地址段归还MMIO窗口
+/// virt_addr与size须与映射时一致，成功返回0，失败返回-1
+#[no_mangle]
+pub extern "C" fn rust_vmm_unmap_mmio(virt_addr: u64, size: u64) -> i32 {
+    use crate::arch::addr::VirtAddr;
+
+    if virt_addr == 0 || size == 0 {
+        return -1;
+    }
+
+    // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
+        Some(m) => m,
+        None => {
+            serial_log!("ERROR: Memory manager not initialized");
+            return -1;
+        }
+    };
+
+    // 获取VMM和页表管理器
+    let (vmm, page_table) = match (&mut manager.vmm, &mut manager.page_table_manager) {
+        (Some(v), Some(pt)) => (v, pt),
+        _ => {
+            serial_log!("ERROR: VMM or page table manager not initialized");
+            return -1;
+        }
+    };
+
+    // 变空的页表页面归还给物理分配器
+    let free_frame = |frame: PhysFrame| manager.physical_allocator.deallocate_frame(frame);
+
+    match vmm.unmap_mmio(page_table, VirtAddr::new(virt_addr), size, free_frame) {
+        Ok(()) => 0,
+        Err(_e) => {
+            serial_log!("ERROR: Failed to unmap MMIO region");
+            -1
+        }
+    }
+}
+
 /// 获取堆统计信息
 #[no_mangle]
 pub extern "C" fn rust_heap_stats(
@@ -583,6 +802,7 @@ pub extern "C" fn rust_heap_stats(
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
         Some(m) => m,
         None => {
@@ -622,6 +842,128 @@ pub extern "C" fn rust_heap_stats(
     }
 }
 
+// ============================================================================
+// 每CPU初始化 FFI 接口
+// ============================================================================
+
+/// 在应用处理器上设置与BSP一致的PAT和全局页
+/// 每个AP启动时调用一次(BSP在rust_memory_init中完成)
+#[no_mangle]
+pub extern "C" fn rust_cpu_init() {
+    let _ = crate::paging::init_pat();
+    let _ = crate::paging::enable_global_pages();
+}
+
+// ============================================================================
+// 内核栈 FFI 接口
+// ============================================================================
+
+/// 分配带保护页的内核栈
+/// 返回栈顶地址，失败返回0
+#[no_mangle]
+pub extern "C" fn rust_kstack_alloc(pages: u64) -> u64 {
+    use core::cell::RefCell;
+
+    // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
+        Some(m) => m,
+        None => {
+            serial_log!("ERROR: Memory manager not initialized");
+            return 0;
+        }
+    };
+
+    // 获取VMM和页表管理器
+    let (vmm, page_table) = match (&mut manager.vmm, &mut manager.page_table_manager) {
+        (Some(v), Some(pt)) => (v, pt),
+        _ => {
+            serial_log!("ERROR: VMM or page table manager not initialized");
+            return 0;
+        }
+    };
+
+    // 分配与回滚共用物理分配器
+    let physical = RefCell::new(&mut manager.physical_allocator);
+    let alloc_frame = || physical.borrow_mut().allocate_frame();
+    let free_frame = |frame: PhysFrame| physical.borrow_mut().deallocate_frame(frame);
+
+    match manager.kstack_allocator.allocate(vmm, page_table, pages, alloc_frame, free_frame) {
+        Ok(top) => top.as_u64(),
+        Err(_e) => {
+            serial_log!("ERROR: Failed to allocate kernel stack");
+            0
+        }
+    }
+}
+
+/// 释放内核栈
+#[no_mangle]
+pub extern "C" fn rust_kstack_free(stack_top: u64) {
+    use crate::arch::addr::VirtAddr;
+
+    if stack_top == 0 {
+        return;
+    }
+
+    // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
+        Some(m) => m,
+        None => return,
+    };
+
+    // 获取VMM和页表管理器
+    let (vmm, page_table) = match (&mut manager.vmm, &mut manager.page_table_manager) {
+        (Some(v), Some(pt)) => (v, pt),
+        _ => return,
+    };
+
+    let free_frame = |frame: PhysFrame| manager.physical_allocator.deallocate_frame(frame);
+
+    if let Err(_e) = manager.kstack_allocator.free(vmm, page_table, VirtAddr::new(stack_top), free_frame) {
+        serial_log!("ERROR: Failed to free kernel stack");
+    }
+}
+
+/// 检查地址是否落在内核栈保护页中（用于缺页/双重错误时识别栈溢出）
+#[no_mangle]
+pub extern "C" fn rust_kstack_is_guard_page(addr: u64) -> bool {
+    use crate::arch::addr::VirtAddr;
+    use crate::kstack::KernelStackAllocator;
+
+    // 不获取MEMORY_LOCK：缺页可能发生在持有锁期间，这里只读区域表
+    let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
+        Some(m) => m,
+        None => return false,
+    };
+
+    match manager.vmm.as_ref() {
+        Some(vmm) => KernelStackAllocator::is_guard_page(vmm, VirtAddr::new(addr)),
+        None => false,
+    }
+}
+
+/// 获取内核栈统计信息
+#[no_mangle]
+pub extern "C" fn rust_kstack_stats(in_use: *mut usize, cached: *mut usize, cache_hits: *mut usize) {
+    if in_use.is_null() || cached.is_null() || cache_hits.is_null() {
+        return;
+    }
+
+    let _guard = crate::MEMORY_LOCK.lock();
+    let (used, free, hits) = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
+        Some(m) => m.kstack_allocator.stats(),
+        None => (0, 0, 0),
+    };
+
+    unsafe {
+        *in_use = used;
+        *cached = free;
+        *cache_hits = hits;
+    }
+}
+
 // ============================================================================
 // 内存保护 FFI 接口
 // ============================================================================
@@ -633,6 +975,7 @@ pub extern "C" fn rust_set_page_readonly(virt_addr: u64) -> i32 {
     use crate::protection::ProtectionManager;
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -668,6 +1011,7 @@ pub extern "C" fn rust_set_page_readwrite(virt_addr: u64) -> i32 {
     use crate::protection::ProtectionManager;
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -703,6 +1047,7 @@ pub extern "C" fn rust_set_page_no_execute(virt_addr: u64) -> i32 {
     use crate::protection::ProtectionManager;
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_mut() } {
         Some(m) => m,
         None => {
@@ -749,6 +1094,7 @@ pub extern "C" fn rust_get_page_flags(
     }
 
     // 获取全局内存管理器实例
+    let _guard = crate::MEMORY_LOCK.lock();
     let manager = match unsafe { crate::MEMORY_MANAGER.as_ref() } {
         Some(m) => m,
         None => {
@@ -6,11 +6,113 @@ use core::sync::atomic::{AtomicU64, Ordering};
 
 /// 全局HHDM偏移量
 static HHDM_OFFSET: AtomicU64 = AtomicU64::new(0);
+/// HHDM区域结束地址(偏移量 + CPU支持的最大物理地址)
+static HHDM_END: AtomicU64 = AtomicU64::new(0);
+
+/// Limine在HHDM中实际映射的物理范围(来自内存映射表)，快速路径只信任这些范围，
+/// 空洞和内存顶端之后的地址交给页表遍历，未映射时返回0
+const MAX_LINEAR_RANGES: usize = 64;
+static LINEAR_BASE: [AtomicU64; MAX_LINEAR_RANGES] = [const { AtomicU64::new(0) }; MAX_LINEAR_RANGES];
+static LINEAR_END: [AtomicU64; MAX_LINEAR_RANGES] = [const { AtomicU64::new(0) }; MAX_LINEAR_RANGES];
+static LINEAR_COUNT: AtomicU64 = AtomicU64::new(0);
+
+/// 内核映像的物理/虚拟基址和大小
+static KERNEL_PHYS_BASE: AtomicU64 = AtomicU64::new(0);
+static KERNEL_VIRT_BASE: AtomicU64 = AtomicU64::new(0);
+static KERNEL_IMAGE_SIZE: AtomicU64 = AtomicU64::new(0);
 
 /// 设置HHDM偏移量
 /// 必须在初始化内存管理器之前调用
 pub fn set_offset(offset: u64) {
     HHDM_OFFSET.store(offset, Ordering::SeqCst);
+    HHDM_END.store(offset.saturating_add(max_phys_addr()), Ordering::SeqCst);
+}
+
+/// HHDM最大覆盖范围(4级分页高半区的一半，避免与内核映像/堆/MMIO窗口重叠)
+const HHDM_MAX_BITS: u32 = 46;
+
+/// CPU支持的最大物理地址(CPUID.80000008H:EAX[7:0])
+fn max_phys_addr() -> u64 {
+    let bits = unsafe {
+        if core::arch::x86_64::__cpuid(0x8000_0000).eax >= 0x8000_0008 {
+            core::arch::x86_64::__cpuid(0x8000_0008).eax & 0xFF
+        } else {
+            36
+        }
+    };
+    1u64 << bits.min(HHDM_MAX_BITS)
+}
+
+/// 登记一段HHDM已映射的物理范围(启动时单线程调用)，与上一段相邻时合并
+/// 范围表满时返回Err，未登记的范围只是走慢路径
+pub fn add_linear_range(phys_base: u64, length: u64) -> Result<(), &'static str> {
+    let end = phys_base.checked_add(length).ok_or("Range overflows")?;
+    if length == 0 || end > max_phys_addr() {
+        return Err("Range outside HHDM");
+    }
+
+    let count = LINEAR_COUNT.load(Ordering::Relaxed) as usize;
+    if count > 0 && LINEAR_END[count - 1].load(Ordering::Relaxed) == phys_base {
+        LINEAR_END[count - 1].store(end, Ordering::Release);
+        return Ok(());
+    }
+    if count == MAX_LINEAR_RANGES {
+        return Err("Too many HHDM ranges");
+    }
+    LINEAR_BASE[count].store(phys_base, Ordering::Relaxed);
+    LINEAR_END[count].store(end, Ordering::Relaxed);
+    LINEAR_COUNT.store(count as u64 + 1, Ordering::Release);
+    Ok(())
+}
+
+/// 物理范围[phys, last]是否整体落在某个已登记的HHDM映射范围内
+fn linear_range_mapped(phys: u64, last: u64) -> bool {
+    let count = LINEAR_COUNT.load(Ordering::Acquire) as usize;
+    (0..count).any(|i| {
+        phys >= LINEAR_BASE[i].load(Ordering::Relaxed) && last < LINEAR_END[i].load(Ordering::Acquire)
+    })
+}
+
+/// 设置内核映像位置(Limine内核地址请求提供，映像在物理上连续)
+pub fn set_kernel_image(phys_base: u64, virt_base: u64, size: u64) {
+    KERNEL_PHYS_BASE.store(phys_base, Ordering::SeqCst);
+    KERNEL_VIRT_BASE.store(virt_base, Ordering::SeqCst);
+    KERNEL_IMAGE_SIZE.store(size, Ordering::SeqCst);
+}
+
+/// 查找包含[addr, addr+len)的直接映射区域，返回(虚拟基址, 物理基址)
+fn linear_region(addr: u64, len: u64) -> Option<(u64, u64)> {
+    let last = addr.checked_add(len.max(1) - 1)?;
+
+    let kernel_virt = KERNEL_VIRT_BASE.load(Ordering::Relaxed);
+    let kernel_size = KERNEL_IMAGE_SIZE.load(Ordering::Relaxed);
+    if kernel_size != 0 && addr >= kernel_virt && last - kernel_virt < kernel_size {
+        return Some((kernel_virt, KERNEL_PHYS_BASE.load(Ordering::Relaxed)));
+    }
+
+    let offset = HHDM_OFFSET.load(Ordering::Relaxed);
+    if offset != 0
+        && addr >= offset
+        && last < HHDM_END.load(Ordering::Relaxed)
+        && linear_range_mapped(addr - offset, last - offset)
+    {
+        return Some((offset, 0));
+    }
+
+    None
+}
+
+/// 快速虚拟地址转换：HHDM中已登记的映射范围和内核映像区域直接计算，无需遍历页表
+/// 其他区域(包括HHDM中的空洞)返回None，由调用方遍历页表
+pub fn fast_virt_to_phys(virt_addr: VirtAddr) -> Option<PhysAddr> {
+    fast_range_to_phys(virt_addr, 1)
+}
+
+/// [virt, virt+len)整体位于HHDM或内核映像内时，返回其物理起始地址(物理上连续)
+pub fn fast_range_to_phys(virt_addr: VirtAddr, len: u64) -> Option<PhysAddr> {
+    let addr = virt_addr.as_u64();
+    let (virt_base, phys_base) = linear_region(addr, len)?;
+    Some(PhysAddr::new(phys_base + (addr - virt_base)))
 }
 
 /// 获取HHDM偏移量
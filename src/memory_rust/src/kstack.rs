@@ -0,0 +1,167 @@
+// kstack.rs - 内核栈分配器
+// 从专用虚拟地址窗口分配N页内核栈，每个栈下方保留一个不映射的保护页
+// 释放的栈保持映射并缓存，下次分配相同大小时直接复用
+
+use crate::arch::addr::VirtAddr;
+use crate::lazy_buddy::PhysFrame;
+use crate::paging::PageTableManager;
+use crate::vmm::{VirtualMemoryManager, VmmFlags, VmmRegion, VmmRegionType};
+
+const PAGE_SIZE: u64 = 4096;
+
+/// 内核栈虚拟地址窗口
+pub const KSTACK_WINDOW_START: u64 = 0xFFFFFFFFB0000000;
+pub const KSTACK_WINDOW_END: u64 = 0xFFFFFFFFC0000000;
+
+/// 单个栈最大页数
+pub const KSTACK_MAX_PAGES: u64 = 64;
+
+/// 缓存的空闲栈数量
+const KSTACK_CACHE_SIZE: usize = 16;
+
+/// 缓存的空闲栈
+#[derive(Clone, Copy)]
+struct CachedStack {
+    base: u64,   // 栈底(保护页之上第一个映射页)
+    pages: u64,  // 栈页数
+}
+
+/// 内核栈分配器
+pub struct KernelStackAllocator {
+    cache: [Option<CachedStack>; KSTACK_CACHE_SIZE],
+    stacks_in_use: usize,
+    cache_hits: usize,
+}
+
+impl KernelStackAllocator {
+    pub const fn new() -> Self {
+        Self {
+            cache: [None; KSTACK_CACHE_SIZE],
+            stacks_in_use: 0,
+            cache_hits: 0,
+        }
+    }
+
+    /// 分配pages页的内核栈，返回栈顶地址(16字节对齐)
+    pub fn allocate<F, D>(
+        &mut self,
+        vmm: &mut VirtualMemoryManager,
+        page_table: &mut PageTableManager,
+        pages: u64,
+        mut alloc_frame: F,
+        free_frame: D,
+    ) -> Result<VirtAddr, &'static str>
+    where
+        F: FnMut() -> Option<PhysFrame>,
+        D: FnMut(PhysFrame),
+    {
+        if pages == 0 || pages > KSTACK_MAX_PAGES {
+            return Err("Invalid kernel stack size");
+        }
+
+        // 优先复用缓存中大小相同的栈
+        for slot in self.cache.iter_mut() {
+            if let Some(stack) = *slot {
+                if stack.pages == pages {
+                    *slot = None;
+                    self.stacks_in_use += 1;
+                    self.cache_hits += 1;
+                    return Ok(VirtAddr::new(stack.base + pages * PAGE_SIZE));
+                }
+            }
+        }
+
+        // 在窗口中查找保护页+栈页的连续空闲地址
+        let total = (pages + 1) * PAGE_SIZE;
+        let guard = vmm
+            .find_free_range(total, VirtAddr::new(KSTACK_WINDOW_START), VirtAddr::new(KSTACK_WINDOW_END))
+            .ok_or("Kernel stack window exhausted")?
+            .as_u64();
+        let base = guard + PAGE_SIZE;
+        let top = guard + total;
+
+        // 保护页也登记为区域，防止被其他栈占用，并用于缺页时识别栈溢出
+        vmm.add_region(VmmRegion::new(
+            VirtAddr::new(guard),
+            VirtAddr::new(base),
+            VmmRegionType::GuardPage,
+            VmmFlags::new(),
+        ))?;
+
+        let flags = VmmFlags::new().writable();
+        let stack_region = VmmRegion::new(VirtAddr::new(base), VirtAddr::new(top), VmmRegionType::KernelStack, flags);
+        if let Err(e) = vmm.add_region(stack_region) {
+            vmm.remove_region(VirtAddr::new(guard));
+            return Err(e);
+        }
+
+        if let Err(e) = vmm.map_region(page_table, &stack_region, &mut alloc_frame) {
+            // 撤销已映射的部分
+            let _ = vmm.unmap_region_free(page_table, &stack_region, free_frame);
+            vmm.remove_region(VirtAddr::new(base));
+            vmm.remove_region(VirtAddr::new(guard));
+            return Err(e);
+        }
+
+        self.stacks_in_use += 1;
+        Ok(VirtAddr::new(top))
+    }
+
+    /// 释放栈顶为top的内核栈
+    /// 缓存未满时保留映射，否则取消映射并归还物理页面
+    pub fn free<D>(
+        &mut self,
+        vmm: &mut VirtualMemoryManager,
+        page_table: &mut PageTableManager,
+        top: VirtAddr,
+        free_frame: D,
+    ) -> Result<(), &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
+        let region = *vmm
+            .find_region(VirtAddr::new(top.as_u64() - 1))
+            .ok_or("Not a kernel stack")?;
+        if region.region_type != VmmRegionType::KernelStack || region.end.as_u64() != top.as_u64() {
+            return Err("Not a kernel stack");
+        }
+
+        let base = region.start.as_u64();
+        let pages = region.size() / PAGE_SIZE;
+
+        // 缓存的栈仍保留KernelStack区域，重复释放同一个栈必须在这里拒绝，
+        // 否则它会在缓存中出现两次并被分配给两个使用者
+        if self.cache.iter().any(|slot| matches!(slot, Some(stack) if stack.base == base)) {
+            return Err("Kernel stack already freed");
+        }
+
+        self.stacks_in_use = self.stacks_in_use.saturating_sub(1);
+
+        for slot in self.cache.iter_mut() {
+            if slot.is_none() {
+                *slot = Some(CachedStack { base, pages });
+                return Ok(());
+            }
+        }
+
+        // 缓存已满，真正释放
+        vmm.unmap_region_free(page_table, &region, free_frame)?;
+        vmm.remove_region(VirtAddr::new(base));
+        vmm.remove_region(VirtAddr::new(base - PAGE_SIZE));
+        Ok(())
+    }
+
+    /// 检查地址是否落在某个内核栈的保护页中
+    pub fn is_guard_page(vmm: &VirtualMemoryManager, addr: VirtAddr) -> bool {
+        match vmm.find_region(addr) {
+            Some(region) => region.region_type == VmmRegionType::GuardPage,
+            None => false,
+        }
+    }
+
+    /// 统计信息: (使用中的栈, 缓存的栈, 缓存命中次数)
+    pub fn stats(&self) -> (usize, usize, usize) {
+        let cached = self.cache.iter().filter(|s| s.is_some()).count();
+        (self.stacks_in_use, cached, self.cache_hits)
+    }
+}
@@ -1,9 +1,11 @@
 //! Boruix OS 内存管理系统 - Rust实现
 //! x86_64架构的完整内存管理，包括页表管理、物理内存分配和内核堆
 
-#![no_std]
-#![no_main]
+// 宿主机上运行cargo test时使用std和默认panic处理
+#![cfg_attr(not(test), no_std)]
+#![cfg_attr(not(test), no_main)]
 
+#[cfg(not(test))]
 use core::panic::PanicInfo;
 
 pub mod arch;
@@ -12,8 +14,12 @@ pub mod hhdm;  // HHDM支持
 pub mod lazy_buddy;  // 懒加载伙伴分配器
 pub mod paging;  // 分页管理
 pub mod vmm;  // 虚拟内存管理
+pub mod vma_tree;  // 虚拟内存区域树
 pub mod heap;  // 堆分配器
+pub mod kstack;  // 内核栈分配器
 pub mod protection;  // 内存保护
+pub mod percpu;  // 每CPU数据
+pub mod lock;  // 锁原语绑定
 pub mod stats;
 
 // 导出主要接口
@@ -26,6 +32,10 @@ pub use protection::*;
 /// 全局内存管理器实例
 static mut MEMORY_MANAGER: Option<MemoryManager> = None;
 
+/// 内存管理器锁：FFI入口访问MEMORY_MANAGER前获取（关中断，中断处理程序和其他CPU都不会重入）
+static MEMORY_LOCKSTAT: lock::LockStat = lock::LockStat::new(b"memory_manager\0");
+pub(crate) static MEMORY_LOCK: lock::SpinLock<()> = lock::SpinLock::new((), Some(&MEMORY_LOCKSTAT));
+
 /// 内存管理器主结构
 /// 阶段2E: 添加堆分配器
 pub struct MemoryManager {
@@ -33,6 +43,7 @@ pub struct MemoryManager {
     page_table_manager: Option<paging::PageTableManager>,
     vmm: Option<vmm::VirtualMemoryManager>,
     heap_allocator: Option<heap::HeapAllocator>,
+    kstack_allocator: kstack::KernelStackAllocator,
     stats: stats::MemoryStats,
 }
 
@@ -45,6 +56,7 @@ impl MemoryManager {
             page_table_manager: None,
             vmm: None,
             heap_allocator: None,
+            kstack_allocator: kstack::KernelStackAllocator::new(),
             stats: stats::MemoryStats::new(),
         }
     }
@@ -58,6 +70,10 @@ impl MemoryManager {
         // 初始化页表管理器(使用当前CR3)
         self.page_table_manager = Some(paging::PageTableManager::from_current()?);
 
+        // 设置PAT写合并表项并启用全局页(CPU不支持时保持固件默认设置)
+        let _ = paging::init_pat();
+        let _ = paging::enable_global_pages();
+
         // 初始化虚拟内存管理器
         let mut vmm = vmm::VirtualMemoryManager::new();
         vmm.init()?;
@@ -92,6 +108,7 @@ impl MemoryManager {
 }
 
 /// Panic处理函数
+#[cfg(not(test))]
 #[panic_handler]
 fn panic(_info: &PanicInfo) -> ! {
     loop {}
@@ -0,0 +1,245 @@
+// lock.rs - 锁原语的Rust绑定
+// 实现在C侧(kernel/lib/spinlock.c)，这里镜像结构布局（include/kernel/spinlock.h）并提供守卫：
+// 守卫离开作用域时解锁并恢复中断状态
+
+use core::cell::UnsafeCell;
+use core::ops::{Deref, DerefMut};
+use core::ptr;
+
+/// 每个锁的统计记录（与C侧lockstat_t布局一致）
+#[repr(C)]
+pub struct RawLockStat {
+    name: *const u8,
+    next: *mut RawLockStat,
+    registered: u32,
+    reserved: u32,
+    acquisitions: u64,
+    contentions: u64,
+    wait_cycles: u64,
+    wait_max: u64,
+    hold_cycles: u64,
+    hold_max: u64,
+    acquired_at: u64,
+}
+
+/// 可放在static中的统计记录，name必须以\0结尾
+#[repr(transparent)]
+pub struct LockStat(UnsafeCell<RawLockStat>);
+
+unsafe impl Sync for LockStat {}
+
+impl LockStat {
+    pub const fn new(name: &'static [u8]) -> Self {
+        Self(UnsafeCell::new(RawLockStat {
+            name: name.as_ptr(),
+            next: ptr::null_mut(),
+            registered: 0,
+            reserved: 0,
+            acquisitions: 0,
+            contentions: 0,
+            wait_cycles: 0,
+            wait_max: 0,
+            hold_cycles: 0,
+            hold_max: 0,
+            acquired_at: 0,
+        }))
+    }
+
+    const fn as_ptr(&'static self) -> *mut RawLockStat {
+        self.0.get()
+    }
+}
+
+#[repr(C)]
+pub struct RawSpinLock {
+    locked: u32,
+    reserved: u32,
+    stat: *mut RawLockStat,
+}
+
+#[repr(C)]
+pub struct RawTicketLock {
+    next: u32,
+    owner: u32,
+    stat: *mut RawLockStat,
+}
+
+/// MCS队列节点，加锁期间必须保持在原地（由守卫持有）
+#[repr(C)]
+pub struct McsNode {
+    next: *mut McsNode,
+    locked: u32,
+    reserved: u32,
+}
+
+#[repr(C)]
+pub struct RawMcsLock {
+    tail: *mut McsNode,
+    stat: *mut RawLockStat,
+}
+
+extern "C" {
+    fn spin_lock_irqsave(lock: *mut RawSpinLock) -> u64;
+    fn spin_unlock_irqrestore(lock: *mut RawSpinLock, flags: u64);
+    fn ticket_lock_irqsave(lock: *mut RawTicketLock) -> u64;
+    fn ticket_unlock_irqrestore(lock: *mut RawTicketLock, flags: u64);
+    fn mcs_lock_irqsave(lock: *mut RawMcsLock, node: *mut McsNode) -> u64;
+    fn mcs_unlock_irqrestore(lock: *mut RawMcsLock, node: *mut McsNode, flags: u64);
+}
+
+const fn stat_ptr(stat: Option<&'static LockStat>) -> *mut RawLockStat {
+    match stat {
+        Some(s) => s.as_ptr(),
+        None => ptr::null_mut(),
+    }
+}
+
+/// 关中断的自旋锁，保护T
+pub struct SpinLock<T> {
+    raw: UnsafeCell<RawSpinLock>,
+    data: UnsafeCell<T>,
+}
+
+unsafe impl<T: Send> Sync for SpinLock<T> {}
+unsafe impl<T: Send> Send for SpinLock<T> {}
+
+pub struct SpinLockGuard<'a, T> {
+    lock: &'a SpinLock<T>,
+    flags: u64,
+}
+
+impl<T> SpinLock<T> {
+    pub const fn new(data: T, stat: Option<&'static LockStat>) -> Self {
+        Self {
+            raw: UnsafeCell::new(RawSpinLock { locked: 0, reserved: 0, stat: stat_ptr(stat) }),
+            data: UnsafeCell::new(data),
+        }
+    }
+
+    pub fn lock(&self) -> SpinLockGuard<'_, T> {
+        let flags = unsafe { spin_lock_irqsave(self.raw.get()) };
+        SpinLockGuard { lock: self, flags }
+    }
+}
+
+impl<T> Deref for SpinLockGuard<'_, T> {
+    type Target = T;
+    fn deref(&self) -> &T {
+        unsafe { &*self.lock.data.get() }
+    }
+}
+
+impl<T> DerefMut for SpinLockGuard<'_, T> {
+    fn deref_mut(&mut self) -> &mut T {
+        unsafe { &mut *self.lock.data.get() }
+    }
+}
+
+impl<T> Drop for SpinLockGuard<'_, T> {
+    fn drop(&mut self) {
+        unsafe { spin_unlock_irqrestore(self.lock.raw.get(), self.flags) };
+    }
+}
+
+/// 关中断的票据锁，按到达顺序获得
+pub struct TicketLock<T> {
+    raw: UnsafeCell<RawTicketLock>,
+    data: UnsafeCell<T>,
+}
+
+unsafe impl<T: Send> Sync for TicketLock<T> {}
+unsafe impl<T: Send> Send for TicketLock<T> {}
+
+pub struct TicketLockGuard<'a, T> {
+    lock: &'a TicketLock<T>,
+    flags: u64,
+}
+
+impl<T> TicketLock<T> {
+    pub const fn new(data: T, stat: Option<&'static LockStat>) -> Self {
+        Self {
+            raw: UnsafeCell::new(RawTicketLock { next: 0, owner: 0, stat: stat_ptr(stat) }),
+            data: UnsafeCell::new(data),
+        }
+    }
+
+    pub fn lock(&self) -> TicketLockGuard<'_, T> {
+        let flags = unsafe { ticket_lock_irqsave(self.raw.get()) };
+        TicketLockGuard { lock: self, flags }
+    }
+}
+
+impl<T> Deref for TicketLockGuard<'_, T> {
+    type Target = T;
+    fn deref(&self) -> &T {
+        unsafe { &*self.lock.data.get() }
+    }
+}
+
+impl<T> DerefMut for TicketLockGuard<'_, T> {
+    fn deref_mut(&mut self) -> &mut T {
+        unsafe { &mut *self.lock.data.get() }
+    }
+}
+
+impl<T> Drop for TicketLockGuard<'_, T> {
+    fn drop(&mut self) {
+        unsafe { ticket_unlock_irqrestore(self.lock.raw.get(), self.flags) };
+    }
+}
+
+/// 关中断的MCS锁，等待者各自在守卫内的节点上自旋
+pub struct McsLock<T> {
+    raw: UnsafeCell<RawMcsLock>,
+    data: UnsafeCell<T>,
+}
+
+unsafe impl<T: Send> Sync for McsLock<T> {}
+unsafe impl<T: Send> Send for McsLock<T> {}
+
+/// 守卫持有队列节点，节点地址在解锁前不能改变，因此由调用者提供节点存储
+pub struct McsLockGuard<'a, T> {
+    lock: &'a McsLock<T>,
+    node: &'a mut McsNode,
+    flags: u64,
+}
+
+impl McsNode {
+    pub const fn new() -> Self {
+        Self { next: ptr::null_mut(), locked: 0, reserved: 0 }
+    }
+}
+
+impl<T> McsLock<T> {
+    pub const fn new(data: T, stat: Option<&'static LockStat>) -> Self {
+        Self {
+            raw: UnsafeCell::new(RawMcsLock { tail: ptr::null_mut(), stat: stat_ptr(stat) }),
+            data: UnsafeCell::new(data),
+        }
+    }
+
+    /// `let mut node = McsNode::new(); let guard = lock.lock(&mut node);`
+    pub fn lock<'a>(&'a self, node: &'a mut McsNode) -> McsLockGuard<'a, T> {
+        let flags = unsafe { mcs_lock_irqsave(self.raw.get(), node) };
+        McsLockGuard { lock: self, node, flags }
+    }
+}
+
+impl<T> Deref for McsLockGuard<'_, T> {
+    type Target = T;
+    fn deref(&self) -> &T {
+        unsafe { &*self.lock.data.get() }
+    }
+}
+
+impl<T> DerefMut for McsLockGuard<'_, T> {
+    fn deref_mut(&mut self) -> &mut T {
+        unsafe { &mut *self.lock.data.get() }
+    }
+}
+
+impl<T> Drop for McsLockGuard<'_, T> {
+    fn drop(&mut self) {
+        unsafe { mcs_unlock_irqrestore(self.lock.raw.get(), self.node, self.flags) };
+    }
+}
@@ -16,6 +16,80 @@ pub const PAGE_DIRTY: u64 = 1 << 6;        // 已修改(仅1GB/2MB/4KB页)
 pub const PAGE_HUGE: u64 = 1 << 7;         // 大页(2MB/1GB)
 pub const PAGE_GLOBAL: u64 = 1 << 8;       // 全局页
 pub const PAGE_NO_EXECUTE: u64 = 1 << 63;  // 不可执行(需要NXE支持)
+pub const PAGE_PAT: u64 = 1 << 7;          // PAT索引高位(仅4KB页，与PAGE_HUGE同位)
+pub const PAGE_TABLE_OWNED: u64 = 1 << 9;  // 下级页表由本管理器分配(AVL位，仅中间级表项)
+
+// 下级页表有效表项计数，保存在中间级表项的忽略位52-61中
+const TABLE_COUNT_SHIFT: u64 = 52;
+const TABLE_COUNT_MASK: u64 = 0x3FF << TABLE_COUNT_SHIFT;
+
+// 缓存模式对应的页表位组合(PAT/PCD/PWT三位选择PAT表项)
+// PAT表布局与Limine保持一致: PA0=WB PA1=WT PA2=UC- PA3=UC PA4=WP PA5=WC
+pub const PAGE_CACHE_WB: u64 = 0;                                         // PA0 回写
+pub const PAGE_CACHE_UC: u64 = PAGE_CACHE_DISABLE | PAGE_WRITE_THROUGH;   // PA3 不可缓存
+pub const PAGE_CACHE_WC: u64 = PAGE_PAT | PAGE_WRITE_THROUGH;             // PA5 写合并
+pub const PAGE_CACHE_MASK: u64 = PAGE_PAT | PAGE_CACHE_DISABLE | PAGE_WRITE_THROUGH;
+
+// 内核半区起始地址(该地址以上的映射为所有地址空间共享，可标记为全局页)
+pub const KERNEL_HALF_START: u64 = 0xFFFF_8000_0000_0000;
+
+// PAT相关常量
+const IA32_PAT_MSR: u32 = 0x277;
+const PAT_UC: u64 = 0x00;        // 不可缓存
+const PAT_WC: u64 = 0x01;        // 写合并
+const PAT_WT: u64 = 0x04;        // 写穿透
+const PAT_WP: u64 = 0x05;        // 写保护
+const PAT_WB: u64 = 0x06;        // 回写
+const PAT_UC_MINUS: u64 = 0x07;  // 弱不可缓存
+const PAT_VALUE: u64 = PAT_WB
+    | (PAT_WT << 8)
+    | (PAT_UC_MINUS << 16)
+    | (PAT_UC << 24)
+    | (PAT_WP << 32)
+    | (PAT_WC << 40)
+    | (PAT_UC_MINUS << 48)
+    | (PAT_UC << 56);
+
+// CPUID.01H:EDX 特性位
+const CPUID_EDX_PGE: u32 = 1 << 13;
+const CPUID_EDX_PAT: u32 = 1 << 16;
+const CR4_PGE: u64 = 1 << 7;
+
+/// 编程PAT MSR，使PA5为写合并
+/// 每个CPU都需要调用一次(各CPU的PAT必须一致)
+pub fn init_pat() -> Result<(), &'static str> {
+    use crate::arch::cpu;
+
+    if cpu::cpuid_features_edx() & CPUID_EDX_PAT == 0 {
+        return Err("PAT not supported");
+    }
+
+    unsafe {
+        // 修改PAT前先回写缓存，修改后刷新TLB，避免残留旧的内存类型
+        cpu::wbinvd();
+        cpu::wrmsr(IA32_PAT_MSR, PAT_VALUE);
+        cpu::wbinvd();
+        cpu::flush_all_tlb();
+    }
+    Ok(())
+}
+
+/// 启用全局页(CR4.PGE)，切换CR3时保留内核半区的TLB项
+pub fn enable_global_pages() -> Result<(), &'static str> {
+    use crate::arch::cpu;
+
+    if cpu::cpuid_features_edx() & CPUID_EDX_PGE == 0 {
+        return Err("PGE not supported");
+    }
+
+    unsafe {
+        let cr4 = cpu::get_cr4();
+        if cr4 & CR4_PGE == 0 {
+            cpu::set_cr4(cr4 | CR4_PGE);
+        }
+    }
+    Ok(())
+}
 
 // 页表索引相关常量
 const PAGE_SIZE: u64 = 4096;
@@ -79,6 +153,21 @@ impl PageTableEntry {
     pub fn clear(&mut self) {
         self.entry = 0;
     }
+
+    // 下级页表是否由本管理器分配(只有这类页表的计数可信，可以回收)
+    pub fn is_owned_table(&self) -> bool {
+        self.is_present() && !self.is_huge() && self.entry & PAGE_TABLE_OWNED != 0
+    }
+
+    // 获取下级页表的有效表项数
+    pub fn table_count(&self) -> u64 {
+        (self.entry & TABLE_COUNT_MASK) >> TABLE_COUNT_SHIFT
+    }
+
+    // 设置下级页表的有效表项数
+    fn set_table_count(&mut self, count: u64) {
+        self.entry = (self.entry & !TABLE_COUNT_MASK) | ((count << TABLE_COUNT_SHIFT) & TABLE_COUNT_MASK);
+    }
 }
 
 impl PageTable {
@@ -119,6 +208,8 @@ impl PageTable {
 pub struct PageTableManager {
     // CR3寄存器值(PML4物理地址)
     pml4_addr: PhysAddr,
+    // 本管理器分配的中间级页表页数(PDPT/PD/PT，不含PML4)
+    table_pages: usize,
 }
 
 impl PageTableManager {
@@ -129,7 +220,7 @@ impl PageTableManager {
             core::arch::asm!("mov {}, cr3", out(reg) cr3);
         }
         let pml4_addr = PhysAddr::new(cr3 & ENTRY_MASK);
-        Ok(PageTableManager { pml4_addr })
+        Ok(PageTableManager { pml4_addr, table_pages: 0 })
     }
 
     // 创建新的页表(分配新的PML4)
@@ -148,7 +239,7 @@ impl PageTableManager {
             (*pml4_ptr).zero_entries();
         }
 
-        Ok(PageTableManager { pml4_addr })
+        Ok(PageTableManager { pml4_addr, table_pages: 0 })
     }
 
     // 获取PML4物理地址
@@ -156,6 +247,11 @@ impl PageTableManager {
         self.pml4_addr
     }
 
+    // 获取本管理器分配的中间级页表页数
+    pub fn table_pages(&self) -> usize {
+        self.table_pages
+    }
+
     // 加载此页表到CR3
     pub unsafe fn load(&self) {
         core::arch::asm!("mov cr3, {}", in(reg) self.pml4_addr.as_u64());
@@ -173,18 +269,22 @@ impl PageTableManager {
     }
 
     // 获取或创建下一级页表
+    // 返回下级页表指针以及是否新建(新建时所在页表的有效表项数加一)
     fn get_or_create_next_table<F>(
         entry: &mut PageTableEntry,
         alloc_frame: &mut F,
-    ) -> Result<*mut PageTable, &'static str>
+    ) -> Result<(*mut PageTable, bool), &'static str>
     where
         F: FnMut() -> Option<PhysFrame>,
     {
         if entry.is_present() {
+            if entry.is_huge() {
+                return Err("Address covered by huge page");
+            }
             // 页表已存在
             let phys = entry.phys_addr().ok_or("Invalid page table entry")?;
             let virt = hhdm::phys_to_virt(phys);
-            Ok(virt.as_u64() as *mut PageTable)
+            Ok((virt.as_u64() as *mut PageTable, false))
         } else {
             // 需要创建新页表
             let frame = alloc_frame().ok_or("Failed to allocate page table frame")?;
@@ -197,13 +297,24 @@ impl PageTableManager {
                 (*table_ptr).zero_entries();
             }
 
-            // 设置页表项(存在、可写)
-            entry.set(phys, PAGE_PRESENT | PAGE_WRITABLE);
+            // 设置页表项(存在、可写、由本管理器分配，计数从0开始)
+            entry.set(phys, PAGE_PRESENT | PAGE_WRITABLE | PAGE_TABLE_OWNED);
 
-            Ok(table_ptr)
+            Ok((table_ptr, true))
         }
     }
 
+    // 调整下级页表的有效表项计数(仅对本管理器分配的页表)
+    fn adjust_table_count(entry: &mut PageTableEntry, increment: bool) -> u64 {
+        if !entry.is_owned_table() {
+            return u64::MAX;
+        }
+        let count = entry.table_count();
+        let count = if increment { count + 1 } else { count.saturating_sub(1) };
+        entry.set_table_count(count);
+        count
+    }
+
     // 映射页面
     pub fn map_page<F>(
         &mut self,
@@ -229,24 +340,45 @@ impl PageTableManager {
 
         // PML4 -> PDPT
         let pml4_entry = unsafe { (*current_table).get_entry_mut(indices[0]).unwrap() };
-        current_table = Self::get_or_create_next_table(pml4_entry, &mut alloc_frame)?;
+        let (pdpt, created) = Self::get_or_create_next_table(pml4_entry, &mut alloc_frame)?;
+        if created {
+            self.table_pages += 1;
+        }
+        current_table = pdpt;
 
         // PDPT -> PD
         let pdpt_entry = unsafe { (*current_table).get_entry_mut(indices[1]).unwrap() };
-        current_table = Self::get_or_create_next_table(pdpt_entry, &mut alloc_frame)?;
+        let (pd, created) = Self::get_or_create_next_table(pdpt_entry, &mut alloc_frame)?;
+        if created {
+            self.table_pages += 1;
+            Self::adjust_table_count(pml4_entry, true);
+        }
+        current_table = pd;
 
         // PD -> PT
         let pd_entry = unsafe { (*current_table).get_entry_mut(indices[2]).unwrap() };
-        current_table = Self::get_or_create_next_table(pd_entry, &mut alloc_frame)?;
+        let (pt, created) = Self::get_or_create_next_table(pd_entry, &mut alloc_frame)?;
+        if created {
+            self.table_pages += 1;
+            Self::adjust_table_count(pdpt_entry, true);
+        }
+        current_table = pt;
 
         // PT -> Page
         let pt_entry = unsafe { (*current_table).get_entry_mut(indices[3]).unwrap() };
         if pt_entry.is_present() {
             return Err("Page already mapped");
         }
+        Self::adjust_table_count(pd_entry, true);
+
+        // 内核半区的内核页面标记为全局页
+        let mut flags = flags | PAGE_PRESENT;
+        if virt.as_u64() >= KERNEL_HALF_START && flags & PAGE_USER == 0 {
+            flags |= PAGE_GLOBAL;
+        }
 
         // 设置最终页面映射
-        pt_entry.set(phys, flags | PAGE_PRESENT);
+        pt_entry.set(phys, flags);
 
         // 刷新TLB
         unsafe {
@@ -257,7 +389,31 @@ impl PageTableManager {
     }
 
     // 取消映射页面
+    // 只维护页表计数，不回收变空的页表(调用方随后可能在同一地址重新映射)
     pub fn unmap_page(&mut self, virt: VirtAddr) -> Result<PhysAddr, &'static str> {
+        self.unmap_page_inner(virt, None::<&mut fn(PhysFrame)>)
+    }
+
+    // 取消映射页面，并把变空的PT/PD/PDPT页面交给free_frame回收
+    pub fn unmap_page_and_reclaim<D>(
+        &mut self,
+        virt: VirtAddr,
+        mut free_frame: D,
+    ) -> Result<PhysAddr, &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
+        self.unmap_page_inner(virt, Some(&mut free_frame))
+    }
+
+    fn unmap_page_inner<D>(
+        &mut self,
+        virt: VirtAddr,
+        mut free_frame: Option<&mut D>,
+    ) -> Result<PhysAddr, &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
         // 检查地址对齐
         if virt.as_u64() % PAGE_SIZE != 0 {
             return Err("Address not page aligned");
@@ -266,29 +422,29 @@ impl PageTableManager {
         // 获取页表索引
         let indices = Self::get_page_table_indices(virt);
 
-        // 遍历页表层级
+        // 遍历页表层级，记录指向各级下级页表的表项
         let pml4_virt = hhdm::phys_to_virt(self.pml4_addr);
-        let pml4 = unsafe { &*(pml4_virt.as_u64() as *const PageTable) };
+        let pml4 = unsafe { &mut *(pml4_virt.as_u64() as *mut PageTable) };
 
         // PML4 -> PDPT
-        let pml4_entry = pml4.get_entry(indices[0]).unwrap();
+        let pml4_entry = pml4.get_entry_mut(indices[0]).unwrap();
         if !pml4_entry.is_present() {
             return Err("PDPT not present");
         }
         let pdpt_virt = hhdm::phys_to_virt(pml4_entry.phys_addr().unwrap());
-        let pdpt = unsafe { &*(pdpt_virt.as_u64() as *const PageTable) };
+        let pdpt = unsafe { &mut *(pdpt_virt.as_u64() as *mut PageTable) };
 
         // PDPT -> PD
-        let pdpt_entry = pdpt.get_entry(indices[1]).unwrap();
-        if !pdpt_entry.is_present() {
+        let pdpt_entry = pdpt.get_entry_mut(indices[1]).unwrap();
+        if !pdpt_entry.is_present() || pdpt_entry.is_huge() {
             return Err("PD not present");
         }
         let pd_virt = hhdm::phys_to_virt(pdpt_entry.phys_addr().unwrap());
-        let pd = unsafe { &*(pd_virt.as_u64() as *const PageTable) };
+        let pd = unsafe { &mut *(pd_virt.as_u64() as *mut PageTable) };
 
         // PD -> PT
-        let pd_entry = pd.get_entry(indices[2]).unwrap();
-        if !pd_entry.is_present() {
+        let pd_entry = pd.get_entry_mut(indices[2]).unwrap();
+        if !pd_entry.is_present() || pd_entry.is_huge() {
             return Err("PT not present");
         }
         let pt_virt = hhdm::phys_to_virt(pd_entry.phys_addr().unwrap());
@@ -303,7 +459,31 @@ impl PageTableManager {
         let phys = pt_entry.phys_addr().unwrap();
         pt_entry.clear();
 
-        // 刷新TLB
+        // 自底向上更新计数，回收变空的页表
+        // 内核半区的PDPT被所有地址空间共享，始终保留
+        let kernel_half = virt.as_u64() >= KERNEL_HALF_START;
+        let parents: [*mut PageTableEntry; 3] = [pml4_entry, pdpt_entry, pd_entry];
+        for level in (0..3).rev() {
+            let entry = unsafe { &mut *parents[level] };
+            let count = Self::adjust_table_count(entry, false);
+            if count != 0 {
+                break;
+            }
+            let free = match free_frame.as_mut() {
+                Some(f) => f,
+                None => break,
+            };
+            if level == 0 && kernel_half {
+                break;
+            }
+
+            let table_phys = entry.phys_addr().unwrap();
+            entry.clear();
+            free(PhysFrame::from_start_address(table_phys));
+            self.table_pages = self.table_pages.saturating_sub(1);
+        }
+
+        // 刷新TLB(invlpg同时使该地址相关的分页结构缓存失效)
         unsafe {
             core::arch::asm!("invlpg [{}]", in(reg) virt.as_u64());
         }
@@ -355,6 +535,94 @@ impl PageTableManager {
         Ok(PhysAddr::new(page_phys.as_u64() + offset))
     }
 
+    // 批量转换虚拟地址范围，按页(或大页)依次调用emit(物理地址, 长度)
+    // 同一PT内的连续页面复用上次找到的PT，不再从PML4重新遍历
+    // emit返回false时停止并返回错误
+    pub fn translate_range<F>(&self, virt: VirtAddr, len: u64, mut emit: F) -> Result<(), &'static str>
+    where
+        F: FnMut(PhysAddr, u64) -> bool,
+    {
+        const SIZE_2M: u64 = 0x20_0000;
+        const SIZE_1G: u64 = 0x4000_0000;
+
+        let mut addr = virt.as_u64();
+        let end = addr.checked_add(len).ok_or("Address range overflow")?;
+
+        let pml4_virt = hhdm::phys_to_virt(self.pml4_addr);
+        let pml4 = unsafe { &*(pml4_virt.as_u64() as *const PageTable) };
+
+        // 当前缓存的PT及其覆盖的2MB区域基址
+        let mut cached_pt: *const PageTable = core::ptr::null();
+        let mut cached_base = u64::MAX;
+
+        while addr < end {
+            let indices = Self::get_page_table_indices(VirtAddr::new(addr));
+
+            if addr & !(SIZE_2M - 1) != cached_base {
+                // PML4 -> PDPT
+                let pml4_entry = pml4.get_entry(indices[0]).unwrap();
+                if !pml4_entry.is_present() {
+                    return Err("PDPT not present");
+                }
+                let pdpt_virt = hhdm::phys_to_virt(pml4_entry.phys_addr().unwrap());
+                let pdpt = unsafe { &*(pdpt_virt.as_u64() as *const PageTable) };
+
+                // PDPT -> PD (1GB大页直接输出)
+                let pdpt_entry = pdpt.get_entry(indices[1]).unwrap();
+                if !pdpt_entry.is_present() {
+                    return Err("PD not present");
+                }
+                if pdpt_entry.is_huge() {
+                    let offset = addr & (SIZE_1G - 1);
+                    let phys = (pdpt_entry.phys_addr().unwrap().as_u64() & !(SIZE_1G - 1)) + offset;
+                    let chunk = (SIZE_1G - offset).min(end - addr);
+                    if !emit(PhysAddr::new(phys), chunk) {
+                        return Err("Segment buffer full");
+                    }
+                    addr += chunk;
+                    continue;
+                }
+                let pd_virt = hhdm::phys_to_virt(pdpt_entry.phys_addr().unwrap());
+                let pd = unsafe { &*(pd_virt.as_u64() as *const PageTable) };
+
+                // PD -> PT (2MB大页直接输出)
+                let pd_entry = pd.get_entry(indices[2]).unwrap();
+                if !pd_entry.is_present() {
+                    return Err("PT not present");
+                }
+                if pd_entry.is_huge() {
+                    let offset = addr & (SIZE_2M - 1);
+                    let phys = (pd_entry.phys_addr().unwrap().as_u64() & !(SIZE_2M - 1)) + offset;
+                    let chunk = (SIZE_2M - offset).min(end - addr);
+                    if !emit(PhysAddr::new(phys), chunk) {
+                        return Err("Segment buffer full");
+                    }
+                    addr += chunk;
+                    continue;
+                }
+                let pt_virt = hhdm::phys_to_virt(pd_entry.phys_addr().unwrap());
+                cached_pt = pt_virt.as_u64() as *const PageTable;
+                cached_base = addr & !(SIZE_2M - 1);
+            }
+
+            // PT -> Page
+            let pt = unsafe { &*cached_pt };
+            let pt_entry = pt.get_entry(indices[3]).unwrap();
+            if !pt_entry.is_present() {
+                return Err("Page not mapped");
+            }
+
+            let offset = addr & (PAGE_SIZE - 1);
+            let chunk = (PAGE_SIZE - offset).min(end - addr);
+            if !emit(PhysAddr::new(pt_entry.phys_addr().unwrap().as_u64() + offset), chunk) {
+                return Err("Segment buffer full");
+            }
+            addr += chunk;
+        }
+
+        Ok(())
+    }
+
     // 获取页面的标志位
     pub fn get_page_flags(&self, virt: VirtAddr) -> Result<u64, &'static str> {
         // 检查地址对齐
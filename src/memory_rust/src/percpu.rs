@@ -0,0 +1,156 @@
+// percpu.rs - 每CPU数据访问
+// 与C侧的percpu_t（include/arch/percpu.h）布局一致，IA32_GS_BASE指向本CPU的页
+// 访问宏展开为单条gs相对指令，在本CPU上不会被中断打断
+
+/// 中断优先级最大嵌套深度（与IRQ_MAX_NESTING一致）
+pub const IRQ_MAX_NESTING: usize = 8;
+
+/// 每CPU数据（字段顺序和类型必须与C侧percpu_t相同）
+#[repr(C)]
+pub struct PerCpu {
+    pub this: *mut PerCpu,
+    pub cpu: u32,
+    pub apic_id: u32,
+    pub irq_stack_top: u64,
+    pub irq_stack_nesting: u64,
+    pub irq_depth: u32,
+    pub interrupt_nesting: u32,
+    pub interrupt_level: u8,
+    pub level_stack: [u8; IRQ_MAX_NESTING],
+    pub interrupt_counts: [u64; 256],
+    pub softirq_pending: u32,
+    pub softirq_active: u32,
+    pub tasklet_head: [*mut core::ffi::c_void; 2],
+    pub tasklet_tail: [*mut core::ffi::c_void; 2],
+}
+
+// 与isr.asm和C侧约定的偏移
+const _: () = assert!(core::mem::offset_of!(PerCpu, irq_stack_top) == 16);
+const _: () = assert!(core::mem::offset_of!(PerCpu, irq_stack_nesting) == 24);
+const _: () = assert!(core::mem::offset_of!(PerCpu, interrupt_counts) == 56);
+
+/// 可按gs相对地址访问的字段类型，OFF为字段在PerCpu中的偏移
+pub trait PerCpuValue: Copy {
+    /// # Safety
+    /// OFF必须是PerCpu中该类型字段的偏移，且GS基址已指向每CPU页
+    unsafe fn gs_read<const OFF: usize>() -> Self;
+    /// # Safety
+    /// 同gs_read
+    unsafe fn gs_write<const OFF: usize>(value: Self);
+    /// # Safety
+    /// 同gs_read
+    unsafe fn gs_inc<const OFF: usize>();
+}
+
+macro_rules! impl_percpu_value {
+    ($ty:ty, $class:ident, $v:literal, $size:literal) => {
+        impl PerCpuValue for $ty {
+            #[inline(always)]
+            unsafe fn gs_read<const OFF: usize>() -> Self {
+                let value: $ty;
+                core::arch::asm!(
+                    concat!("mov ", $v, ", ", $size, " ptr gs:[{off}]"),
+                    v = out($class) value, off = const OFF,
+                    options(nostack, preserves_flags, readonly)
+                );
+                value
+            }
+
+            #[inline(always)]
+            unsafe fn gs_write<const OFF: usize>(value: Self) {
+                core::arch::asm!(
+                    concat!("mov ", $size, " ptr gs:[{off}], ", $v),
+                    v = in($class) value, off = const OFF,
+                    options(nostack, preserves_flags)
+                );
+            }
+
+            #[inline(always)]
+            unsafe fn gs_inc<const OFF: usize>() {
+                core::arch::asm!(
+                    concat!("inc ", $size, " ptr gs:[{off}]"),
+                    off = const OFF,
+                    options(nostack)
+                );
+            }
+        }
+    };
+}
+
+impl_percpu_value!(u8, reg_byte, "{v}", "byte");
+impl_percpu_value!(u32, reg, "{v:e}", "dword");
+impl_percpu_value!(u64, reg, "{v:r}", "qword");
+
+/// 字段类型推断辅助：只用于让编译器从闭包返回类型推出字段类型
+#[doc(hidden)]
+#[inline(always)]
+pub fn __field_type<T, F: FnOnce(&PerCpu) -> T>(_f: F) -> core::marker::PhantomData<T> {
+    core::marker::PhantomData
+}
+
+#[doc(hidden)]
+#[inline(always)]
+pub unsafe fn __read<T: PerCpuValue, const OFF: usize>(_t: core::marker::PhantomData<T>) -> T {
+    T::gs_read::<OFF>()
+}
+
+#[doc(hidden)]
+#[inline(always)]
+pub unsafe fn __write<T: PerCpuValue, const OFF: usize>(_t: core::marker::PhantomData<T>, value: T) {
+    T::gs_write::<OFF>(value)
+}
+
+#[doc(hidden)]
+#[inline(always)]
+pub unsafe fn __inc<T: PerCpuValue, const OFF: usize>(_t: core::marker::PhantomData<T>) {
+    T::gs_inc::<OFF>()
+}
+
+/// 读取本CPU的字段：`this_cpu_read!(cpu)`
+#[macro_export]
+macro_rules! this_cpu_read {
+    ($field:ident) => {
+        unsafe {
+            $crate::percpu::__read::<_, { core::mem::offset_of!($crate::percpu::PerCpu, $field) }>(
+                $crate::percpu::__field_type(|p: &$crate::percpu::PerCpu| p.$field),
+            )
+        }
+    };
+}
+
+/// 写入本CPU的字段：`this_cpu_write!(irq_depth, 0)`
+#[macro_export]
+macro_rules! this_cpu_write {
+    ($field:ident, $value:expr) => {
+        unsafe {
+            $crate::percpu::__write::<_, { core::mem::offset_of!($crate::percpu::PerCpu, $field) }>(
+                $crate::percpu::__field_type(|p: &$crate::percpu::PerCpu| p.$field),
+                $value,
+            )
+        }
+    };
+}
+
+/// 本CPU字段加1（单条inc指令）：`this_cpu_inc!(irq_depth)`
+#[macro_export]
+macro_rules! this_cpu_inc {
+    ($field:ident) => {
+        unsafe {
+            $crate::percpu::__inc::<_, { core::mem::offset_of!($crate::percpu::PerCpu, $field) }>(
+                $crate::percpu::__field_type(|p: &$crate::percpu::PerCpu| p.$field),
+            )
+        }
+    };
+}
+
+/// 当前CPU的逻辑编号（0为BSP）
+#[inline(always)]
+pub fn current_cpu() -> u32 {
+    this_cpu_read!(cpu)
+}
+
+/// 本CPU每CPU页的指针
+#[inline(always)]
+pub fn this_cpu_ptr() -> *mut PerCpu {
+    unsafe { u64::gs_read::<{ core::mem::offset_of!(PerCpu, this) }>() as *mut PerCpu }
+}
@@ -0,0 +1,575 @@
+// vma_tree.rs - 虚拟内存区域AVL树
+// 以起始地址为键，节点增广子树最小起始地址、最大结束地址和最大空隙
+// 支持O(log n)的查找、插入、删除和空隙查找
+
+use crate::vmm::VmmRegion;
+
+/// 节点池容量(所有区域树共享)
+pub const VMA_MAX_NODES: usize = 4096;
+
+// 空节点索引
+const NIL: u32 = u32::MAX;
+
+/// 树节点
+#[derive(Clone, Copy)]
+struct VmaNode {
+    region: VmmRegion,
+    left: u32,
+    right: u32,
+    height: u8,
+    min_start: u64, // 子树最小起始地址
+    max_end: u64,   // 子树最大结束地址
+    max_gap: u64,   // 子树内相邻区域之间的最大空隙
+}
+
+impl VmaNode {
+    const fn empty() -> Self {
+        Self {
+            region: VmmRegion::empty(),
+            left: NIL,
+            right: NIL,
+            height: 0,
+            min_start: 0,
+            max_end: 0,
+            max_gap: 0,
+        }
+    }
+}
+
+// 节点池：先按顺序使用未分配节点，释放的节点通过left字段串成空闲链表
+static mut NODE_POOL: [VmaNode; VMA_MAX_NODES] = [VmaNode::empty(); VMA_MAX_NODES];
+static mut POOL_NEXT_UNUSED: u32 = 0;
+static mut POOL_FREE_HEAD: u32 = NIL;
+
+fn node(index: u32) -> &'static mut VmaNode {
+    unsafe { &mut *core::ptr::addr_of_mut!(NODE_POOL[index as usize]) }
+}
+
+fn alloc_node(region: VmmRegion) -> Option<u32> {
+    let index = unsafe {
+        if POOL_FREE_HEAD != NIL {
+            let index = POOL_FREE_HEAD;
+            POOL_FREE_HEAD = node(index).left;
+            index
+        } else if (POOL_NEXT_UNUSED as usize) < VMA_MAX_NODES {
+            let index = POOL_NEXT_UNUSED;
+            POOL_NEXT_UNUSED += 1;
+            index
+        } else {
+            return None;
+        }
+    };
+
+    let n = node(index);
+    *n = VmaNode::empty();
+    n.region = region;
+    n.height = 1;
+    n.min_start = region.start.as_u64();
+    n.max_end = region.end.as_u64();
+    Some(index)
+}
+
+fn free_node(index: u32) {
+    unsafe {
+        node(index).left = POOL_FREE_HEAD;
+        POOL_FREE_HEAD = index;
+    }
+}
+
+fn height(index: u32) -> u8 {
+    if index == NIL { 0 } else { node(index).height }
+}
+
+// 重新计算节点高度和增广信息
+fn update(index: u32) {
+    let n = *node(index);
+    let start = n.region.start.as_u64();
+    let end = n.region.end.as_u64();
+
+    let mut min_start = start;
+    let mut max_end = end;
+    let mut max_gap = 0;
+
+    if n.left != NIL {
+        let l = node(n.left);
+        min_start = l.min_start;
+        max_gap = max_gap.max(l.max_gap).max(start - l.max_end);
+    }
+    if n.right != NIL {
+        let r = node(n.right);
+        max_end = r.max_end;
+        max_gap = max_gap.max(r.max_gap).max(r.min_start - end);
+    }
+
+    let n = node(index);
+    n.height = 1 + height(n.left).max(height(n.right));
+    n.min_start = min_start;
+    n.max_end = max_end;
+    n.max_gap = max_gap;
+}
+
+fn rotate_right(index: u32) -> u32 {
+    let pivot = node(index).left;
+    node(index).left = node(pivot).right;
+    node(pivot).right = index;
+    update(index);
+    update(pivot);
+    pivot
+}
+
+fn rotate_left(index: u32) -> u32 {
+    let pivot = node(index).right;
+    node(index).right = node(pivot).left;
+    node(pivot).left = index;
+    update(index);
+    update(pivot);
+    pivot
+}
+
+// 更新节点并在失衡时旋转，返回子树新根
+fn rebalance(index: u32) -> u32 {
+    update(index);
+    let n = *node(index);
+    let balance = height(n.left) as i32 - height(n.right) as i32;
+
+    if balance > 1 {
+        let l = node(n.left);
+        if height(l.left) < height(l.right) {
+            node(index).left = rotate_left(n.left);
+        }
+        return rotate_right(index);
+    }
+    if balance < -1 {
+        let r = node(n.right);
+        if height(r.right) < height(r.left) {
+            node(index).right = rotate_right(n.right);
+        }
+        return rotate_left(index);
+    }
+    index
+}
+
+fn insert_at(root: u32, new: u32) -> u32 {
+    if root == NIL {
+        return new;
+    }
+    if node(new).region.start.as_u64() < node(root).region.start.as_u64() {
+        node(root).left = insert_at(node(root).left, new);
+    } else {
+        node(root).right = insert_at(node(root).right, new);
+    }
+    rebalance(root)
+}
+
+// 摘除子树中最小的节点，返回(子树新根, 被摘除的节点)
+fn detach_min(root: u32) -> (u32, u32) {
+    let left = node(root).left;
+    if left == NIL {
+        return (node(root).right, root);
+    }
+    let (new_left, min) = detach_min(left);
+    node(root).left = new_left;
+    (rebalance(root), min)
+}
+
+// 删除起始地址为start的节点，返回(子树新根, 被删除的节点)
+fn remove_at(root: u32, start: u64) -> (u32, u32) {
+    if root == NIL {
+        return (NIL, NIL);
+    }
+
+    let root_start = node(root).region.start.as_u64();
+    if start < root_start {
+        let (new_left, removed) = remove_at(node(root).left, start);
+        node(root).left = new_left;
+        return (rebalance(root), removed);
+    }
+    if start > root_start {
+        let (new_right, removed) = remove_at(node(root).right, start);
+        node(root).right = new_right;
+        return (rebalance(root), removed);
+    }
+
+    let n = *node(root);
+    if n.left == NIL {
+        return (n.right, root);
+    }
+    if n.right == NIL {
+        return (n.left, root);
+    }
+
+    // 用右子树最小节点替换被删除节点
+    let (new_right, successor) = detach_min(n.right);
+    node(successor).left = n.left;
+    node(successor).right = new_right;
+    (rebalance(successor), root)
+}
+
+// 在子树中按地址顺序查找第一个满足条件的空隙
+// prev_end为子树左侧最近区域的结束地址，返回(空隙起始地址, 子树最后的结束地址)
+fn first_fit(root: u32, prev_end: u64, size: u64, limit: u64) -> (Option<u64>, u64) {
+    if root == NIL {
+        return (None, prev_end);
+    }
+
+    let n = *node(root);
+
+    // 剪枝：子树前方空隙和子树内最大空隙都放不下
+    let leading_gap = n.min_start.saturating_sub(prev_end);
+    if leading_gap < size && n.max_gap < size {
+        return (None, prev_end.max(n.max_end));
+    }
+
+    let (found, left_end) = first_fit(n.left, prev_end, size, limit);
+    if found.is_some() {
+        return (found, left_end);
+    }
+
+    let start = n.region.start.as_u64();
+    match left_end.checked_add(size) {
+        Some(end) if end > limit => return (None, left_end),
+        Some(end) if end <= start => return (Some(left_end), left_end),
+        None => return (None, left_end),
+        _ => {}
+    }
+
+    first_fit(n.right, left_end.max(n.region.end.as_u64()), size, limit)
+}
+
+/// 虚拟内存区域树
+pub struct VmaTree {
+    root: u32,
+    count: usize,
+}
+
+impl VmaTree {
+    /// 创建空树
+    pub const fn new() -> Self {
+        Self { root: NIL, count: 0 }
+    }
+
+    /// 区域数量
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    // 查找起始地址小于limit的最后一个区域
+    fn predecessor(&self, limit: u64) -> u32 {
+        let mut current = self.root;
+        let mut result = NIL;
+        while current != NIL {
+            let n = node(current);
+            if n.region.start.as_u64() < limit {
+                result = current;
+                current = n.right;
+            } else {
+                current = n.left;
+            }
+        }
+        result
+    }
+
+    /// 插入区域(与现有区域重叠时失败)
+    pub fn insert(&mut self, region: VmmRegion) -> Result<(), &'static str> {
+        if region.end.as_u64() <= region.start.as_u64() {
+            return Err("Invalid region range");
+        }
+
+        // 区域互不重叠，只需检查起始地址在新区域结束之前的最后一个区域
+        let prev = self.predecessor(region.end.as_u64());
+        if prev != NIL && node(prev).region.overlaps(&region) {
+            return Err("Region overlaps with existing region");
+        }
+
+        let index = alloc_node(region).ok_or("Too many regions")?;
+        self.root = insert_at(self.root, index);
+        self.count += 1;
+        Ok(())
+    }
+
+    /// 删除起始地址为start的区域
+    pub fn remove(&mut self, start: u64) -> Option<VmmRegion> {
+        let (new_root, removed) = remove_at(self.root, start);
+        if removed == NIL {
+            return None;
+        }
+        self.root = new_root;
+        self.count -= 1;
+        let region = node(removed).region;
+        free_node(removed);
+        Some(region)
+    }
+
+    /// 查找包含指定地址的区域
+    pub fn find(&self, addr: u64) -> Option<&'static VmmRegion> {
+        let prev = self.predecessor(addr.checked_add(1)?);
+        if prev == NIL {
+            return None;
+        }
+        let region = &node(prev).region;
+        if region.end.as_u64() > addr {
+            Some(region)
+        } else {
+            None
+        }
+    }
+
+    /// 在[low, high)内查找第一个能容纳size字节的空闲地址
+    pub fn find_gap(&self, size: u64, low: u64, high: u64) -> Option<u64> {
+        if size == 0 || low >= high {
+            return None;
+        }
+
+        // 跳过与low重叠的区域
+        let mut start = low;
+        if let Some(region) = self.find(low) {
+            start = region.end.as_u64();
+        }
+
+        let (found, last_end) = first_fit(self.root, start, size, high);
+        if found.is_some() {
+            return found;
+        }
+
+        // 所有区域之后的空间
+        let candidate = last_end.max(start);
+        match candidate.checked_add(size) {
+            Some(end) if end <= high => Some(candidate),
+            _ => None,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::arch::addr::VirtAddr;
+    use crate::vmm::{VmmFlags, VmmRegionType};
+    use std::sync::Mutex;
+    use std::vec::Vec;
+
+    // 节点池是全局的，测试串行执行
+    static POOL_LOCK: Mutex<()> = Mutex::new(());
+
+    const PAGE: u64 = 4096;
+
+    fn region(start: u64, end: u64) -> VmmRegion {
+        VmmRegion::new(VirtAddr::new(start), VirtAddr::new(end), VmmRegionType::KernelData, VmmFlags::new())
+    }
+
+    // 检查AVL平衡、键有序和增广字段，返回子树高度
+    fn check_subtree(index: u32, low: u64, high: u64) -> u8 {
+        if index == NIL {
+            return 0;
+        }
+        let n = *node(index);
+        let start = n.region.start.as_u64();
+        assert!(start >= low && start < high, "keys out of order");
+
+        let hl = check_subtree(n.left, low, start);
+        let hr = check_subtree(n.right, start, high);
+        assert!((hl as i32 - hr as i32).abs() <= 1, "node out of balance");
+        assert_eq!(n.height, 1 + hl.max(hr), "stale height");
+
+        let min_start = if n.left != NIL { node(n.left).min_start } else { start };
+        let max_end = if n.right != NIL { node(n.right).max_end } else { n.region.end.as_u64() };
+        assert_eq!(n.min_start, min_start, "stale min_start");
+        assert_eq!(n.max_end, max_end, "stale max_end");
+        1 + hl.max(hr)
+    }
+
+    fn check_tree(tree: &VmaTree) {
+        let h = check_subtree(tree.root, 0, u64::MAX);
+        // AVL高度上界约为1.44*log2(n+2)
+        let n = tree.len() as f64;
+        assert!((h as f64) <= 1.45 * (n + 2.0).log2(), "tree too tall: {} for {} nodes", h, tree.len());
+    }
+
+    // 中序收集子树内的区域
+    fn collect(index: u32, out: &mut Vec<(u64, u64)>) {
+        if index == NIL {
+            return;
+        }
+        let n = *node(index);
+        collect(n.left, out);
+        out.push((n.region.start.as_u64(), n.region.end.as_u64()));
+        collect(n.right, out);
+    }
+
+    // 对每个节点暴力计算子树内相邻区域的最大空隙，与max_gap比较
+    fn check_max_gap(index: u32) {
+        if index == NIL {
+            return;
+        }
+        let mut regions = Vec::new();
+        collect(index, &mut regions);
+        let expected = regions.windows(2).map(|w| w[1].0 - w[0].1).max().unwrap_or(0);
+        let n = *node(index);
+        assert_eq!(n.max_gap, expected, "stale max_gap at {:#x}", n.region.start.as_u64());
+        check_max_gap(n.left);
+        check_max_gap(n.right);
+    }
+
+    fn clear(tree: &mut VmaTree) {
+        while tree.root != NIL {
+            let start = node(tree.root).region.start.as_u64();
+            tree.remove(start).unwrap();
+        }
+    }
+
+    #[test]
+    fn stays_balanced_under_adversarial_order() {
+        let _g = POOL_LOCK.lock().unwrap_or_else(|e| e.into_inner());
+        let mut tree = VmaTree::new();
+        let count = 512u64;
+
+        // 升序插入（退化为链表的最坏情况）
+        for i in 0..count {
+            tree.insert(region(i * 2 * PAGE, i * 2 * PAGE + PAGE)).unwrap();
+        }
+        check_tree(&tree);
+        assert_eq!(tree.len(), count as usize);
+
+        // 从最小端删除一半，再从最大端删除一半剩余的
+        for i in 0..count / 2 {
+            assert!(tree.remove(i * 2 * PAGE).is_some());
+            check_tree(&tree);
+        }
+        for i in (count * 3 / 4..count).rev() {
+            assert!(tree.remove(i * 2 * PAGE).is_some());
+            check_tree(&tree);
+        }
+        assert_eq!(tree.len(), (count / 4) as usize);
+        assert!(tree.remove(0).is_none());
+        clear(&mut tree);
+
+        // 降序插入，交替删除
+        for i in (0..count).rev() {
+            tree.insert(region(i * 2 * PAGE, i * 2 * PAGE + PAGE)).unwrap();
+        }
+        check_tree(&tree);
+        for i in (0..count).step_by(2) {
+            assert!(tree.remove(i * 2 * PAGE).is_some());
+        }
+        check_tree(&tree);
+        for i in (1..count).step_by(2) {
+            let addr = i * 2 * PAGE + 10;
+            assert_eq!(tree.find(addr).map(|r| r.start.as_u64()), Some(i * 2 * PAGE));
+            assert!(tree.find(addr - 2 * PAGE).is_none());
+        }
+        clear(&mut tree);
+    }
+
+    #[test]
+    fn max_gap_matches_brute_force() {
+        let _g = POOL_LOCK.lock().unwrap_or_else(|e| e.into_inner());
+        let mut tree = VmaTree::new();
+
+        // 线性同余序列打乱插入顺序，区域长度和间距各不相同
+        let slots = 256u64;
+        let mut seed = 0x2545F4914F6CDD1Du64;
+        let mut next = || {
+            seed = seed.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+            seed >> 33
+        };
+        let mut present: Vec<u64> = Vec::new();
+        for _ in 0..slots * 2 {
+            let slot = next() % slots;
+            let start = slot * 16 * PAGE;
+            if present.contains(&start) {
+                continue;
+            }
+            let len = 1 + slot % 7;
+            tree.insert(region(start, start + len * PAGE)).unwrap();
+            present.push(start);
+            check_max_gap(tree.root);
+        }
+        check_tree(&tree);
+
+        // 随机删除一半，每次删除后根节点与内部节点的max_gap都要正确
+        for _ in 0..present.len() / 2 {
+            let i = (next() as usize) % present.len();
+            let start = present.swap_remove(i);
+            assert!(tree.remove(start).is_some());
+            check_max_gap(tree.root);
+        }
+        check_tree(&tree);
+
+        // 根节点的max_gap即全树相邻区域的最大空隙
+        present.sort_unstable();
+        let expected = present
+            .windows(2)
+            .map(|w| w[1] - (w[0] + (1 + (w[0] / (16 * PAGE)) % 7) * PAGE))
+            .max()
+            .unwrap_or(0);
+        assert_eq!(node(tree.root).max_gap, expected);
+        clear(&mut tree);
+    }
+
+    #[test]
+    fn rejects_overlap() {
+        let _g = POOL_LOCK.lock().unwrap_or_else(|e| e.into_inner());
+        let mut tree = VmaTree::new();
+        tree.insert(region(10 * PAGE, 20 * PAGE)).unwrap();
+        assert!(tree.insert(region(15 * PAGE, 25 * PAGE)).is_err());
+        assert!(tree.insert(region(5 * PAGE, 11 * PAGE)).is_err());
+        assert!(tree.insert(region(20 * PAGE, 21 * PAGE)).is_ok());
+        clear(&mut tree);
+    }
+
+    #[test]
+    fn first_fit_returns_lowest_gap() {
+        let _g = POOL_LOCK.lock().unwrap_or_else(|e| e.into_inner());
+        let mut tree = VmaTree::new();
+
+        // 区域之间的空隙依次为：1页、3页、2页、5页、4页
+        let layout: [(u64, u64); 6] = [(0, 4), (5, 8), (11, 12), (14, 16), (21, 22), (26, 30)];
+        for &(s, e) in layout.iter().rev() {
+            tree.insert(region(s * PAGE, e * PAGE)).unwrap();
+        }
+        check_tree(&tree);
+
+        assert_eq!(tree.find_gap(PAGE, 0, 64 * PAGE), Some(4 * PAGE));
+        assert_eq!(tree.find_gap(2 * PAGE, 0, 64 * PAGE), Some(8 * PAGE));
+        assert_eq!(tree.find_gap(3 * PAGE, 0, 64 * PAGE), Some(8 * PAGE));
+        assert_eq!(tree.find_gap(4 * PAGE, 0, 64 * PAGE), Some(16 * PAGE));
+        assert_eq!(tree.find_gap(5 * PAGE, 0, 64 * PAGE), Some(16 * PAGE));
+        assert_eq!(tree.find_gap(6 * PAGE, 0, 64 * PAGE), Some(30 * PAGE));
+
+        // low落在区域内部时从该区域结束处开始
+        assert_eq!(tree.find_gap(PAGE, 6 * PAGE, 64 * PAGE), Some(8 * PAGE));
+        // 上界截断
+        assert_eq!(tree.find_gap(6 * PAGE, 0, 35 * PAGE), None);
+        assert_eq!(tree.find_gap(5 * PAGE, 0, 20 * PAGE), None);
+
+        // 删除后空隙合并，首次适配随之变化
+        tree.remove(5 * PAGE).unwrap();
+        check_tree(&tree);
+        assert_eq!(tree.find_gap(7 * PAGE, 0, 64 * PAGE), Some(4 * PAGE));
+
+        // 与暴力搜索比较
+        let mut regions: Vec<(u64, u64)> = Vec::new();
+        for &(s, e) in layout.iter() {
+            if s != 5 {
+                regions.push((s * PAGE, e * PAGE));
+            }
+        }
+        for pages in 1..12u64 {
+            let size = pages * PAGE;
+            let mut expected = None;
+            let mut prev = 0u64;
+            for &(s, e) in regions.iter() {
+                if s >= prev + size {
+                    expected = Some(prev);
+                    break;
+                }
+                prev = e;
+            }
+            if expected.is_none() && prev + size <= 64 * PAGE {
+                expected = Some(prev);
+            }
+            assert_eq!(tree.find_gap(size, 0, 64 * PAGE), expected, "size {} pages", pages);
+        }
+        clear(&mut tree);
+    }
+}
@@ -2,8 +2,10 @@
 // 管理虚拟地址空间的分配和映射
 
 use crate::arch::addr::VirtAddr;
-use crate::paging::{PageTableManager, PAGE_PRESENT, PAGE_WRITABLE};
+use crate::arch::addr::PhysAddr;
+use crate::paging::{PageTableManager, PAGE_PRESENT, PAGE_WRITABLE, PAGE_CACHE_UC, PAGE_CACHE_WC};
 use crate::lazy_buddy::PhysFrame;
+use crate::vma_tree::VmaTree;
 
 /// 虚拟内存区域类型
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -16,6 +18,8 @@ pub enum VmmRegionType {
     UserData,        // 用户数据段
     UserHeap,        // 用户堆
     UserStack,       // 用户栈
+    Mmio,            // 设备MMIO映射
+    GuardPage,       // 保护页(不映射)
 }
 
 /// 虚拟内存区域标志
@@ -24,6 +28,8 @@ pub struct VmmFlags {
     pub writable: bool,     // 可写
     pub user: bool,         // 用户可访问
     pub executable: bool,   // 可执行
+    pub write_combining: bool, // 写合并(帧缓冲)
+    pub uncached: bool,     // 不可缓存(MMIO寄存器)
 }
 
 impl VmmFlags {
@@ -32,6 +38,8 @@ impl VmmFlags {
             writable: false,
             user: false,
             executable: false,
+            write_combining: false,
+            uncached: false,
         }
     }
 
@@ -50,6 +58,18 @@ impl VmmFlags {
         self
     }
 
+    pub const fn write_combining(mut self) -> Self {
+        self.write_combining = true;
+        self.uncached = false;
+        self
+    }
+
+    pub const fn uncached(mut self) -> Self {
+        self.uncached = true;
+        self.write_combining = false;
+        self
+    }
+
     // 转换为页表标志位
     pub fn to_page_flags(&self) -> u64 {
         let mut flags = PAGE_PRESENT;
@@ -62,6 +82,11 @@ impl VmmFlags {
         if !self.executable {
             flags |= 1 << 63; // PAGE_NO_EXECUTE
         }
+        if self.uncached {
+            flags |= PAGE_CACHE_UC;
+        } else if self.write_combining {
+            flags |= PAGE_CACHE_WC;
+        }
         flags
     }
 }
@@ -76,7 +101,7 @@ pub struct VmmRegion {
 }
 
 impl VmmRegion {
-    pub fn new(start: VirtAddr, end: VirtAddr, region_type: VmmRegionType, flags: VmmFlags) -> Self {
+    pub const fn new(start: VirtAddr, end: VirtAddr, region_type: VmmRegionType, flags: VmmFlags) -> Self {
         Self {
             start,
             end,
@@ -85,6 +110,11 @@ impl VmmRegion {
         }
     }
 
+    // 空区域(节点池占位)
+    pub const fn empty() -> Self {
+        Self::new(VirtAddr::new(0), VirtAddr::new(0), VmmRegionType::KernelData, VmmFlags::new())
+    }
+
     pub fn size(&self) -> u64 {
         self.end.as_u64() - self.start.as_u64()
     }
@@ -100,25 +130,46 @@ impl VmmRegion {
 
 /// 虚拟内存管理器
 pub struct VirtualMemoryManager {
-    // 虚拟内存区域列表（最多支持32个区域）
-    regions: [Option<VmmRegion>; 32],
-    region_count: usize,
+    // 虚拟内存区域树（按起始地址排序）
+    regions: VmaTree,
 
     // 内核堆分配位置
     kernel_heap_start: VirtAddr,
     kernel_heap_current: VirtAddr,
     kernel_heap_end: VirtAddr,
+
+    // MMIO映射窗口分配位置
+    mmio_start: VirtAddr,
+    mmio_current: VirtAddr,
+    mmio_end: VirtAddr,
+
+    // MMIO窗口中已归还的地址段（低于mmio_current，按起始地址排序）
+    mmio_free: [MmioRange; MMIO_FREE_SLOTS],
+    mmio_free_count: usize,
+}
+
+/// MMIO窗口空闲段记录数上限，超出时归还的地址段不再复用
+const MMIO_FREE_SLOTS: usize = 32;
+
+#[derive(Debug, Clone, Copy)]
+struct MmioRange {
+    start: u64,
+    end: u64,
 }
 
 impl VirtualMemoryManager {
     /// 创建新的虚拟内存管理器
     pub const fn new() -> Self {
         Self {
-            regions: [None; 32],
-            region_count: 0,
+            regions: VmaTree::new(),
             kernel_heap_start: VirtAddr::new(0xFFFFFFFF90000000),  // 内核堆起始地址
             kernel_heap_current: VirtAddr::new(0xFFFFFFFF90000000),
             kernel_heap_end: VirtAddr::new(0xFFFFFFFFA0000000),    // 内核堆结束地址（256MB）
+            mmio_start: VirtAddr::new(0xFFFFFFFFA0000000),         // MMIO窗口起始地址
+            mmio_current: VirtAddr::new(0xFFFFFFFFA0000000),
+            mmio_end: VirtAddr::new(0xFFFFFFFFB0000000),           // MMIO窗口结束地址（256MB）
+            mmio_free: [MmioRange { start: 0, end: 0 }; MMIO_FREE_SLOTS],
+            mmio_free_count: 0,
         }
     }
 
@@ -139,39 +190,43 @@ impl VirtualMemoryManager {
             VmmFlags::new().writable(),
         ))?;
 
+        self.add_region(VmmRegion::new(
+            VirtAddr::new(0xFFFFFFFFA0000000),  // MMIO窗口起始
+            VirtAddr::new(0xFFFFFFFFB0000000),  // MMIO窗口结束
+            VmmRegionType::Mmio,
+            VmmFlags::new().writable().uncached(),
+        ))?;
+
         Ok(())
     }
 
-    /// 添加虚拟内存区域
+    /// 添加虚拟内存区域（与现有区域重叠时失败）
     pub fn add_region(&mut self, region: VmmRegion) -> Result<(), &'static str> {
-        if self.region_count >= self.regions.len() {
-            return Err("Too many regions");
-        }
-
-        // 检查是否与现有区域重叠
-        for i in 0..self.region_count {
-            if let Some(existing) = &self.regions[i] {
-                if existing.overlaps(&region) {
-                    return Err("Region overlaps with existing region");
-                }
-            }
-        }
+        self.regions.insert(region)
+    }
 
-        self.regions[self.region_count] = Some(region);
-        self.region_count += 1;
-        Ok(())
+    /// 删除起始地址为start的区域
+    pub fn remove_region(&mut self, start: VirtAddr) -> Option<VmmRegion> {
+        self.regions.remove(start.as_u64())
     }
 
     /// 查找包含指定地址的区域
     pub fn find_region(&self, addr: VirtAddr) -> Option<&VmmRegion> {
-        for i in 0..self.region_count {
-            if let Some(region) = &self.regions[i] {
-                if region.contains(addr) {
-                    return Some(region);
-                }
-            }
-        }
-        None
+        self.regions.find(addr.as_u64())
+    }
+
+    /// 在[low, high)内查找能容纳size字节的空闲虚拟地址（不在任何区域内）
+    pub fn find_free_range(&self, size: u64, low: VirtAddr, high: VirtAddr) -> Option<VirtAddr> {
+        let aligned_size = (size + 0xFFF) & !0xFFF;
+        let low = (low.as_u64() + 0xFFF) & !0xFFF;
+        self.regions
+            .find_gap(aligned_size, low, high.as_u64())
+            .map(VirtAddr::new)
+    }
+
+    /// 区域数量
+    pub fn region_count(&self) -> usize {
+        self.regions.len()
     }
 
     /// 分配虚拟内存区域（从内核堆）
@@ -224,18 +279,54 @@ impl VirtualMemoryManager {
     }
 
     /// 取消映射虚拟内存区域
-    pub fn unmap_region(
+    /// 不拥有数据页面（可能是MMIO或共享页面），只有变空的页表页面交给free_frame回收
+    pub fn unmap_region<D>(
+        &self,
+        page_table: &mut PageTableManager,
+        region: &VmmRegion,
+        free_frame: D,
+    ) -> Result<(), &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
+        self.unmap_region_inner(page_table, region, free_frame, false)
+    }
+
+    /// 取消映射虚拟内存区域，并把数据页面一并交给free_frame释放
+    /// 仅用于由map_region分配物理页面的区域
+    pub fn unmap_region_free<D>(
         &self,
         page_table: &mut PageTableManager,
         region: &VmmRegion,
-    ) -> Result<(), &'static str> {
+        free_frame: D,
+    ) -> Result<(), &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
+        self.unmap_region_inner(page_table, region, free_frame, true)
+    }
+
+    fn unmap_region_inner<D>(
+        &self,
+        page_table: &mut PageTableManager,
+        region: &VmmRegion,
+        mut free_frame: D,
+        free_data: bool,
+    ) -> Result<(), &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
         let page_size = 4096u64;
         let start_page = region.start.as_u64() & !0xFFF;
         let end_page = (region.end.as_u64() + 0xFFF) & !0xFFF;
 
         for virt_addr in (start_page..end_page).step_by(page_size as usize) {
             // 取消映射页面（忽略错误，页面可能未映射）
-            let _ = page_table.unmap_page(VirtAddr::new(virt_addr));
+            if let Ok(phys) = page_table.unmap_page_and_reclaim(VirtAddr::new(virt_addr), &mut free_frame) {
+                if free_data {
+                    free_frame(PhysFrame::from_start_address(phys));
+                }
+            }
         }
 
         Ok(())
@@ -270,6 +361,174 @@ impl VirtualMemoryManager {
         Ok(virt_start)
     }
 
+    /// 将物理MMIO区域映射到MMIO窗口
+    /// 返回的虚拟地址保留物理地址的页内偏移
+    pub fn map_mmio<F, D>(
+        &mut self,
+        page_table: &mut PageTableManager,
+        phys: PhysAddr,
+        size: u64,
+        flags: VmmFlags,
+        mut alloc_frame: F,
+        mut free_frame: D,
+    ) -> Result<VirtAddr, &'static str>
+    where
+        F: FnMut() -> Option<PhysFrame>,
+        D: FnMut(PhysFrame),
+    {
+        if size == 0 {
+            return Err("Invalid MMIO size");
+        }
+
+        let page_offset = phys.as_u64() & 0xFFF;
+        let phys_start = phys.as_u64() & !0xFFF;
+        let aligned_size = (page_offset + size + 0xFFF) & !0xFFF;
+
+        // 优先复用已归还的地址段（首次适配），否则从窗口顶端分配
+        let slot = self.mmio_free[..self.mmio_free_count]
+            .iter()
+            .position(|range| range.end - range.start >= aligned_size);
+        let virt_start = match slot {
+            Some(i) => self.mmio_free[i].start,
+            None => {
+                if self.mmio_current.as_u64() + aligned_size > self.mmio_end.as_u64() {
+                    return Err("MMIO window exhausted");
+                }
+                self.mmio_current.as_u64()
+            }
+        };
+
+        let page_flags = flags.to_page_flags();
+        let mut offset = 0u64;
+        while offset < aligned_size {
+            if let Err(e) = page_table.map_page(
+                VirtAddr::new(virt_start + offset),
+                PhysAddr::new(phys_start + offset),
+                page_flags,
+                &mut alloc_frame,
+            ) {
+                // 撤销已映射的页并回收变空的页表，地址段尚未从窗口取出
+                // 物理页属于设备，只取消映射不归还
+                let mut undo = 0u64;
+                while undo < offset {
+                    let _ = page_table.unmap_page_and_reclaim(VirtAddr::new(virt_start + undo), &mut free_frame);
+                    undo += 4096;
+                }
+                return Err(e);
+            }
+            offset += 4096;
+        }
+
+        match slot {
+            Some(i) => {
+                self.mmio_free[i].start += aligned_size;
+                if self.mmio_free[i].start == self.mmio_free[i].end {
+                    self.mmio_free_remove(i);
+                }
+            }
+            None => self.mmio_current = VirtAddr::new(virt_start + aligned_size),
+        }
+        Ok(VirtAddr::new(virt_start + page_offset))
+    }
+
+    /// 取消map_mmio建立的映射，并把地址段归还MMIO窗口
+    /// virt与size须与映射时一致；物理页属于设备不归还，变空的页表交给free_frame回收
+    pub fn unmap_mmio<D>(
+        &mut self,
+        page_table: &mut PageTableManager,
+        virt: VirtAddr,
+        size: u64,
+        mut free_frame: D,
+    ) -> Result<(), &'static str>
+    where
+        D: FnMut(PhysFrame),
+    {
+        if size == 0 {
+            return Err("Invalid MMIO size");
+        }
+
+        let page_offset = virt.as_u64() & 0xFFF;
+        let start = virt.as_u64() & !0xFFF;
+        let end = start + ((page_offset + size + 0xFFF) & !0xFFF);
+        if start < self.mmio_start.as_u64() || end > self.mmio_current.as_u64() {
+            return Err("Address not in MMIO window");
+        }
+        if self.mmio_free[..self.mmio_free_count]
+            .iter()
+            .any(|range| start < range.end && range.start < end)
+        {
+            return Err("MMIO range already unmapped");
+        }
+
+        let mut addr = start;
+        while addr < end {
+            let _ = page_table.unmap_page_and_reclaim(VirtAddr::new(addr), &mut free_frame);
+            addr += 4096;
+        }
+
+        self.mmio_release(start, end);
+        Ok(())
+    }
+
+    /// 把[start, end)归还MMIO窗口，与相邻空闲段合并
+    fn mmio_release(&mut self, start: u64, end: u64) {
+        let mut start = start;
+        let mut end = end;
+
+        // 合并前后相邻的空闲段
+        let mut i = 0;
+        while i < self.mmio_free_count {
+            let range = self.mmio_free[i];
+            if range.end == start || range.start == end {
+                start = start.min(range.start);
+                end = end.max(range.end);
+                self.mmio_free_remove(i);
+            } else {
+                i += 1;
+            }
+        }
+
+        // 紧邻窗口顶端时直接回退分配位置
+        if end == self.mmio_current.as_u64() {
+            self.mmio_current = VirtAddr::new(start);
+            return;
+        }
+
+        if self.mmio_free_count == MMIO_FREE_SLOTS {
+            // 记录已满，这段地址不再复用（映射已撤销，只损失窗口空间）
+            return;
+        }
+        let pos = self.mmio_free[..self.mmio_free_count]
+            .iter()
+            .position(|range| range.start > start)
+            .unwrap_or(self.mmio_free_count);
+        let mut j = self.mmio_free_count;
+        while j > pos {
+            self.mmio_free[j] = self.mmio_free[j - 1];
+            j -= 1;
+        }
+        self.mmio_free[pos] = MmioRange { start, end };
+        self.mmio_free_count += 1;
+    }
+
+    fn mmio_free_remove(&mut self, index: usize) {
+        for j in index..self.mmio_free_count - 1 {
+            self.mmio_free[j] = self.mmio_free[j + 1];
+        }
+        self.mmio_free_count -= 1;
+    }
+
+    /// 获取MMIO窗口使用情况
+    pub fn mmio_usage(&self) -> (u64, u64) {
+        let released: u64 = self.mmio_free[..self.mmio_free_count]
+            .iter()
+            .map(|range| range.end - range.start)
+            .sum();
+        let used = self.mmio_current.as_u64() - self.mmio_start.as_u64() - released;
+        let total = self.mmio_end.as_u64() - self.mmio_start.as_u64();
+        (used, total)
+    }
+
     /// 获取内核堆使用情况
     pub fn kernel_heap_usage(&self) -> (u64, u64) {
         let used = self.kernel_heap_current.as_u64() - self.kernel_heap_start.as_u64();
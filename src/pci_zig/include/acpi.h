@@ -68,5 +68,155 @@ typedef struct {
     int      enabled;   // 是否启用
 } mcfg_info_t;
 
+// MADT（多APIC描述表，签名"APIC"）
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t          lapic_address;  // Local APIC物理地址
+    uint32_t          flags;          // bit0: 存在兼容8259 PIC
+    uint8_t           entries[];      // 变长条目
+} __attribute__((packed)) madt_t;
+
+// MADT条目类型
+#define MADT_TYPE_LAPIC            0  // 处理器Local APIC
+#define MADT_TYPE_IOAPIC           1  // I/O APIC
+#define MADT_TYPE_ISO              2  // 中断源覆盖
+#define MADT_TYPE_LAPIC_NMI        4  // Local APIC NMI
+#define MADT_TYPE_LAPIC_OVERRIDE   5  // Local APIC 64位地址覆盖
+#define MADT_TYPE_X2APIC           9  // 处理器Local x2APIC（APIC ID超过255时使用）
+#define MADT_TYPE_X2APIC_NMI      10  // Local x2APIC NMI
+
+// MADT条目公共头
+typedef struct {
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed)) madt_entry_header_t;
+
+// 处理器Local APIC
+typedef struct {
+    madt_entry_header_t header;
+    uint8_t  acpi_processor_id;
+    uint8_t  apic_id;
+    uint32_t flags;              // bit0: 已启用, bit1: 可上线
+} __attribute__((packed)) madt_lapic_t;
+
+// I/O APIC
+typedef struct {
+    madt_entry_header_t header;
+    uint8_t  ioapic_id;
+    uint8_t  reserved;
+    uint32_t ioapic_address;     // 物理地址
+    uint32_t gsi_base;           // 起始全局系统中断号
+} __attribute__((packed)) madt_ioapic_t;
+
+// 中断源覆盖（ISA IRQ -> GSI）
+typedef struct {
+    madt_entry_header_t header;
+    uint8_t  bus;                // 总是0（ISA）
+    uint8_t  source;             // ISA IRQ
+    uint32_t gsi;                // 全局系统中断号
+    uint16_t flags;              // 极性(bit0-1)和触发方式(bit2-3)
+} __attribute__((packed)) madt_iso_t;
+
+// Local APIC NMI
+typedef struct {
+    madt_entry_header_t header;
+    uint8_t  acpi_processor_id;  // 0xFF表示所有处理器
+    uint16_t flags;
+    uint8_t  lint;               // LINT0或LINT1
+} __attribute__((packed)) madt_lapic_nmi_t;
+
+// 处理器Local x2APIC
+typedef struct {
+    madt_entry_header_t header;
+    uint16_t reserved;
+    uint32_t x2apic_id;
+    uint32_t flags;              // 同madt_lapic_t
+    uint32_t acpi_processor_uid;
+} __attribute__((packed)) madt_x2apic_t;
+
+// Local x2APIC NMI
+typedef struct {
+    madt_entry_header_t header;
+    uint16_t flags;
+    uint32_t acpi_processor_uid; // 0xFFFFFFFF表示所有处理器
+    uint8_t  lint;
+    uint8_t  reserved[3];
+} __attribute__((packed)) madt_x2apic_nmi_t;
+
+// Local APIC地址覆盖
+typedef struct {
+    madt_entry_header_t header;
+    uint16_t reserved;
+    uint64_t lapic_address;
+} __attribute__((packed)) madt_lapic_override_t;
+
+// MPS INTI标志（ISO和NMI条目共用）
+#define MADT_POLARITY_MASK     0x03
+#define MADT_POLARITY_LOW      0x03
+#define MADT_TRIGGER_MASK      0x0C
+#define MADT_TRIGGER_LEVEL     0x0C
+
+// ACPI通用地址结构
+typedef struct {
+    uint8_t  address_space;      // 0=系统内存, 1=系统I/O
+    uint8_t  bit_width;
+    uint8_t  bit_offset;
+    uint8_t  access_size;
+    uint64_t address;
+} __attribute__((packed)) acpi_gas_t;
+
+// HPET表（签名"HPET"）
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t          event_timer_block_id;  // 硬件ID（与通用能力寄存器低32位相同）
+    acpi_gas_t        address;               // 寄存器块基址
+    uint8_t           hpet_number;           // HPET序号
+    uint16_t          min_tick;              // 周期模式下不丢中断的最小间隔（计数）
+    uint8_t           page_protection;
+} __attribute__((packed)) hpet_table_t;
+
+// FADT（签名"FACP"），只列出到世纪寄存器为止的ACPI 1.0字段
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t firmware_ctrl;
+    uint32_t dsdt;
+    uint8_t  reserved;
+    uint8_t  preferred_pm_profile;
+    uint16_t sci_int;
+    uint32_t smi_cmd;
+    uint8_t  acpi_enable;
+    uint8_t  acpi_disable;
+    uint8_t  s4bios_req;
+    uint8_t  pstate_cnt;
+    uint32_t pm1a_evt_blk;
+    uint32_t pm1b_evt_blk;
+    uint32_t pm1a_cnt_blk;
+    uint32_t pm1b_cnt_blk;
+    uint32_t pm2_cnt_blk;
+    uint32_t pm_tmr_blk;
+    uint32_t gpe0_blk;
+    uint32_t gpe1_blk;
+    uint8_t  pm1_evt_len;
+    uint8_t  pm1_cnt_len;
+    uint8_t  pm2_cnt_len;
+    uint8_t  pm_tmr_len;
+    uint8_t  gpe0_blk_len;
+    uint8_t  gpe1_blk_len;
+    uint8_t  gpe1_base;
+    uint8_t  cst_cnt;
+    uint16_t p_lvl2_lat;
+    uint16_t p_lvl3_lat;
+    uint16_t flush_size;
+    uint16_t flush_stride;
+    uint8_t  duty_offset;
+    uint8_t  duty_width;
+    uint8_t  day_alrm;           // RTC日报警寄存器索引，0表示不支持
+    uint8_t  mon_alrm;           // RTC月报警寄存器索引，0表示不支持
+    uint8_t  century;            // RTC世纪寄存器索引，0表示不支持
+} __attribute__((packed)) fadt_t;
+
+// 按4字节签名查找ACPI表（Zig实现），未找到返回NULL
+acpi_sdt_header_t* acpi_find_table(const char* signature);
+
 #endif // PCI_ACPI_H
 
@@ -49,6 +49,19 @@ typedef struct {
     uint8_t  prefetchable;   // 是否可预取（仅内存BAR）
 } pci_bar_info_t;
 
+// MSI/MSI-X能力信息
+typedef struct {
+    uint8_t  msi_offset;         // MSI Capability偏移，0表示不支持
+    uint8_t  msi_max_vectors;    // MSI支持的向量数（2的幂）
+    uint8_t  msi_64bit;          // MSI支持64位地址
+    uint8_t  msix_offset;        // MSI-X Capability偏移，0表示不支持
+    uint16_t msix_table_size;    // MSI-X表项数
+    uint8_t  msix_table_bar;     // MSI-X表所在BAR
+    uint8_t  msix_pba_bar;       // PBA所在BAR
+    uint32_t msix_table_offset;  // MSI-X表在BAR内的偏移
+    uint32_t msix_pba_offset;    // PBA在BAR内的偏移
+} pci_msi_info_t;
+
 // 初始化PCI驱动并扫描所有设备
 void pci_init(void);
 
@@ -125,6 +138,18 @@ size_t pci_find_by_class_and_subclass(uint8_t class_code, uint8_t subclass, size
 // 返回: 找到的设备数量
 size_t pci_find_by_bus(uint8_t bus, size_t* out_indices, size_t max_count);
 
+// 获取设备的MSI/MSI-X能力，两者都不支持时返回false
+bool pci_get_msi_info(size_t device_index, pci_msi_info_t* out_info);
+
+// 配置并启用MSI：2^log2_count个连续向量，同时开启总线主控并关闭INTx
+bool pci_msi_enable(size_t device_index, uint64_t msg_addr, uint16_t msg_data, uint8_t log2_count);
+
+// 关闭MSI并恢复INTx
+void pci_msi_disable(size_t device_index);
+
+// 设置MSI-X启用位和全局屏蔽位（表项需调用者映射BAR后写入）
+bool pci_msix_set_control(size_t device_index, bool enable, bool function_mask);
+
 #ifdef __cplusplus
 }
 #endif
@@ -298,6 +298,11 @@ pub fn find_mcfg() ?*MCFG {
     return @as(*MCFG, @ptrCast(header));
 }
 
+/// C接口：按4字节签名查找ACPI表（如MADT的"APIC"），返回HHDM虚拟地址
+export fn acpi_find_table(signature: [*]const u8) ?*ACPISDTHeader {
+    return find_table(signature[0..4]);
+}
+
 /// 获取MCFG条目数量
 pub fn get_mcfg_entry_count(mcfg: *MCFG) u32 {
     const entries_size = mcfg.header.length - @sizeOf(MCFG);
@@ -0,0 +1,84 @@
+// 锁原语的Zig绑定
+// 实现在C侧(kernel/lib/spinlock.c)，结构布局与include/kernel/spinlock.h一致
+
+// 每个锁的统计记录，name为lockstat命令显示的名字
+pub const LockStat = extern struct {
+    name: [*:0]const u8,
+    next: ?*LockStat = null,
+    registered: u32 = 0,
+    reserved: u32 = 0,
+    acquisitions: u64 = 0,
+    contentions: u64 = 0,
+    wait_cycles: u64 = 0,
+    wait_max: u64 = 0,
+    hold_cycles: u64 = 0,
+    hold_max: u64 = 0,
+    acquired_at: u64 = 0,
+};
+
+// 自旋锁：_irqsave版本返回保存的RFLAGS，解锁时传回
+pub const SpinLock = extern struct {
+    locked: u32 = 0,
+    reserved: u32 = 0,
+    stat: ?*LockStat = null,
+
+    pub fn lock(self: *SpinLock) void {
+        spin_lock(self);
+    }
+
+    pub fn unlock(self: *SpinLock) void {
+        spin_unlock(self);
+    }
+
+    pub fn lock_irqsave(self: *SpinLock) u64 {
+        return spin_lock_irqsave(self);
+    }
+
+    pub fn unlock_irqrestore(self: *SpinLock, flags: u64) void {
+        spin_unlock_irqrestore(self, flags);
+    }
+};
+
+// 票据锁：按到达顺序获得
+pub const TicketLock = extern struct {
+    next: u32 = 0,
+    owner: u32 = 0,
+    stat: ?*LockStat = null,
+
+    pub fn lock_irqsave(self: *TicketLock) u64 {
+        return ticket_lock_irqsave(self);
+    }
+
+    pub fn unlock_irqrestore(self: *TicketLock, flags: u64) void {
+        ticket_unlock_irqrestore(self, flags);
+    }
+};
+
+// MCS锁：节点由调用者提供（通常在栈上），解锁前不能移动
+pub const McsNode = extern struct {
+    next: ?*McsNode = null,
+    locked: u32 = 0,
+    reserved: u32 = 0,
+};
+
+pub const McsLock = extern struct {
+    tail: ?*McsNode = null,
+    stat: ?*LockStat = null,
+
+    pub fn lock_irqsave(self: *McsLock, node: *McsNode) u64 {
+        return mcs_lock_irqsave(self, node);
+    }
+
+    pub fn unlock_irqrestore(self: *McsLock, node: *McsNode, flags: u64) void {
+        mcs_unlock_irqrestore(self, node, flags);
+    }
+};
+
+extern fn spin_lock(lock_ptr: *SpinLock) void;
+extern fn spin_unlock(lock_ptr: *SpinLock) void;
+extern fn spin_lock_irqsave(lock_ptr: *SpinLock) u64;
+extern fn spin_unlock_irqrestore(lock_ptr: *SpinLock, flags: u64) void;
+extern fn ticket_lock_irqsave(lock_ptr: *TicketLock) u64;
+extern fn ticket_unlock_irqrestore(lock_ptr: *TicketLock, flags: u64) void;
+extern fn mcs_lock_irqsave(lock_ptr: *McsLock, node: *McsNode) u64;
+extern fn mcs_unlock_irqrestore(lock_ptr: *McsLock, node: *McsNode, flags: u64) void;
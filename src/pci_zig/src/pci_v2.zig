@@ -3,6 +3,7 @@
 
 const std = @import("std");
 const acpi = @import("acpi.zig");
+const lock = @import("lock.zig");
 
 // ============================================================================
 // 常量定义
@@ -156,6 +157,10 @@ inline fn inl(port: u16) u32 {
 // PCI配置空间访问 - Legacy I/O模式
 // ============================================================================
 
+// 地址端口和数据端口分两次访问，中间被打断（中断或其他CPU）会读写到别的设备
+var pci_config_lockstat = lock.LockStat{ .name = "pci_config_lock" };
+var pci_config_lock = lock.SpinLock{ .stat = &pci_config_lockstat };
+
 fn pci_legacy_read_dword(addr: PCIAddress, offset: u8) u32 {
     const config_addr: u32 =
         (@as(u32, 1) << 31) |
@@ -163,6 +168,8 @@ fn pci_legacy_read_dword(addr: PCIAddress, offset: u8) u32 {
         (@as(u32, addr.device) << 11) |
         (@as(u32, addr.function) << 8) |
         (@as(u32, offset & 0xFC));
+    const flags = pci_config_lock.lock_irqsave();
+    defer pci_config_lock.unlock_irqrestore(flags);
     outl(PCI_COMMAND_PORT, config_addr);
     return inl(PCI_DATA_PORT);
 }
@@ -174,6 +181,8 @@ fn pci_legacy_write_dword(addr: PCIAddress, offset: u8, value: u32) void {
         (@as(u32, addr.device) << 11) |
         (@as(u32, addr.function) << 8) |
         (@as(u32, offset & 0xFC));
+    const flags = pci_config_lock.lock_irqsave();
+    defer pci_config_lock.unlock_irqrestore(flags);
     outl(PCI_COMMAND_PORT, config_addr);
     outl(PCI_DATA_PORT, value);
 }
@@ -410,34 +419,103 @@ pub fn read_msi_capability(addr: PCIAddress, cap_offset: u8) ?MSICapability {
 
 /// 启用MSI
 pub fn enable_msi(addr: PCIAddress, msi: *MSICapability, vector: u8) void {
+    // 目标: 0xFEE00000 + (APIC ID << 12)，单消息
+    configure_msi(addr, msi, 0xFEE00000, @as(u16, vector), 0);
+}
+
+/// 写入MSI地址/数据并启用，log2_count为启用的消息数（2^N个连续向量）
+pub fn configure_msi(addr: PCIAddress, msi: *MSICapability, msg_addr: u64, msg_data: u16, log2_count: u8) void {
+    // 先关闭MSI再改写消息
+    var control = pci_config_read_word(addr, msi.offset + 2);
+    control &= ~MSI_CONTROL_ENABLE;
+    pci_config_write_word(addr, msi.offset + 2, control);
+
     // 设置Message Address寄存器
     const msg_addr_offset = msi.offset + 4;
+    pci_config_write_dword(addr, msg_addr_offset, @as(u32, @truncate(msg_addr)));
     if (msi.is_64bit) {
-        // 64位地址: 0xFEE00000 + (APIC ID << 12)
-        const addr_low: u32 = 0xFEE00000;
-        const addr_high: u32 = 0;
-        pci_config_write_dword(addr, msg_addr_offset, addr_low);
-        pci_config_write_dword(addr, msg_addr_offset + 4, addr_high);
+        pci_config_write_dword(addr, msg_addr_offset + 4, @as(u32, @truncate(msg_addr >> 32)));
         
-        // Message Data寄存器在64位BAR后面 (offset + 12)
-        const msg_data_offset = msg_addr_offset + 8;
-        pci_config_write_word(addr, msg_data_offset, @as(u16, vector));
+        // Message Data寄存器在64位地址后面 (offset + 12)
+        pci_config_write_word(addr, msg_addr_offset + 8, msg_data);
     } else {
-        // 32位地址
-        pci_config_write_dword(addr, msg_addr_offset, 0xFEE00000);
-        
-        // Message Data寄存器在32位BAR后面 (offset + 8)
-        const msg_data_offset = msg_addr_offset + 4;
-        pci_config_write_word(addr, msg_data_offset, @as(u16, vector));
+        // Message Data寄存器在32位地址后面 (offset + 8)
+        pci_config_write_word(addr, msg_addr_offset + 4, msg_data);
     }
     
-    // 启用MSI
-    var control = msi.control;
+    // 设置启用的消息数并启用MSI
+    control &= ~MSI_CONTROL_MULTI_MSG_ENABLED;
+    control |= (@as(u16, log2_count & 0x7) << 4) & MSI_CONTROL_MULTI_MSG_ENABLED;
     control |= MSI_CONTROL_ENABLE;
     pci_config_write_word(addr, msi.offset + 2, control);
+    msi.control = control;
     msi.enabled = true;
 }
 
+// ============================================================================
+// MSI-X支持
+// ============================================================================
+
+// MSI-X Message Control寄存器位定义
+pub const MSIX_CONTROL_TABLE_SIZE: u16 = 0x07FF;     // 表项数-1
+pub const MSIX_CONTROL_FUNCTION_MASK: u16 = 0x4000;  // 屏蔽所有向量
+pub const MSIX_CONTROL_ENABLE: u16 = 0x8000;         // MSI-X启用
+
+// Table/PBA偏移寄存器：低3位是BIR（BAR索引）
+pub const MSIX_BIR_MASK: u32 = 0x7;
+
+// 命令寄存器位定义
+pub const PCI_COMMAND_MEMORY: u16 = 0x0002;
+pub const PCI_COMMAND_BUS_MASTER: u16 = 0x0004;
+pub const PCI_COMMAND_INTX_DISABLE: u16 = 0x0400;
+
+pub const MSIXCapability = struct {
+    offset: u8,                 // MSI-X Capability在配置空间的偏移
+    table_size: u16,            // 表项数
+    table_bar: u8,              // 表所在BAR
+    table_offset: u32,          // 表在BAR内的偏移
+    pba_bar: u8,                // PBA所在BAR
+    pba_offset: u32,            // PBA在BAR内的偏移
+};
+
+/// 读取MSI-X Capability信息
+pub fn read_msix_capability(addr: PCIAddress, cap_offset: u8) MSIXCapability {
+    const control = pci_config_read_word(addr, cap_offset + 2);
+    const table = pci_config_read_dword(addr, cap_offset + 4);
+    const pba = pci_config_read_dword(addr, cap_offset + 8);
+    
+    return MSIXCapability{
+        .offset = cap_offset,
+        .table_size = (control & MSIX_CONTROL_TABLE_SIZE) + 1,
+        .table_bar = @as(u8, @truncate(table & MSIX_BIR_MASK)),
+        .table_offset = table & ~MSIX_BIR_MASK,
+        .pba_bar = @as(u8, @truncate(pba & MSIX_BIR_MASK)),
+        .pba_offset = pba & ~MSIX_BIR_MASK,
+    };
+}
+
+/// 查找指定ID的Capability偏移
+fn find_capability_offset(addr: PCIAddress, cap_id: u8) ?u8 {
+    const caps = scan_capabilities(addr);
+    for (caps.capabilities) |cap_opt| {
+        if (cap_opt) |cap| {
+            if (cap.id == cap_id) return cap.offset;
+        }
+    }
+    return null;
+}
+
+/// 切换到消息中断时启用总线主控并关闭INTx
+fn prepare_message_interrupts(addr: PCIAddress, use_msi: bool) void {
+    var command = pci_config_read_word(addr, PCI_CONF_COMMAND);
+    if (use_msi) {
+        command |= PCI_COMMAND_BUS_MASTER | PCI_COMMAND_MEMORY | PCI_COMMAND_INTX_DISABLE;
+    } else {
+        command &= ~PCI_COMMAND_INTX_DISABLE;
+    }
+    pci_config_write_word(addr, PCI_CONF_COMMAND, command);
+}
+
 // ============================================================================
 // 扫描设备的Capability列表
 // ============================================================================
@@ -1046,6 +1124,89 @@ export fn pci_get_interrupt_info(device_index: usize, out_line: *u8, out_pin: *u
     return true;
 }
 
+// C结构体定义：MSI/MSI-X信息（与C头文件对应）
+pub const PCI_MSI_INFO_C = extern struct {
+    msi_offset: u8,          // MSI Capability偏移，0表示不支持
+    msi_max_vectors: u8,     // 支持的向量数（2的幂）
+    msi_64bit: u8,
+    msix_offset: u8,         // MSI-X Capability偏移，0表示不支持
+    msix_table_size: u16,    // MSI-X表项数
+    msix_table_bar: u8,
+    msix_pba_bar: u8,
+    msix_table_offset: u32,
+    msix_pba_offset: u32,
+};
+
+/// 获取设备的MSI/MSI-X能力
+export fn pci_get_msi_info(device_index: usize, out_info: *PCI_MSI_INFO_C) bool {
+    if (device_index >= device_count) return false;
+    
+    const addr = device_list[device_index].address;
+    out_info.* = std.mem.zeroes(PCI_MSI_INFO_C);
+    
+    if (find_capability_offset(addr, CAP_ID_MSI)) |offset| {
+        if (read_msi_capability(addr, offset)) |msi| {
+            out_info.msi_offset = offset;
+            out_info.msi_max_vectors = @as(u8, 1) << @as(u3, @truncate(msi.multiple_messages));
+            out_info.msi_64bit = if (msi.is_64bit) 1 else 0;
+        }
+    }
+    
+    if (find_capability_offset(addr, CAP_ID_MSIX)) |offset| {
+        const msix = read_msix_capability(addr, offset);
+        out_info.msix_offset = offset;
+        out_info.msix_table_size = msix.table_size;
+        out_info.msix_table_bar = msix.table_bar;
+        out_info.msix_table_offset = msix.table_offset;
+        out_info.msix_pba_bar = msix.pba_bar;
+        out_info.msix_pba_offset = msix.pba_offset;
+    }
+    
+    return out_info.msi_offset != 0 or out_info.msix_offset != 0;
+}
+
+/// 配置并启用MSI（2^log2_count个连续向量，数据低位由设备填入消息号）
+export fn pci_msi_enable(device_index: usize, msg_addr: u64, msg_data: u16, log2_count: u8) bool {
+    if (device_index >= device_count) return false;
+    
+    const addr = device_list[device_index].address;
+    const offset = find_capability_offset(addr, CAP_ID_MSI) orelse return false;
+    var msi = read_msi_capability(addr, offset) orelse return false;
+    if (log2_count > msi.multiple_messages) return false;
+    
+    prepare_message_interrupts(addr, true);
+    configure_msi(addr, &msi, msg_addr, msg_data, log2_count);
+    return true;
+}
+
+/// 关闭MSI并恢复INTx
+export fn pci_msi_disable(device_index: usize) void {
+    if (device_index >= device_count) return;
+    
+    const addr = device_list[device_index].address;
+    const offset = find_capability_offset(addr, CAP_ID_MSI) orelse return;
+    const control = pci_config_read_word(addr, offset + 2);
+    pci_config_write_word(addr, offset + 2, control & ~MSI_CONTROL_ENABLE);
+    prepare_message_interrupts(addr, false);
+}
+
+/// 设置MSI-X启用位和全局屏蔽位（表项由调用者通过映射的BAR写入）
+export fn pci_msix_set_control(device_index: usize, enable: bool, function_mask: bool) bool {
+    if (device_index >= device_count) return false;
+    
+    const addr = device_list[device_index].address;
+    const offset = find_capability_offset(addr, CAP_ID_MSIX) orelse return false;
+    var control = pci_config_read_word(addr, offset + 2);
+    
+    control &= ~(MSIX_CONTROL_ENABLE | MSIX_CONTROL_FUNCTION_MASK);
+    if (enable) control |= MSIX_CONTROL_ENABLE;
+    if (function_mask) control |= MSIX_CONTROL_FUNCTION_MASK;
+    
+    prepare_message_interrupts(addr, enable);
+    pci_config_write_word(addr, offset + 2, control);
+    return true;
+}
+
 // ============================================================================
 // 设备过滤和查询API
 // ============================================================================